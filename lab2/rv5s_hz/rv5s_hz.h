@@ -30,6 +30,7 @@
 #include "rv5s_hz_memwb.h"
 
 // Forwarding & Hazard detection unit
+#include "rv5s_hz_cachestall.h"
 #include "rv5s_hz_hazardunit.h"
 
 namespace vsrtl {
@@ -191,6 +192,13 @@ public:
         exmem_reg->mem_op_out >> data_mem->op;
         data_mem->mem->setMemory(m_memory);
 
+        // -----------------------------------------------------------------------
+        // Cache stalls
+        instr_mem->data_out >> icache_stall->mem_data;
+        0 >> icache_stall->mem_invalid;
+        data_mem->data_out >> dcache_stall->mem_data;
+        data_mem->data_invalid >> dcache_stall->mem_invalid;
+
         // -----------------------------------------------------------------------
         // Ecall checker
         idex_reg->opcode_out >> ecallChecker->opcode;
@@ -270,7 +278,7 @@ public:
         // -----------------------------------------------------------------------
         // MEM/WB
         0 >> memwb_reg->clear;  // a more complete solution is to control all clear/enable signals by hzunit
-        data_mem->data_invalid >> *memwb_stalled_or->in[0];
+        dcache_stall->wait >> *memwb_stalled_or->in[0];
         exmem_reg->stalled_out >> *memwb_stalled_or->in[1];
         memwb_stalled_or->out >> memwb_reg->stalled_in;
         hzunit->hazardMEMWBEnable >> memwb_reg->enable;
@@ -300,7 +308,8 @@ public:
         memwb_reg->reg_do_write_out >> hzunit->wb_do_reg_write;
 
         idex_reg->opcode_out >> hzunit->opcode;
-        data_mem->data_invalid >> hzunit->mem_wait;
+        dcache_stall->wait >> hzunit->mem_wait;
+        icache_stall->wait >> hzunit->fetch_wait;
         alu->data_invalid >> hzunit->alu_wait;
 
         control->alu_op2_ctrl >> hzunit->id_alu_op_ctrl_2;
@@ -373,6 +382,8 @@ public:
 
     // hazard detection units
     SUBCOMPONENT(hzunit, HZ_HazardUnit);
+    SUBCOMPONENT(icache_stall, HZ_CacheStall);  // icache_stall: holds the IF stage for the instruction cache latency.
+    SUBCOMPONENT(dcache_stall, HZ_CacheStall);  // dcache_stall: holds the MEM stage for the data cache latency.
 
     // Gates
     /*
@@ -591,6 +602,8 @@ public:
         m_syscallExitCycle = -1;
         branch_predictor->reset();
         branch_target_buffer->reset();
+        icache_stall->reset();
+        dcache_stall->reset();
     }
 
     static const ISAInfoBase* ISA() {
@@ -0,0 +1,83 @@
+#pragma once
+
+#include "../riscv.h"
+
+#include "VSRTL/core/vsrtl_component.h"
+#include "VSRTL/core/vsrtl_register.h"
+#include "VSRTL/core/vsrtl_wire.h"
+
+namespace vsrtl {
+namespace core {
+using namespace Ripes;
+
+/**
+ * @brief The HZ_CacheStall class
+ * Holds a memory access for the cycles it takes beyond the current one, as reported by the cache simulator attached to
+ * the memory (CacheSim::sigCacheStall). The wait output drives the wait inputs of the hazard unit; mem_wait for the
+ * data memory and fetch_wait for the instruction memory.
+ */
+class HZ_CacheStall : public Component {
+public:
+    HZ_CacheStall(std::string name, SimComponent* parent) : Component(name, parent) {
+        cycle_next->out << [=] { return cycle->out.uValue() + 1; };
+        cycle_next->out >> cycle->in;
+
+        // The counter is evaluated after the memory access which reports the stall
+        remaining_next->setSensitiveTo(mem_data);
+        remaining_next->setSensitiveTo(mem_invalid);
+        remaining_next->out << [=] {
+            if (hasPendingStall()) {
+                return m_pendingCycles - 1;
+            }
+            const unsigned cycles = remaining->out.uValue();
+            return cycles > 0 ? cycles - 1 : 0;
+        };
+        remaining_next->out >> remaining->in;
+
+        wait << [=] { return mem_invalid.uValue() || remaining->out.uValue() != 0 || hasPendingStall(); };
+        wait >> waited->in;
+    }
+
+    INPUTPORT(mem_data, RV_REG_WIDTH);  // mem_data: the data output of the memory accessed by the stage.
+    INPUTPORT(mem_invalid, 1);          // mem_invalid: whether the memory itself holds its data invalid.
+
+    // cycle: counts the clock cycles. A stall only holds within the cycle of the access reporting it.
+    SUBCOMPONENT(cycle, Register<RV_REG_WIDTH>);
+    // remaining: the number of cycles the access is still held for, beyond the current one.
+    SUBCOMPONENT(remaining, Register<RV_REG_WIDTH>);
+    // waited: whether the stage waited in the previous cycle.
+    SUBCOMPONENT(waited, Register<1>);
+
+    WIRE(cycle_next, RV_REG_WIDTH);
+    WIRE(remaining_next, RV_REG_WIDTH);
+
+    OUTPUTPORT(wait, 1);  // wait: whether the stage is waiting for the memory access result.
+
+    /**
+     * @brief stall
+     * Slot for CacheSim::sigCacheStall. Holds the access of the current cycle for @p cycles further cycles. An access
+     * which is presented to the memory again whilst it is held, or in the cycle in which it is released, is the same
+     * access, and is not stalled on twice.
+     */
+    void stall(unsigned cycles) {
+        if (waited->out.uValue() != 0) {
+            return;
+        }
+        m_pendingCycles = cycles;
+        m_pendingCycle = cycle->out.uValue();
+    }
+
+    void reset() {
+        m_pendingCycles = 0;
+        m_pendingCycle = 0;
+    }
+
+private:
+    bool hasPendingStall() const { return m_pendingCycles != 0 && m_pendingCycle == cycle->out.uValue(); }
+
+    unsigned m_pendingCycles = 0;
+    unsigned m_pendingCycle = 0;
+};
+
+}  // namespace core
+}  // namespace vsrtl
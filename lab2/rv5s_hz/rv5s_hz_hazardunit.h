@@ -12,12 +12,12 @@ using namespace Ripes;
 class HZ_HazardUnit : public Component {
 public:
     HZ_HazardUnit(std::string name, SimComponent* parent) : Component(name, parent) {
-        hazardFEEnable << [=] { return !hasHazard() && !hasMemWait() && !hasALUWait(); };
+        hazardFEEnable << [=] { return !hasHazard() && !hasFetchWait() && !hasMemWait() && !hasALUWait(); };
         hazardIDEXEnable << [=] { return !hasEcallHazard() && !hasMemWait() && !hasALUWait(); };
         hazardEXMEMEnable << [=] { return !hasMemWait() && !hasALUWait(); };
         hazardMEMWBEnable << [=] { return !hasMemWait() && !hasALUWait(); };
         hazardEXMEMClear << [=] { return hasEcallHazard(); };
-        hazardIDEXClear << [=] { return hasDataHazard(); };
+        hazardIDEXClear << [=] { return hasDataHazard() || hasFetchWait(); };
         stallEcallHandling << [=] { return hasEcallHazard(); };
     }
 
@@ -37,6 +37,7 @@ public:
     INPUTPORT_ENUM(opcode, RVInstr);
     INPUTPORT(mem_wait, 1);  // mem_wait: whether the pipeline is waiting for memory access result.
     INPUTPORT(alu_wait, 1);  // alu_wait: whether the pipeline is waiting for alu operation result (MUL, DIV).
+    INPUTPORT(fetch_wait, 1);  // fetch_wait: whether the IF stage is waiting for the instruction fetch result.
 
     INPUTPORT(id_do_branch, 1);  // id_do_branch: whether the current instruction at ID stage will do branch operation
                                  // (BEQ, BNE, BGE, BLT, BGEU, BLTU).
@@ -69,6 +70,10 @@ private:
 
     bool hasALUWait() const { return (alu_wait.uValue() == 1); }
 
+    // A pending fetch stalls the front-end like a data hazard does; the instruction in ID waits for the fetched one,
+    // whilst a bubble is inserted into EX and the remainder of the pipeline drains.
+    bool hasFetchWait() const { return (fetch_wait.uValue() == 1); }
+
     bool hasEcallHazard() const {
         // Check for ECALL hazard. We are implictly dependent on all registers when performing an ECALL operation. As
         // such, all outstanding writes to the register file must be performed before handling the ecall. Hence, the
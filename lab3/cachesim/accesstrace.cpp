@@ -0,0 +1,126 @@
+#include "accesstrace.h"
+
+#include <algorithm>
+#include <cassert>
+#include <limits>
+
+namespace Ripes {
+
+namespace {
+constexpr unsigned s_maxCounterOffset = std::numeric_limits<uint16_t>::max();
+
+bool fitsOffset(int value, int base) {
+    return value >= base && static_cast<unsigned>(value - base) <= s_maxCounterOffset;
+}
+}  // namespace
+
+bool AccessTraceSeries::Chunk::fits(unsigned cycle, const CacheAccessTrace& trace) const {
+    if (size == s_chunkEntries) {
+        return false;
+    }
+    if (size == 0) {
+        return true;
+    }
+    return cycle >= baseCycle && fitsOffset(trace.hits, base.hits) && fitsOffset(trace.misses, base.misses) &&
+           fitsOffset(trace.reads, base.reads) && fitsOffset(trace.writes, base.writes) &&
+           fitsOffset(trace.writebacks, base.writebacks) &&
+           fitsOffset(trace.compulsoryMisses, base.compulsoryMisses) &&
+           fitsOffset(trace.capacityMisses, base.capacityMisses) &&
+           fitsOffset(trace.conflictMisses, base.conflictMisses);
+}
+
+void AccessTraceSeries::Chunk::append(unsigned cycle, const CacheAccessTrace& trace) {
+    if (size == 0) {
+        baseCycle = cycle;
+        base = trace;
+    }
+    cycles[size] = cycle - baseCycle;
+    hits[size] = trace.hits - base.hits;
+    misses[size] = trace.misses - base.misses;
+    reads[size] = trace.reads - base.reads;
+    writes[size] = trace.writes - base.writes;
+    writebacks[size] = trace.writebacks - base.writebacks;
+    compulsoryMisses[size] = trace.compulsoryMisses - base.compulsoryMisses;
+    capacityMisses[size] = trace.capacityMisses - base.capacityMisses;
+    conflictMisses[size] = trace.conflictMisses - base.conflictMisses;
+    size++;
+}
+
+AccessTraceSeries::Entry AccessTraceSeries::Chunk::at(unsigned idx) const {
+    Entry entry;
+    entry.cycle = baseCycle + cycles[idx];
+    entry.trace.hits = base.hits + hits[idx];
+    entry.trace.misses = base.misses + misses[idx];
+    entry.trace.reads = base.reads + reads[idx];
+    entry.trace.writes = base.writes + writes[idx];
+    entry.trace.writebacks = base.writebacks + writebacks[idx];
+    entry.trace.compulsoryMisses = base.compulsoryMisses + compulsoryMisses[idx];
+    entry.trace.capacityMisses = base.capacityMisses + capacityMisses[idx];
+    entry.trace.conflictMisses = base.conflictMisses + conflictMisses[idx];
+    return entry;
+}
+
+void AccessTraceSeries::push(unsigned cycle, const CacheAccessTrace& trace) {
+    if (m_size > 0) {
+        const unsigned lastCycle = back().cycle;
+        assert(cycle >= lastCycle && "Access trace entries must be pushed in cycle order");
+        if (cycle == lastCycle) {
+            pop();
+        }
+    }
+
+    if (m_chunks.empty() || !m_chunks.back()->fits(cycle, trace)) {
+        std::unique_ptr<Chunk> chunk = m_spare ? std::move(m_spare) : std::make_unique<Chunk>();
+        chunk->size = 0;
+        m_chunks.push_back(std::move(chunk));
+        m_chunkStarts.push_back(m_size);
+    }
+    m_chunks.back()->append(cycle, trace);
+    m_size++;
+}
+
+void AccessTraceSeries::pop() {
+    assert(m_size > 0 && "Cannot pop from an empty access trace");
+    Chunk& chunk = *m_chunks.back();
+    chunk.size--;
+    m_size--;
+    if (chunk.size == 0) {
+        m_spare = std::move(m_chunks.back());
+        m_chunks.pop_back();
+        m_chunkStarts.pop_back();
+    }
+}
+
+void AccessTraceSeries::clear() {
+    m_chunks.clear();
+    m_chunkStarts.clear();
+    m_spare.reset();
+    m_size = 0;
+}
+
+size_t AccessTraceSeries::chunkOf(size_t idx) const {
+    return std::upper_bound(m_chunkStarts.begin(), m_chunkStarts.end(), idx) - m_chunkStarts.begin() - 1;
+}
+
+AccessTraceSeries::Entry AccessTraceSeries::at(size_t idx) const {
+    assert(idx < m_size && "Access trace index out of range");
+    const size_t chunkIdx = chunkOf(idx);
+    return m_chunks[chunkIdx]->at(idx - m_chunkStarts[chunkIdx]);
+}
+
+size_t AccessTraceSeries::lowerBound(unsigned cycle) const {
+    // Locate the last chunk starting at or before 'cycle'; the entry is either within it or is the first entry of the
+    // succeeding chunk
+    auto chunkIt = std::upper_bound(m_chunks.begin(), m_chunks.end(), cycle,
+                                    [](unsigned c, const std::unique_ptr<Chunk>& chunk) { return c < chunk->baseCycle; });
+    if (chunkIt == m_chunks.begin()) {
+        return 0;
+    }
+    const size_t chunkIdx = chunkIt - m_chunks.begin() - 1;
+    const Chunk& chunk = *m_chunks[chunkIdx];
+    const uint32_t offset = cycle - chunk.baseCycle;
+    const auto it = std::lower_bound(chunk.cycles.begin(), chunk.cycles.begin() + chunk.size, offset);
+    return m_chunkStarts[chunkIdx] + (it - chunk.cycles.begin());
+}
+
+}  // namespace Ripes
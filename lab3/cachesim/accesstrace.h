@@ -0,0 +1,139 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "cacheengine.h"
+
+namespace Ripes {
+
+/**
+ * @brief The CacheAccessTrace struct
+ * Cumulative cache access statistics, as of some simulation cycle.
+ */
+struct CacheAccessTrace {
+    int hits = 0;
+    int misses = 0;
+    int reads = 0;
+    int writes = 0;
+    int writebacks = 0;
+    // 3C classes of the misses (see CacheEngine::setMissClassification())
+    int compulsoryMisses = 0;
+    int capacityMisses = 0;
+    int conflictMisses = 0;
+    CacheAccessTrace() {}
+    CacheAccessTrace(const CacheEngine::CacheStatistics& stats)
+        : hits(stats.hits),
+          misses(stats.misses),
+          reads(stats.reads),
+          writes(stats.writes),
+          writebacks(stats.writebacks),
+          compulsoryMisses(stats.compulsoryMisses),
+          capacityMisses(stats.capacityMisses),
+          conflictMisses(stats.conflictMisses) {}
+};
+
+/**
+ * @brief The AccessTraceSeries class
+ * Append-only time series of CacheAccessTrace values keyed by (strictly increasing) cycle.
+ *
+ * Entries are stored column-wise in fixed-size chunks. Each chunk holds the full cycle and counter values of its first
+ * entry, and every entry is stored as 32-bit cycle and 16-bit counter offsets from that base. An entry which does not
+ * fit the offsets starts a new chunk. Given that the counters are cumulative and grow by at most a few counts per
+ * entry, this costs 20 bytes per entry while keeping every entry addressable in O(1), which the binary searching range
+ * queries rely on.
+ */
+class AccessTraceSeries {
+public:
+    struct Entry {
+        unsigned cycle = 0;
+        CacheAccessTrace trace;
+    };
+
+    /**
+     * @brief push
+     * Appends the statistics of @p cycle. If the most recent entry is of the same cycle, it is replaced.
+     */
+    void push(unsigned cycle, const CacheAccessTrace& trace);
+
+    /**
+     * @brief pop
+     * Removes the most recent entry in O(1).
+     */
+    void pop();
+    void clear();
+
+    size_t size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+    Entry at(size_t idx) const;
+    Entry back() const { return at(m_size - 1); }
+
+    /**
+     * @brief lowerBound
+     * @returns the index of the first entry with a cycle not less than @p cycle, or size() if no such entry exists.
+     */
+    size_t lowerBound(unsigned cycle) const;
+
+    /**
+     * @brief forEachInRange
+     * Calls @p f with each Entry whose cycle lies within [@p firstCycle, @p lastCycle], in cycle order.
+     */
+    template <typename F>
+    void forEachInRange(unsigned firstCycle, unsigned lastCycle, F f) const {
+        const size_t first = lowerBound(firstCycle);
+        if (first == m_size) {
+            return;
+        }
+        size_t chunkIdx = chunkOf(first);
+        unsigned offset = first - m_chunkStarts[chunkIdx];
+        for (; chunkIdx < m_chunks.size(); chunkIdx++, offset = 0) {
+            const Chunk& chunk = *m_chunks[chunkIdx];
+            for (; offset < chunk.size; offset++) {
+                const Entry entry = chunk.at(offset);
+                if (entry.cycle > lastCycle) {
+                    return;
+                }
+                f(entry);
+            }
+        }
+    }
+
+    size_t memoryUsage() const { return (m_chunks.size() + (m_spare ? 1 : 0)) * sizeof(Chunk); }
+
+private:
+    static constexpr unsigned s_chunkEntries = 4096;
+
+    struct Chunk {
+        unsigned size = 0;
+        unsigned baseCycle = 0;
+        CacheAccessTrace base;
+        std::array<uint32_t, s_chunkEntries> cycles;
+        std::array<uint16_t, s_chunkEntries> hits;
+        std::array<uint16_t, s_chunkEntries> misses;
+        std::array<uint16_t, s_chunkEntries> reads;
+        std::array<uint16_t, s_chunkEntries> writes;
+        std::array<uint16_t, s_chunkEntries> writebacks;
+        std::array<uint16_t, s_chunkEntries> compulsoryMisses;
+        std::array<uint16_t, s_chunkEntries> capacityMisses;
+        std::array<uint16_t, s_chunkEntries> conflictMisses;
+
+        bool fits(unsigned cycle, const CacheAccessTrace& trace) const;
+        void append(unsigned cycle, const CacheAccessTrace& trace);
+        Entry at(unsigned idx) const;
+    };
+
+    size_t chunkOf(size_t idx) const;
+
+    std::vector<std::unique_ptr<Chunk>> m_chunks;
+    // Index of the first entry of each chunk. Chunks are not necessarily full, given that an entry which does not fit
+    // the offsets of the current chunk starts a new one.
+    std::vector<size_t> m_chunkStarts;
+    // Most recently released chunk, kept to avoid reallocation when undoing and redoing across a chunk boundary
+    std::unique_ptr<Chunk> m_spare;
+    size_t m_size = 0;
+};
+
+}  // namespace Ripes
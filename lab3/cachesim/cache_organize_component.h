@@ -1,29 +1,561 @@
 #ifndef CACHE_ORGANIZE_COMPONENT_H
 #define CACHE_ORGANIZE_COMPONENT_H
 
-#include <map>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <new>
 #include <vector>
-#include <set>
 
 namespace Ripes {
 
+/**
+ * @brief DirtyBlockMask
+ * Per-block bitmap of a single cache line, tracking its dirty blocks or, in sectored caches, its valid blocks. Lines of
+ * up to 64 blocks are tracked in one inline word, so copying a mask never allocates; wider lines fall back to a
+ * heap-allocated array of words.
+ */
+class DirtyBlockMask {
+public:
+    static constexpr unsigned s_wordBits = 64;
+
+    static unsigned words(unsigned blocks) { return (blocks + s_wordBits - 1) / s_wordBits; }
+
+    void set(unsigned block) { wordPtr()[block / s_wordBits] |= bit(block); }
+    void reset(unsigned block) { wordPtr()[block / s_wordBits] &= ~bit(block); }
+    bool test(unsigned block) const {
+        if (block / s_wordBits >= wordCount()) {
+            return false;
+        }
+        return wordPtr()[block / s_wordBits] & bit(block);
+    }
+
+    bool any() const {
+        for (unsigned i = 0; i < wordCount(); i++) {
+            if (wordPtr()[i] != 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    unsigned count() const {
+        unsigned n = 0;
+        for (unsigned i = 0; i < wordCount(); i++) {
+            n += __builtin_popcountll(wordPtr()[i]);
+        }
+        return n;
+    }
+
+    void clear() {
+        m_word = 0;
+        m_wide.clear();
+    }
+
+    /**
+     * @brief load/store
+     * Transfers the mask from/to @p n consecutive words of a CacheStorage mask column.
+     */
+    void load(const uint64_t* words, unsigned n) {
+        if (n <= 1) {
+            m_word = n == 0 ? 0 : words[0];
+            m_wide.clear();
+        } else {
+            m_wide.assign(words, words + n);
+        }
+    }
+    void store(uint64_t* words, unsigned n) const {
+        for (unsigned i = 0; i < n; i++) {
+            words[i] = i < wordCount() ? wordPtr()[i] : 0;
+        }
+    }
+
+    /**
+     * @brief forEach
+     * Calls @p f with the index of every set block, in ascending order.
+     */
+    template <typename F>
+    void forEach(F&& f) const {
+        for (unsigned i = 0; i < wordCount(); i++) {
+            uint64_t w = wordPtr()[i];
+            while (w != 0) {
+                f(i * s_wordBits + __builtin_ctzll(w));
+                w &= w - 1;
+            }
+        }
+    }
+
+    bool operator==(const DirtyBlockMask& other) const {
+        const unsigned n = wordCount() > other.wordCount() ? wordCount() : other.wordCount();
+        for (unsigned i = 0; i < n; i++) {
+            const uint64_t a = i < wordCount() ? wordPtr()[i] : 0;
+            const uint64_t b = i < other.wordCount() ? other.wordPtr()[i] : 0;
+            if (a != b) {
+                return false;
+            }
+        }
+        return true;
+    }
+    bool operator!=(const DirtyBlockMask& other) const { return !(*this == other); }
+
+private:
+    static uint64_t bit(unsigned block) { return uint64_t(1) << (block % s_wordBits); }
+    unsigned wordCount() const { return m_wide.empty() ? 1 : m_wide.size(); }
+    uint64_t* wordPtr() { return m_wide.empty() ? &m_word : m_wide.data(); }
+    const uint64_t* wordPtr() const { return m_wide.empty() ? &m_word : m_wide.data(); }
+
+    uint64_t m_word = 0;
+    std::vector<uint64_t> m_wide;
+};
+
+/**
+ * @brief CacheWay
+ * Value snapshot of a single cache entry. The cache contents themselves are stored in CacheStorage; a CacheWay is only
+ * materialized when a copy of an entry is needed, ie. for rollback traces.
+ */
 struct CacheWay {
     uint32_t tag = -1;
-    std::set<unsigned> dirtyBlocks;
+    DirtyBlockMask dirtyBlocks;
+    DirtyBlockMask validBlocks;  // Sectored caches only: the blocks of the line which are present
     bool dirty = false;
     bool valid = false;
+    bool prefetched = false;
 
     // LRU algorithm relies on invalid cache ways to have an initial high value. -1 ensures maximum value for all
     // way sizes.
     unsigned counter = -1;
-    unsigned age = 0;
 };
 
-using CacheSet = std::map<unsigned, CacheWay>;
+/**
+ * @brief AlignedAllocator
+ * Allocator handing out storage aligned to a host cache line, such that each column of CacheStorage starts on a line
+ * boundary.
+ */
+template <typename T, std::size_t Alignment = 64>
+struct AlignedAllocator {
+    using value_type = T;
+    template <typename U>
+    struct rebind {
+        using other = AlignedAllocator<U, Alignment>;
+    };
+
+    AlignedAllocator() = default;
+    template <typename U>
+    AlignedAllocator(const AlignedAllocator<U, Alignment>&) {}
+
+    T* allocate(std::size_t n) {
+        return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(Alignment)));
+    }
+    void deallocate(T* p, std::size_t) { ::operator delete(p, std::align_val_t(Alignment)); }
+
+    template <typename U>
+    bool operator==(const AlignedAllocator<U, Alignment>&) const {
+        return true;
+    }
+    template <typename U>
+    bool operator!=(const AlignedAllocator<U, Alignment>&) const {
+        return false;
+    }
+};
+
+template <typename T>
+using AlignedVector = std::vector<T, AlignedAllocator<T>>;
+
+/**
+ * @brief CacheStorage
+ * Dense structure-of-arrays storage for every entry in the cache. Each field of a cache entry is kept in its own
+ * column, and entry (set, way) is located at index set * ways + way within every column. All columns are sized from
+ * sets * ways upon reset(), so no allocation takes place whilst the cache is being accessed.
+ * Tags which fit in 16 bits are kept in a 16-bit column, halving the footprint of the column scanned upon each lookup.
+ */
+class CacheStorage {
+public:
+    // Prefetched: the line was brought in by a prefetch, and has not been demanded since
+    enum Flags : uint8_t { Valid = 0b001, Dirty = 0b010, Prefetched = 0b100 };
+
+    /**
+     * @brief reset
+     * Allocates the storage for @p sets x @p ways entries of @p blocks blocks. If @p sectored, each entry additionally
+     * holds a valid bit per block, and the Valid flag merely tells that the tag of the entry is valid. @p tagBits is
+     * the width of the tags which are stored.
+     */
+    void reset(unsigned sets, unsigned ways, unsigned blocks, bool sectored = false, unsigned tagBits = 32) {
+        m_sets = sets;
+        m_ways = ways;
+        m_maskWords = DirtyBlockMask::words(blocks);
+        const unsigned n = sets * ways;
+        const bool narrow = tagBits <= 16;
+        m_tags.assign(narrow ? 0 : n, static_cast<uint32_t>(-1));
+        m_narrowTags.assign(narrow ? n : 0, static_cast<uint16_t>(-1));
+        m_flags.assign(n, 0);
+        m_counters.assign(n, static_cast<unsigned>(-1));
+        m_dirtyMasks.assign(n * m_maskWords, 0);
+        m_validMasks.assign(sectored ? n * m_maskWords : 0, 0);
+    }
+
+    unsigned sets() const { return m_sets; }
+    unsigned ways() const { return m_ways; }
+    unsigned entries() const { return m_sets * m_ways; }
+    unsigned entry(unsigned set, unsigned way) const { return set * m_ways + way; }
+    unsigned maskWords() const { return m_maskWords; }
+    bool sectored() const { return !m_validMasks.empty(); }
+
+    // Per-set column views. The returned pointers index the ways of @p set.
+    uint8_t* flags(unsigned set) { return &m_flags[set * m_ways]; }
+    const uint8_t* flags(unsigned set) const { return &m_flags[set * m_ways]; }
+    unsigned* counters(unsigned set) { return &m_counters[set * m_ways]; }
+    const unsigned* counters(unsigned set) const { return &m_counters[set * m_ways]; }
+
+    uint32_t tag(unsigned set, unsigned way) const { return loadTag(entry(set, way)); }
+
+    /**
+     * @brief findTag
+     * Returns the first valid way of @p set holding @p tag, or ways() if there is none.
+     */
+    unsigned findTag(unsigned set, uint32_t tag) const {
+        return m_narrowTags.empty() ? findTag(&m_tags[set * m_ways], flags(set), tag)
+                                    : findTag(&m_narrowTags[set * m_ways], flags(set), tag);
+    }
+
+    bool valid(unsigned set, unsigned way) const { return m_flags[entry(set, way)] & Valid; }
+    bool dirty(unsigned set, unsigned way) const { return m_flags[entry(set, way)] & Dirty; }
+    bool prefetched(unsigned set, unsigned way) const { return m_flags[entry(set, way)] & Prefetched; }
+    void setPrefetched(unsigned set, unsigned way, bool prefetched) {
+        const unsigned e = entry(set, way);
+        m_flags[e] = (m_flags[e] & ~Prefetched) | (prefetched ? Prefetched : 0);
+    }
+    unsigned counter(unsigned set, unsigned way) const { return m_counters[entry(set, way)]; }
+    bool blockDirty(unsigned set, unsigned way, unsigned block) const {
+        return dirtyWords(entry(set, way))[block / DirtyBlockMask::s_wordBits] &
+               (uint64_t(1) << (block % DirtyBlockMask::s_wordBits));
+    }
+    DirtyBlockMask dirtyBlocks(unsigned set, unsigned way) const {
+        DirtyBlockMask mask;
+        mask.load(dirtyWords(entry(set, way)), m_maskWords);
+        return mask;
+    }
+
+    void setCounter(unsigned set, unsigned way, unsigned counter) { m_counters[entry(set, way)] = counter; }
+
+    // Sector valid bits; only available if the storage is sectored()
+    bool blockValid(unsigned set, unsigned way, unsigned block) const {
+        return validWords(entry(set, way))[block / DirtyBlockMask::s_wordBits] &
+               (uint64_t(1) << (block % DirtyBlockMask::s_wordBits));
+    }
+    DirtyBlockMask validBlocks(unsigned set, unsigned way) const {
+        DirtyBlockMask mask;
+        mask.load(validWords(entry(set, way)), m_maskWords);
+        return mask;
+    }
+    void setValidBlocks(unsigned set, unsigned way, const DirtyBlockMask& mask) {
+        mask.store(validWords(entry(set, way)), m_maskWords);
+    }
+    void setValidWords(unsigned set, unsigned way, const uint64_t* words) {
+        std::copy_n(words, m_maskWords, validWords(entry(set, way)));
+    }
+    /**
+     * @brief validateBlocks
+     * Marks the @p count blocks starting at @p first as valid, ie. once they have been fetched.
+     */
+    void validateBlocks(unsigned set, unsigned way, unsigned first, unsigned count) {
+        uint64_t* words = validWords(entry(set, way));
+        for (unsigned block = first; block < first + count; block++) {
+            words[block / DirtyBlockMask::s_wordBits] |= uint64_t(1) << (block % DirtyBlockMask::s_wordBits);
+        }
+    }
+
+    void markDirty(unsigned set, unsigned way, unsigned block) {
+        const unsigned e = entry(set, way);
+        m_flags[e] |= Dirty;
+        dirtyWords(e)[block / DirtyBlockMask::s_wordBits] |= uint64_t(1) << (block % DirtyBlockMask::s_wordBits);
+    }
+
+    /**
+     * @brief unmarkDirty
+     * Reverts a markDirty() of @p block which found the block clean, restoring the entry's dirty bit to @p wasDirty.
+     */
+    void unmarkDirty(unsigned set, unsigned way, unsigned block, bool wasDirty) {
+        const unsigned e = entry(set, way);
+        m_flags[e] = (m_flags[e] & ~Dirty) | (wasDirty ? Dirty : 0);
+        dirtyWords(e)[block / DirtyBlockMask::s_wordBits] &= ~(uint64_t(1) << (block % DirtyBlockMask::s_wordBits));
+    }
+
+    /**
+     * @brief fill
+     * Loads @p tag into the entry at (@p set, @p way) as a clean, valid line. Replacement fields are left untouched;
+     * these are managed by the replacement policy. In a sectored storage, none of the blocks of the line are valid
+     * until validated by validateBlocks().
+     */
+    void fill(unsigned set, unsigned way, uint32_t tag) {
+        const unsigned e = entry(set, way);
+        storeTag(e, tag);
+        m_flags[e] = Valid;
+        std::fill_n(dirtyWords(e), m_maskWords, 0);
+        if (sectored()) {
+            std::fill_n(validWords(e), m_maskWords, 0);
+        }
+    }
 
-}
+    /**
+     * @brief way
+     * Returns a snapshot of the entry at (@p set, @p way).
+     */
+    CacheWay way(unsigned set, unsigned way) const {
+        const unsigned e = entry(set, way);
+        CacheWay snapshot;
+        snapshot.tag = loadTag(e);
+        snapshot.valid = m_flags[e] & Valid;
+        snapshot.dirty = m_flags[e] & Dirty;
+        snapshot.prefetched = m_flags[e] & Prefetched;
+        snapshot.counter = m_counters[e];
+        snapshot.dirtyBlocks.load(dirtyWords(e), m_maskWords);
+        if (sectored()) {
+            snapshot.validBlocks.load(validWords(e), m_maskWords);
+        }
+        return snapshot;
+    }
 
+    /**
+     * @brief setWay
+     * Restores the entry at (@p set, @p way) from a snapshot previously returned by way().
+     */
+    void setWay(unsigned set, unsigned way, const CacheWay& snapshot) {
+        const unsigned e = entry(set, way);
+        storeTag(e, snapshot.tag);
+        m_flags[e] =
+            (snapshot.valid ? Valid : 0) | (snapshot.dirty ? Dirty : 0) | (snapshot.prefetched ? Prefetched : 0);
+        m_counters[e] = snapshot.counter;
+        snapshot.dirtyBlocks.store(dirtyWords(e), m_maskWords);
+        if (sectored()) {
+            snapshot.validBlocks.store(validWords(e), m_maskWords);
+        }
+    }
 
+    void invalidate(unsigned set, unsigned way) { setWay(set, way, CacheWay()); }
+
+    /**
+     * @brief dirtyWords/validWords
+     * Raw view of the maskWords() words of the dirty (or sector valid) mask of the entry at (@p set, @p way).
+     */
+    const uint64_t* dirtyWords(unsigned set, unsigned way) const { return dirtyWords(entry(set, way)); }
+    const uint64_t* validWords(unsigned set, unsigned way) const { return validWords(entry(set, way)); }
+
+private:
+    template <typename Tag>
+    unsigned findTag(const Tag* tags, const uint8_t* flags, uint32_t tag) const {
+        for (unsigned way = 0; way < m_ways; way++) {
+            if ((tags[way] == tag) && (flags[way] & Valid)) {
+                return way;
+            }
+        }
+        return m_ways;
+    }
+    uint32_t loadTag(unsigned e) const { return m_narrowTags.empty() ? m_tags[e] : m_narrowTags[e]; }
+    void storeTag(unsigned e, uint32_t tag) {
+        if (m_narrowTags.empty()) {
+            m_tags[e] = tag;
+        } else {
+            m_narrowTags[e] = static_cast<uint16_t>(tag);
+        }
+    }
+
+    uint64_t* dirtyWords(unsigned e) { return &m_dirtyMasks[e * m_maskWords]; }
+    const uint64_t* dirtyWords(unsigned e) const { return &m_dirtyMasks[e * m_maskWords]; }
+    uint64_t* validWords(unsigned e) { return &m_validMasks[e * m_maskWords]; }
+    const uint64_t* validWords(unsigned e) const { return &m_validMasks[e * m_maskWords]; }
+
+    unsigned m_sets = 0;
+    unsigned m_ways = 0;
+    unsigned m_maskWords = 1;  // 64-bit words of dirty (and valid) mask per entry
+
+    AlignedVector<uint32_t> m_tags;         // Empty if the tags are narrow
+    AlignedVector<uint16_t> m_narrowTags;  // Empty unless the tags fit in 16 bits
+    AlignedVector<uint8_t> m_flags;
+    AlignedVector<unsigned> m_counters;
+    AlignedVector<uint64_t> m_dirtyMasks;
+    AlignedVector<uint64_t> m_validMasks;  // Empty unless sectored
+};
+
+/**
+ * @brief VictimBuffer
+ * Small fully associative buffer of lines evicted from a cache, after Jouppi. Entries are identified by the address of
+ * the first word of their line, and are replaced in LRU order. Its capacity is a handful of entries, so lookups are a
+ * linear search.
+ */
+class VictimBuffer {
+public:
+    static constexpr unsigned s_noSlot = static_cast<unsigned>(-1);
+
+    struct Entry {
+        uint32_t lineAddress = 0;
+        DirtyBlockMask dirtyBlocks;
+        DirtyBlockMask validBlocks;  // Sectored caches only
+        bool dirty = false;
+        bool valid = false;
+        uint64_t lastUse = 0;
+    };
+
+    void reset(unsigned entries) {
+        m_entries.assign(entries, Entry());
+        m_clock = 0;
+    }
+
+    unsigned size() const { return m_entries.size(); }
+    const Entry& entry(unsigned slot) const { return m_entries[slot]; }
+
+    /**
+     * @brief find
+     * @returns the slot holding the line at @p lineAddress, or s_noSlot.
+     */
+    unsigned find(uint32_t lineAddress) const {
+        for (unsigned slot = 0; slot < m_entries.size(); slot++) {
+            if (m_entries[slot].valid && m_entries[slot].lineAddress == lineAddress) {
+                return slot;
+            }
+        }
+        return s_noSlot;
+    }
+
+    /**
+     * @brief replacementSlot
+     * @returns an invalid slot if any, or else the least recently inserted one.
+     */
+    unsigned replacementSlot() const {
+        unsigned victim = 0;
+        for (unsigned slot = 0; slot < m_entries.size(); slot++) {
+            if (!m_entries[slot].valid) {
+                return slot;
+            }
+            if (m_entries[slot].lastUse < m_entries[victim].lastUse) {
+                victim = slot;
+            }
+        }
+        return victim;
+    }
+
+    void insert(unsigned slot, uint32_t lineAddress, const CacheWay& way) {
+        Entry& entry = m_entries[slot];
+        entry.lineAddress = lineAddress;
+        entry.dirtyBlocks = way.dirtyBlocks;
+        entry.validBlocks = way.validBlocks;
+        entry.dirty = way.dirty;
+        entry.valid = true;
+        entry.lastUse = ++m_clock;
+    }
+    void invalidate(unsigned slot) { m_entries[slot] = Entry(); }
+
+    /**
+     * @brief restore
+     * Restores @p slot from a copy of an entry previously returned by entry(), ie. for rollbacks.
+     */
+    void restore(unsigned slot, const Entry& entry) { m_entries[slot] = entry; }
+
+private:
+    std::vector<Entry> m_entries;
+    uint64_t m_clock = 0;
+};
+
+/**
+ * @brief WriteBuffer
+ * Bounded FIFO of stores on their way to the level below. Each entry covers a chunk of consecutive words, and stores to
+ * a chunk which is already pending are merged into its entry. Only the contents are kept here; timing is driven by
+ * CacheEngine. An access modifies the contents of at most one slot, along with the position of the buffer; undo
+ * records hold these rather than a copy of the buffer.
+ */
+class WriteBuffer {
+public:
+    static constexpr unsigned s_maxDepth = 16;
+    static constexpr unsigned s_maxChunkWords = 64;
+    static constexpr unsigned s_noSlot = ~0u;
+
+    struct Entry {
+        uint32_t address = 0;  // Address of the first word of the chunk
+        uint64_t words = 0;    // Mask of the words written within the chunk
+    };
+
+    /**
+     * @brief The Position struct
+     * The occupied range of the slots and the drain time of its oldest entry.
+     */
+    struct Position {
+        unsigned head = 0;
+        unsigned size = 0;
+        uint64_t headDone = 0;
+    };
+
+    void clear() {
+        m_head = 0;
+        m_size = 0;
+        m_headDone = 0;
+    }
+
+    unsigned size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+    const Entry& entry(unsigned i) const { return m_entries[slot(i)]; }
+    const Entry& front() const { return entry(0); }
+
+    /**
+     * @brief slot
+     * The slot holding the entry at position @p i, counted from the oldest entry. Position size() is the slot written
+     * by the next push().
+     */
+    unsigned slot(unsigned i) const { return (m_head + i) % s_maxDepth; }
+    const Entry& slotEntry(unsigned slot) const { return m_entries[slot]; }
+    Position position() const { return {m_head, m_size, m_headDone}; }
+
+    /**
+     * @brief find
+     * @returns the position of the entry of the chunk at @p address, counted from the oldest entry, or -1.
+     */
+    int find(uint32_t address) const {
+        for (unsigned i = 0; i < m_size; i++) {
+            if (entry(i).address == address) {
+                return i;
+            }
+        }
+        return -1;
+    }
+
+    void push(uint32_t address, uint64_t words) {
+        Entry& entry = m_entries[slot(m_size)];
+        entry.address = address;
+        entry.words = words;
+        m_size++;
+    }
+    void merge(unsigned i, uint64_t words) { m_entries[slot(i)].words |= words; }
+    void pop() {
+        m_head = (m_head + 1) % s_maxDepth;
+        m_size--;
+    }
+
+    /**
+     * @brief headDone
+     * Time at which the oldest entry has been written to the level below.
+     */
+    uint64_t headDone() const { return m_headDone; }
+    void setHeadDone(uint64_t time) { m_headDone = time; }
+
+    /**
+     * @brief restore
+     * Restores the buffer to @p position, and @p slot, unless s_noSlot, to a copy of its entry previously returned by
+     * slotEntry(), ie. for rollbacks.
+     */
+    void restore(const Position& position, unsigned slot, const Entry& entry) {
+        m_head = position.head;
+        m_size = position.size;
+        m_headDone = position.headDone;
+        if (slot != s_noSlot) {
+            m_entries[slot] = entry;
+        }
+    }
+
+private:
+    Entry m_entries[s_maxDepth];
+    unsigned m_head = 0;
+    unsigned m_size = 0;
+    uint64_t m_headDone = 0;
+};
 
+}  // namespace Ripes
 
-#endif // CACHE_ORGANIZE_COMPONENT_H
+#endif  // CACHE_ORGANIZE_COMPONENT_H
@@ -1,232 +1,215 @@
 #include "cache_policy_object.h"
 #include "cache_organize_component.h"
+#include <algorithm>
+#include <cassert>
+#include <functional>
 #include <iostream>
+#include <unordered_map>
 
 
 namespace Ripes {
 
+unsigned CachePolicyBase::locateLruWay(const CacheStorage& storage, unsigned setIdx) const {
+    if (ways == 1) {
+        // Nothing to do if we only have 1 way
+        return 0;
+    }
+    const uint8_t* flags = storage.flags(setIdx);
+    const unsigned* counters = storage.counters(setIdx);
+    // If there is an invalid cache way, select that
+    for (int i = 0; i < ways; i++) {
+        if (!(flags[i] & CacheStorage::Valid)) {
+            return i;
+        }
+    }
+    // Else, Find LRU way
+    for (int i = 0; i < ways; i++) {
+        if (counters[i] == static_cast<unsigned>(ways - 1)) {
+            return i;
+        }
+    }
+    return static_cast<unsigned>(-1);
+}
 
-void RandomPolicy::locateEvictionWay(std::pair<unsigned, CacheWay*>& ew,
-                                     CacheSet& cacheSet, unsigned setIdx) {
-    ew.first = std::rand() % ways;
-    ew.second = &cacheSet[ew.first];
+
+unsigned RandomPolicy::locateEvictionWay(CacheStorage& /*storage*/, unsigned /*setIdx*/) {
+    return m_rng() % ways;
 }
 
-void RandomPolicy::updateCacheSetReplFields(CacheSet &cacheSet, unsigned int setIdx,
-                                            unsigned int wayIdx, bool isHit) {
+void RandomPolicy::updateCacheSetReplFields(CacheStorage& /*storage*/, unsigned /*setIdx*/,
+                                            unsigned /*wayIdx*/, bool /*isHit*/) {
     // No information needs to be updated
     return;
 }
 
-void RandomPolicy::revertCacheSetReplFields(CacheSet &cacheSet,
-                                            const CacheWay &oldWay,
-                                            unsigned int wayIdx) {
+void RandomPolicy::revertCacheSetReplFields(CacheStorage& /*storage*/,
+                                            const CacheWay &/*oldWay*/,
+                                            unsigned /*setIdx*/, unsigned /*wayIdx*/) {
     // No information needs to be updated
     return;
 }
 
 
-void LruPolicy::locateEvictionWay(std::pair<unsigned, CacheWay*>& ew,
-                                   CacheSet& cacheSet, unsigned setIdx) {
-    if (ways == 1) {
-        // Nothing to do if we are in LRU and only have 1 set
-        ew.first = 0;
-        ew.second = &cacheSet[ew.first];
-    } else {
-        // Lazily all ways in the cache set before starting to iterate
-        for (int i = 0; i < ways; i++) {
-            cacheSet[i];
-        }
-        // If there is an invalid cache cacheSet, select that
-        for (auto& idx_way : cacheSet) {
-            if (!idx_way.second.valid) {
-                ew.first = idx_way.first;
-                ew.second = &idx_way.second;
-                break;
-            }
-        }
-        if (ew.second == nullptr) {
-            // Else, Find LRU way
-            for (auto& idx_way : cacheSet) {
-                if (idx_way.second.counter == ways - 1) {
-                    ew.first = idx_way.first;
-                    ew.second = &idx_way.second;
-                    break;
-                }
-            }
+LruPolicy::LruPolicy(int number_ways, int number_sets, int number_blocks)
+    : CachePolicyBase(number_ways, number_sets, number_blocks) {
+    m_prev.resize(number_sets * number_ways);
+    m_next.resize(number_sets * number_ways);
+    m_head.resize(number_sets);
+    m_tail.resize(number_sets);
+    // Ways are listed in descending order, such that the invalid ways of an empty set are filled from way 0 upwards
+    for (int setIdx = 0; setIdx < number_sets; setIdx++) {
+        m_head[setIdx] = m_tail[setIdx] = s_none;
+        for (int wayIdx = number_ways - 1; wayIdx >= 0; wayIdx--) {
+            insertBefore(setIdx, wayIdx, s_none);
         }
     }
 }
 
-void LruPolicy::updateCacheSetReplFields(CacheSet &cacheSet,unsigned int setIdx,
-                                         unsigned int wayIdx, bool isHit) {
-    const unsigned preLRU = cacheSet[wayIdx].counter;
-    for (auto& idx_way : cacheSet) {
-        if (idx_way.second.valid && idx_way.second.counter < preLRU) {
-            idx_way.second.counter++;
-        }
-    }
-    cacheSet[wayIdx].counter = 0;
+void LruPolicy::unlink(unsigned setIdx, unsigned wayIdx) {
+    unsigned* prev = prevOf(setIdx);
+    unsigned* next = nextOf(setIdx);
+    (prev[wayIdx] == s_none ? m_head[setIdx] : next[prev[wayIdx]]) = next[wayIdx];
+    (next[wayIdx] == s_none ? m_tail[setIdx] : prev[next[wayIdx]]) = prev[wayIdx];
 }
 
-void LruPolicy::revertCacheSetReplFields(CacheSet &cacheSet,
-                                         const CacheWay &oldWay,
-                                         unsigned int wayIdx) {
-    for (auto& idx_way : cacheSet) {
-        if (idx_way.second.valid && idx_way.second.counter <= oldWay.counter) {
-            idx_way.second.counter--;
-        }
+void LruPolicy::insertBefore(unsigned setIdx, unsigned wayIdx, unsigned before) {
+    unsigned* prev = prevOf(setIdx);
+    unsigned* next = nextOf(setIdx);
+    const unsigned after = before == s_none ? m_tail[setIdx] : prev[before];
+    prev[wayIdx] = after;
+    next[wayIdx] = before;
+    (after == s_none ? m_head[setIdx] : next[after]) = wayIdx;
+    (before == s_none ? m_tail[setIdx] : prev[before]) = wayIdx;
+}
+
+unsigned LruPolicy::nextStamp(CacheStorage& storage) {
+    if (m_stamp == 0) {
+        renumberStamps(storage);
     }
-    cacheSet[wayIdx].counter = oldWay.counter;
+    return m_stamp--;
 }
 
-void LruLipPolicy::locateEvictionWay(std::pair<unsigned, CacheWay*>& ew,
-                                        CacheSet& cacheSet, unsigned setIdx) {
-    // ---------------------Part 2. TODO ------------------------------
-    // LRU-LIP has exactly the same locateEvictionWay method as that of LRU
-    if (ways == 1) {
-        // Nothing to do if we are in LRU-LIP and only have 1 set
-        ew.first = 0;
-        ew.second = &cacheSet[ew.first];
-    } else {
-        // Lazily intialize all ways in the cache set before starting to iterate
-        for (int i = 0; i < ways; i++) {
-            cacheSet[i];
-        }
-        // If there is an invalid cache cacheSet, select that
-        for (auto& idx_way : cacheSet) {
-            if (!idx_way.second.valid) {
-                ew.first = idx_way.first;
-                ew.second = &idx_way.second;
-                break;
-            }
-        }
-        if (ew.second == nullptr) {
-            // Else, Find LRU way
-            for (auto& idx_way : cacheSet) {
-                if (idx_way.second.counter == ways - 1) {
-                    ew.first = idx_way.first;
-                    ew.second = &idx_way.second;
-                    break;
-                }
+void LruPolicy::renumberStamps(CacheStorage& storage) {
+    std::vector<std::pair<unsigned, unsigned>> stamps;  // (stamp, entry)
+    for (int setIdx = 0; setIdx < sets; setIdx++) {
+        const unsigned* counters = storage.counters(setIdx);
+        for (int wayIdx = 0; wayIdx < ways; wayIdx++) {
+            if (counters[wayIdx] != s_invalidStamp) {
+                stamps.emplace_back(counters[wayIdx], setIdx * ways + wayIdx);
             }
         }
     }
+    // Oldest (largest) stamps first
+    std::sort(stamps.begin(), stamps.end(), std::greater<std::pair<unsigned, unsigned>>());
+    m_stamp = s_invalidStamp - 1;
+    for (const auto& stamp : stamps) {
+        storage.setCounter(stamp.second / ways, stamp.second % ways, m_stamp--);
+    }
 }
 
-void LruLipPolicy::updateCacheSetReplFields(CacheSet &cacheSet, unsigned int setIdx,
-                                               unsigned int wayIdx, bool isHit) {
-    // ---------------------Part 2. TODO ------------------------------
-    //const unsigned preLRU = cacheSet[wayIdx].counter;
-    for (auto& idx_way : cacheSet) {
-        if (idx_way.second.valid && idx_way.second.counter < ways - 1) {
-            idx_way.second.counter++;
-        }
-    }
-    cacheSet[wayIdx].counter = isHit ? 0 : ways-1;
+unsigned LruPolicy::locateEvictionWay(CacheStorage& /*storage*/, unsigned setIdx) {
+    return m_tail[setIdx];
 }
 
-void LruLipPolicy::revertCacheSetReplFields(CacheSet &cacheSet,
-                                               const CacheWay &oldWay,
-                                               unsigned int wayIdx) {
-    // ---------------------Part 2. TODO (optional)------------------------------
+void LruPolicy::updateCacheSetReplFields(CacheStorage& storage, unsigned setIdx,
+                                         unsigned wayIdx, bool /*isHit*/) {
+    storage.setCounter(setIdx, wayIdx, nextStamp(storage));
+    if (m_head[setIdx] != wayIdx) {
+        unlink(setIdx, wayIdx);
+        insertBefore(setIdx, wayIdx, m_head[setIdx]);
+    }
 }
 
-void DipPolicy::locateEvictionWay(std::pair<unsigned, CacheWay*>& ew,
-                                        CacheSet& cacheSet, unsigned setIdx) {
-    // ---------------------Part 2. TODO ------------------------------
-    // update PSEL
-    if (setIdx == 0) { // if there is a miss in set 0
-        PSEL += (PSEL < 3) ? 1 : 0;
+void LruPolicy::revertCacheSetReplFields(CacheStorage& storage,
+                                         const CacheWay &oldWay,
+                                         unsigned setIdx, unsigned wayIdx) {
+    // Stamps of the other ways are unaffected by an access. Restore the stamp of the way, and reinsert it in front of
+    // the first way which is older.
+    storage.setCounter(setIdx, wayIdx, oldWay.counter);
+    unlink(setIdx, wayIdx);
+    const unsigned* next = nextOf(setIdx);
+    unsigned before = m_head[setIdx];
+    while (before != s_none && storage.counter(setIdx, before) <= oldWay.counter) {
+        before = next[before];
     }
-    if (setIdx == 1) { // if there is a miss in set 1
-        PSEL += (PSEL > 0) ? -1 : 0;
+    insertBefore(setIdx, wayIdx, before);
+}
+
+void LruPolicy::invalidateCacheSetReplFields(CacheStorage& /*storage*/, unsigned setIdx, unsigned wayIdx) {
+    // The way becomes the victim of the set
+    unlink(setIdx, wayIdx);
+    insertBefore(setIdx, wayIdx, s_none);
+}
+
+unsigned LruPolicy::getCacheSetReplCounter(const CacheStorage& storage, unsigned setIdx, unsigned wayIdx) const {
+    if (!storage.valid(setIdx, wayIdx)) {
+        return ways - 1;
     }
-    // locate eviction way (same as that in LRU policy)
-    if (ways == 1) {
-        // Nothing to do if we are in DIP and only have 1 set
-        ew.first = 0;
-        ew.second = &cacheSet[ew.first];
-    } else {
-        // Lazily initialize all ways in the cache set before starting to iterate
-        for (int i = 0; i < ways; i++) {
-            cacheSet[i];
-        }
-        // If there is an invalid cache cacheSet, select that
-        for (auto& idx_way : cacheSet) {
-            if (!idx_way.second.valid) {
-                ew.first = idx_way.first;
-                ew.second = &idx_way.second;
-                break;
-            }
-        }
-        if (ew.second == nullptr) {
-            // Else, Find LRU way
-            for (auto& idx_way : cacheSet) {
-                if (idx_way.second.counter == ways - 1) {
-                    ew.first = idx_way.first;
-                    ew.second = &idx_way.second;
-                    break;
-                }
-            }
-        }
+    const unsigned* next = &m_next[setIdx * ways];
+    unsigned rank = 0;
+    for (unsigned way = m_head[setIdx]; way != wayIdx; way = next[way]) {
+        rank++;
     }
+    return rank;
+}
+
+unsigned LruLipPolicy::locateEvictionWay(CacheStorage& storage, unsigned setIdx) {
+    // ---------------------Part 2. TODO ------------------------------
+    // LRU-LIP has exactly the same locateEvictionWay method as that of LRU
+    return locateLruWay(storage, setIdx);
 }
 
-void DipPolicy::updateCacheSetReplFields(CacheSet &cacheSet, unsigned int setIdx,
-                                               unsigned int wayIdx, bool isHit) {
+void LruLipPolicy::updateCacheSetReplFields(CacheStorage& storage, unsigned setIdx,
+                                               unsigned wayIdx, bool isHit) {
     // ---------------------Part 2. TODO ------------------------------
-    for (auto& idx_way : cacheSet) {
-        if (idx_way.second.valid && idx_way.second.counter < ways - 1) {
-            idx_way.second.counter++;
+    const uint8_t* flags = storage.flags(setIdx);
+    unsigned* counters = storage.counters(setIdx);
+    for (int i = 0; i < ways; i++) {
+        if ((flags[i] & CacheStorage::Valid) && counters[i] < static_cast<unsigned>(ways - 1)) {
+            counters[i]++;
         }
     }
-    if (PSEL <= 1 || setIdx == 0) { // choose LRU policy
-        cacheSet[wayIdx].counter = 0;
-    } else { // choose LRU-LIP policy
-        cacheSet[wayIdx].counter = isHit ? 0 : ways-1;  
+    if (isHit) {
+        counters[wayIdx] = 0;
+    } else {
+        // Bimodal insertion: 1 in m_bimodalThrottle misses is inserted at the MRU position
+        const bool mru = m_bimodalThrottle != 0 && (m_bimodalThrottle == 1 || m_rng() % m_bimodalThrottle == 0);
+        counters[wayIdx] = mru ? 0 : ways - 1;
     }
-    
 }
 
-void DipPolicy::revertCacheSetReplFields(CacheSet &cacheSet,
+void LruLipPolicy::revertCacheSetReplFields(CacheStorage& storage,
                                                const CacheWay &oldWay,
-                                               unsigned int wayIdx) {
-    // ---------------------Part 2. TODO (optional)------------------------------
+                                               unsigned setIdx, unsigned wayIdx) {
+    // The counters of the other ways are restored from the undo log (see s_updatesSetCounters)
+    storage.setCounter(setIdx, wayIdx, oldWay.counter);
 }
 
-void PlruPolicy::locateEvictionWay(std::pair<unsigned, CacheWay*>& ew,
-                                        CacheSet& cacheSet, unsigned setIdx) {
+unsigned PlruPolicy::locateEvictionWay(CacheStorage& /*storage*/, unsigned setIdx) {
     // ---------------------Part 2. TODO ------------------------------
     if (ways == 1) {
         // Nothing to do if we are in PLRU and only have 1 set
-        ew.first = 0;
-        ew.second = &cacheSet[ew.first];
-    } else {
-        // Lazily initialize all ways in the cacheSet
-        for(int i=0; i<ways; i++) {
-            cacheSet[i];
-        }
-        // Find Plru way
-        bool* root = PlruTree[setIdx];
-        ew.first = 0;
-        int i = 0;
-        while (i < ways-1) {
-            ew.first = (ew.first << 1) + (root[i] ? 1 : 0);
-            i = root[i] ? (2 + (i << 1)) : (1 + (i << 1));
-        }
-        ew.second = &cacheSet[ew.first];
+        return 0;
+    }
+    // Find Plru way
+    const uint8_t* root = treeOf(setIdx);
+    unsigned wayIdx = 0;
+    int i = 0;
+    while (i < ways-1) {
+        wayIdx = (wayIdx << 1) + (root[i] ? 1 : 0);
+        i = root[i] ? (2 + (i << 1)) : (1 + (i << 1));
     }
+    return wayIdx;
 }
 
-void PlruPolicy::updateCacheSetReplFields(CacheSet &cacheSet, unsigned int setIdx,
-                                               unsigned int wayIdx, bool isHit) {
+void PlruPolicy::updateCacheSetReplFields(CacheStorage& /*storage*/, unsigned setIdx,
+                                               unsigned wayIdx, bool /*isHit*/) {
     // ---------------------Part 2. TODO ------------------------------
     // Reverse the path
     if (ways == 1) {
         return;
     }
-    bool* root = PlruTree[setIdx];
+    uint8_t* root = treeOf(setIdx);
     unsigned wayMask = ways >> 1;
     int i = 0;
     while (wayMask > 0) {
@@ -242,9 +225,9 @@ void PlruPolicy::updateCacheSetReplFields(CacheSet &cacheSet, unsigned int setId
 
 }
 
-void PlruPolicy::revertCacheSetReplFields(CacheSet &cacheSet,
-                                               const CacheWay &oldWay,
-                                               unsigned int wayIdx) {
+void PlruPolicy::revertCacheSetReplFields(CacheStorage& /*storage*/,
+                                               const CacheWay &/*oldWay*/,
+                                               unsigned /*setIdx*/, unsigned /*wayIdx*/) {
     // ---------------------Part 2. TODO (optional) ------------------------------
 }
 
@@ -253,4 +236,153 @@ void PlruPolicy::revertCacheSetReplFields(CacheSet &cacheSet,
 
 
 
+RripPolicy::RripPolicy(int number_ways, int number_sets, int number_blocks, Insertion insertion,
+                       unsigned bimodalThrottle, unsigned rrpvBits)
+    : CachePolicyBase(number_ways, number_sets, number_blocks),
+      m_insertion(insertion),
+      m_bimodalThrottle(bimodalThrottle),
+      m_maxRrpv((1u << rrpvBits) - 1) {
+    assert(rrpvBits >= 1 && rrpvBits <= s_maxRrpvBits && "Invalid RRPV width");
+}
+
+unsigned RripPolicy::locateEvictionWay(CacheStorage& storage, unsigned setIdx) {
+    const uint8_t* flags = storage.flags(setIdx);
+    const unsigned* counters = storage.counters(setIdx);
+    // If there is an invalid cache way, select that. Else, select the first way with the largest RRPV.
+    m_victimAging = 0;
+    unsigned victim = 0;
+    for (int i = 0; i < ways; i++) {
+        if (!(flags[i] & CacheStorage::Valid)) {
+            return i;
+        }
+        if (counters[i] > counters[victim]) {
+            victim = i;
+        }
+    }
+    // The set is aged until the victim is predicted distant, in one step, once the victim is replaced
+    m_victimAging = m_maxRrpv - counters[victim];
+    return victim;
+}
+
+void RripPolicy::updateCacheSetReplFields(CacheStorage& storage, unsigned setIdx,
+                                          unsigned wayIdx, bool isHit) {
+    m_lastUpdate = ReplUpdate();
+    if (isHit) {
+        m_victimAging = 0;
+        storage.setCounter(setIdx, wayIdx, 0);
+        return;
+    }
+    if (m_victimAging != 0) {
+        unsigned* counters = storage.counters(setIdx);
+        for (int i = 0; i < ways; i++) {
+            counters[i] += static_cast<unsigned>(i) != wayIdx ? m_victimAging : 0;
+        }
+        m_lastUpdate.aging = static_cast<uint8_t>(m_victimAging);
+        m_victimAging = 0;
+    }
+    // Bimodal insertion: 1 in m_bimodalThrottle misses is inserted long instead of distant
+    const bool distant =
+        m_insertion == Insertion::Bimodal && (m_bimodalThrottle == 0 || m_rng() % m_bimodalThrottle != 0);
+    storage.setCounter(setIdx, wayIdx, distant ? m_maxRrpv : m_maxRrpv - 1);
+}
+
+void RripPolicy::revertCacheSetReplFields(CacheStorage& storage,
+                                          const CacheWay &oldWay,
+                                          unsigned setIdx, unsigned wayIdx) {
+    storage.setCounter(setIdx, wayIdx, oldWay.counter);
+}
+
+void RripPolicy::undoCacheSetReplFields(CacheStorage& storage, const CacheWay& oldWay, unsigned setIdx,
+                                        unsigned wayIdx, const ReplUpdate& update) {
+    revertCacheSetReplFields(storage, oldWay, setIdx, wayIdx);
+    if (update.aging != 0) {
+        unsigned* counters = storage.counters(setIdx);
+        for (int i = 0; i < ways; i++) {
+            counters[i] -= static_cast<unsigned>(i) != wayIdx ? update.aging : 0;
+        }
+    }
+}
+
+unsigned RripPolicy::getCacheSetReplCounter(const CacheStorage& storage, unsigned setIdx, unsigned wayIdx) const {
+    return storage.valid(setIdx, wayIdx) ? storage.counter(setIdx, wayIdx) : m_maxRrpv;
+}
+
+NextUseOracle::NextUseOracle(const std::vector<uint32_t>& lineAddresses) : m_nextUse(lineAddresses.size()) {
+    assert(lineAddresses.size() < s_never && "Access stream too long for the next-use oracle");
+    std::unordered_map<uint32_t, uint32_t> nextAccess;
+    for (size_t i = lineAddresses.size(); i-- > 0;) {
+        auto it = nextAccess.emplace(lineAddresses[i], s_never).first;
+        m_nextUse[i] = it->second;
+        it->second = static_cast<uint32_t>(i);
+    }
+}
+
+unsigned OptPolicy::locateEvictionWay(CacheStorage& storage, unsigned setIdx) {
+    const uint8_t* flags = storage.flags(setIdx);
+    const unsigned* counters = storage.counters(setIdx);
+    // If there is an invalid cache way, select that. Else, select the way which is next used furthest in the future.
+    unsigned victim = 0;
+    for (int i = 0; i < ways; i++) {
+        if (!(flags[i] & CacheStorage::Valid)) {
+            return i;
+        }
+        if (counters[i] > counters[victim]) {
+            victim = i;
+        }
+    }
+    return victim;
+}
+
+void OptPolicy::updateCacheSetReplFields(CacheStorage& storage, unsigned setIdx, unsigned wayIdx, bool /*isHit*/) {
+    storage.setCounter(setIdx, wayIdx, m_oracle ? m_oracle->nextUse(m_position) : NextUseOracle::s_never);
+}
+
+void OptPolicy::revertCacheSetReplFields(CacheStorage& storage, const CacheWay& oldWay, unsigned setIdx,
+                                         unsigned wayIdx) {
+    storage.setCounter(setIdx, wayIdx, oldWay.counter);
+}
+
+SetDueling::SetDueling(unsigned sets, unsigned leaderSets, unsigned pselBits)
+    : m_roles(sets, Follower), m_pselBits(pselBits), m_psel((1u << (pselBits - 1)) - 1) {
+    assert(pselBits >= 1 && pselBits <= 16 && "Invalid PSEL width");
+    const unsigned leaders = std::min(leaderSets, sets / 4);
+    if (leaders == 0) {
+        return;
+    }
+    // Rank the sets by a hash of their index, and let the lowest ranked sets lead
+    auto hash = [](uint32_t x) {
+        x *= 0x9E3779B1u;
+        x ^= x >> 16;
+        x *= 0x85EBCA6Bu;
+        x ^= x >> 13;
+        return x;
+    };
+    std::vector<std::pair<uint32_t, unsigned>> ranked(sets);
+    for (unsigned i = 0; i < sets; i++) {
+        ranked[i] = {hash(i), i};
+    }
+    std::partial_sort(ranked.begin(), ranked.begin() + 2 * leaders, ranked.end());
+    for (unsigned i = 0; i < leaders; i++) {
+        m_roles[ranked[2 * i].second] = FirstLeader;
+        m_roles[ranked[2 * i + 1].second] = SecondLeader;
+    }
+}
+
+int SetDueling::recordMiss(unsigned setIdx) {
+    int delta = 0;
+    switch (m_roles[setIdx]) {
+        case FirstLeader:
+            // A miss of the first policy votes for the second
+            delta = m_psel < (1u << m_pselBits) - 1 ? 1 : 0;
+            break;
+        case SecondLeader:
+            delta = m_psel > 0 ? -1 : 0;
+            break;
+        default:
+            break;
+    }
+    m_psel += delta;
+    return delta;
+}
+
 }
@@ -2,88 +2,391 @@
 #define CACHE_POLICY_OBJECT_H
 
 #include "cache_organize_component.h"
+#include <cstdint>
 #include <iostream>
+#include <memory>
+#include <random>
+#include <utility>
+#include <vector>
 
 namespace Ripes {
 
+/**
+ * @brief The ReplUpdate struct
+ * Policy state outside of the storage which an updateCacheSetReplFields() call changed, as returned by
+ * CachePolicyBase::lastUpdate(), along with changes to the other ways of the set which can be reverted arithmetically.
+ */
+struct ReplUpdate {
+    int8_t pselDelta = 0;  // Change of the PSEL counter
+    bool second = false;   // The second policy performed the update
+    uint8_t aging = 0;     // RRPV added to the other ways of the set upon a fill (RRIP)
+};
+
 class CachePolicyBase
 {
 public:
+    /**
+     * @brief s_updatesSetCounters
+     * Set by policies whose updateCacheSetReplFields() changes the counters of other ways of the set than the accessed
+     * one, in a manner which cannot be reverted from the old state of the accessed way alone. The undo log then holds
+     * the counters of the whole set for every access, and restores them after revertCacheSetReplFields().
+     */
+    static constexpr bool s_updatesSetCounters = false;
+
     CachePolicyBase(int number_ways, int number_sets, int number_blocks): ways(number_ways), sets(number_sets), blocks(number_blocks) {}
-    virtual void locateEvictionWay(std::pair<unsigned, CacheWay*>& ew, CacheSet& cacheSet, unsigned setIdx) = 0;
-    virtual void updateCacheSetReplFields(CacheSet& cacheSet, unsigned int setIdx, unsigned wayIdx, bool isHit) = 0;
-    virtual void revertCacheSetReplFields(CacheSet& cacheSet, const CacheWay& oldWay, unsigned wayIdx) = 0;
+    virtual unsigned locateEvictionWay(CacheStorage& storage, unsigned setIdx) = 0;
+    virtual void updateCacheSetReplFields(CacheStorage& storage, unsigned setIdx, unsigned wayIdx, bool isHit) = 0;
+    virtual void revertCacheSetReplFields(CacheStorage& storage, const CacheWay& oldWay, unsigned setIdx, unsigned wayIdx) = 0;
+    /**
+     * @brief invalidateCacheSetReplFields
+     * Called before the valid way @p wayIdx of set @p setIdx is invalidated outside of a replacement, ie. when a line
+     * is removed by another cache level. Policies whose fields must stay consistent across the valid ways of a set
+     * override this.
+     */
+    virtual void invalidateCacheSetReplFields(CacheStorage& /*storage*/, unsigned /*setIdx*/, unsigned /*wayIdx*/) {}
+    /**
+     * @brief getCacheSetReplCounter
+     * Replacement counter of way @p wayIdx in set @p setIdx, as displayed to the user. Policies which do not keep their
+     * counters in the counter column of the storage override this.
+     */
+    virtual unsigned getCacheSetReplCounter(const CacheStorage& storage, unsigned setIdx, unsigned wayIdx) const {
+        return storage.counter(setIdx, wayIdx);
+    }
+    /**
+     * @brief lastUpdate
+     * Policy state outside of the storage changed by the last updateCacheSetReplFields() call. Recorded along with
+     * the access, and passed back to undoCacheSetReplFields() once the access is undone.
+     */
+    virtual ReplUpdate lastUpdate() const { return ReplUpdate(); }
+    /**
+     * @brief undoCacheSetReplFields
+     * Reverts an access to way @p wayIdx of set @p setIdx, which performed @p update. Policies which keep state outside
+     * of the storage override this; all others only revert the replacement fields.
+     */
+    virtual void undoCacheSetReplFields(CacheStorage& storage, const CacheWay& oldWay, unsigned setIdx,
+                                        unsigned wayIdx, const ReplUpdate& /*update*/) {
+        revertCacheSetReplFields(storage, oldWay, setIdx, wayIdx);
+    }
     virtual ~CachePolicyBase() {}
 protected:
+    /**
+     * @brief locateLruWay
+     * Victim selection shared by all counter-based policies: the first invalid way of the set if any, else the way
+     * whose counter holds the maximum value (ways - 1).
+     */
+    unsigned locateLruWay(const CacheStorage& storage, unsigned setIdx) const;
+
     int ways;
     int sets;
     int blocks;
 };
 
-class RandomPolicy : public CachePolicyBase {
+class RandomPolicy final : public CachePolicyBase {
 public:
     RandomPolicy(int number_ways, int number_sets, int number_blocks) : CachePolicyBase(number_ways, number_sets, number_blocks) {}
-    void locateEvictionWay(std::pair<unsigned, CacheWay*>& ew, CacheSet& cacheSet, unsigned setIdx) override;
-    void updateCacheSetReplFields(CacheSet& cacheSet, unsigned int setIdx, unsigned wayIdx, bool isHit) override;
-    void revertCacheSetReplFields(CacheSet& cacheSet, const CacheWay& oldWay, unsigned wayIdx) override;
+    unsigned locateEvictionWay(CacheStorage& storage, unsigned setIdx) override;
+    void updateCacheSetReplFields(CacheStorage& storage, unsigned setIdx, unsigned wayIdx, bool isHit) override;
+    void revertCacheSetReplFields(CacheStorage& storage, const CacheWay& oldWay, unsigned setIdx, unsigned wayIdx) override;
     ~RandomPolicy() {}
+private:
+    // Per-instance generator, such that independent caches may be simulated concurrently and reproducibly
+    std::minstd_rand m_rng;
 };
 
 
-class LruPolicy : public CachePolicyBase {
+/**
+ * @brief The LruPolicy class
+ * True LRU in constant time per access. Each set keeps an intrusive doubly-linked list of its ways, ordered from the most
+ * recently used way (head) to the least recently used way (tail). Invalid ways are always kept at the tail end of the
+ * list, such that the tail is the victim way of the set.
+ *
+ * Instead of the recency rank, the counter column holds an age stamp, which decreases with every access: of any group
+ * of ways, the least recently used one holds the largest counter, and invalid ways hold the maximum value. This keeps
+ * counters comparable across sets, as required by the victim selection of skewed-associative caches, and allows undo
+ * to reinsert a way at its former position in the list.
+ */
+class LruPolicy final : public CachePolicyBase {
 public:
-    LruPolicy(int number_ways, int number_sets, int number_blocks) : CachePolicyBase(number_ways, number_sets, number_blocks) {}
-    void locateEvictionWay(std::pair<unsigned, CacheWay*>& ew, CacheSet& cacheSet, unsigned setIdx) override;
-    void updateCacheSetReplFields(CacheSet& cacheSet, unsigned int setIdx, unsigned wayIdx, bool isHit) override;
-    void revertCacheSetReplFields(CacheSet& cacheSet, const CacheWay& oldWay, unsigned wayIdx) override;
+    LruPolicy(int number_ways, int number_sets, int number_blocks);
+    unsigned locateEvictionWay(CacheStorage& storage, unsigned setIdx) override;
+    void updateCacheSetReplFields(CacheStorage& storage, unsigned setIdx, unsigned wayIdx, bool isHit) override;
+    void revertCacheSetReplFields(CacheStorage& storage, const CacheWay& oldWay, unsigned setIdx, unsigned wayIdx) override;
+    void invalidateCacheSetReplFields(CacheStorage& storage, unsigned setIdx, unsigned wayIdx) override;
+    /**
+     * @brief getCacheSetReplCounter
+     * The recency rank of the way (0 being the most recently used way), found by walking the list of the set.
+     */
+    unsigned getCacheSetReplCounter(const CacheStorage& storage, unsigned setIdx, unsigned wayIdx) const override;
     ~LruPolicy() {}
+private:
+    static constexpr unsigned s_none = static_cast<unsigned>(-1);
+    static constexpr unsigned s_invalidStamp = static_cast<unsigned>(-1);
+
+    unsigned* prevOf(unsigned setIdx) { return &m_prev[setIdx * ways]; }
+    unsigned* nextOf(unsigned setIdx) { return &m_next[setIdx * ways]; }
+    void unlink(unsigned setIdx, unsigned wayIdx);
+    // Links @p wayIdx in front of @p before, or at the tail if @p before is s_none
+    void insertBefore(unsigned setIdx, unsigned wayIdx, unsigned before);
+    unsigned nextStamp(CacheStorage& storage);
+    /**
+     * @brief renumberStamps
+     * Reassigns the stamps of all valid ways in the cache, preserving their order, once the stamps have run out.
+     */
+    void renumberStamps(CacheStorage& storage);
+
+    AlignedVector<unsigned> m_prev;
+    AlignedVector<unsigned> m_next;
+    AlignedVector<unsigned> m_head;
+    AlignedVector<unsigned> m_tail;
+    unsigned m_stamp = s_invalidStamp - 1;
 };
 
-class LruLipPolicy : public CachePolicyBase {
+/**
+ * @brief The LruLipPolicy class
+ * LRU insertion policy: missing lines are inserted at the LRU position, hits are promoted to the MRU position. With a
+ * non-zero bimodal throttle, 1 in @p bimodalThrottle insertions are made at the MRU position instead (BIP); a throttle
+ * of 1 thereby yields plain LRU insertion.
+ */
+class LruLipPolicy final : public CachePolicyBase {
 public:
-    LruLipPolicy(int number_ways ,int number_sets, int number_blocks) :
-        CachePolicyBase(number_ways, number_sets, number_blocks){}
-    void locateEvictionWay(std::pair<unsigned, CacheWay*>& ew, CacheSet& cacheSet, unsigned setIdx) override;
-    void updateCacheSetReplFields(CacheSet& cacheSet, unsigned int setIdx, unsigned wayIdx, bool isHit) override;
-    void revertCacheSetReplFields(CacheSet& cacheSet, const CacheWay& oldWay, unsigned wayIdx) override;
+    // Every access ages the other valid ways of the set, saturating at the LRU position
+    static constexpr bool s_updatesSetCounters = true;
+
+    LruLipPolicy(int number_ways ,int number_sets, int number_blocks, unsigned bimodalThrottle = 0) :
+        CachePolicyBase(number_ways, number_sets, number_blocks), m_bimodalThrottle(bimodalThrottle) {}
+    unsigned locateEvictionWay(CacheStorage& storage, unsigned setIdx) override;
+    void updateCacheSetReplFields(CacheStorage& storage, unsigned setIdx, unsigned wayIdx, bool isHit) override;
+    void revertCacheSetReplFields(CacheStorage& storage, const CacheWay& oldWay, unsigned setIdx, unsigned wayIdx) override;
     ~LruLipPolicy() {}
+private:
+    unsigned m_bimodalThrottle;
+    std::minstd_rand m_rng;
 };
 
-class DipPolicy : public CachePolicyBase {
+
+class PlruPolicy final : public CachePolicyBase {
 public:
-    DipPolicy(int number_ways, int number_sets, int number_blocks) : CachePolicyBase(number_ways, number_sets, number_blocks) {
-        PSEL = 0;
+    PlruPolicy(int number_ways, int number_sets, int number_blocks) : CachePolicyBase(number_ways, number_sets, number_blocks) {
+        // One binary tree of (ways - 1) nodes per set, stored back to back
+        PlruTree.assign(number_sets * (number_ways - 1), 0);
     }
-    void locateEvictionWay(std::pair<unsigned, CacheWay*>& ew, CacheSet& cacheSet, unsigned setIdx) override;
-    void updateCacheSetReplFields(CacheSet& cacheSet, unsigned int setIdx, unsigned wayIdx, bool isHit) override;
-    void revertCacheSetReplFields(CacheSet& cacheSet, const CacheWay& oldWay, unsigned wayIdx) override;
-    ~DipPolicy() {}
+    unsigned locateEvictionWay(CacheStorage& storage, unsigned setIdx) override;
+    void updateCacheSetReplFields(CacheStorage& storage, unsigned setIdx, unsigned wayIdx, bool isHit) override;
+    void revertCacheSetReplFields(CacheStorage& storage, const CacheWay& oldWay, unsigned setIdx, unsigned wayIdx) override;
+    ~PlruPolicy() {}
 private: 
-    // 2-bit saturate counter
-    // if 0 <= PSEL <= 1, choose LRU; if 2 <= PSEL <= 3, choose LRU-LIP
-    // if set 0 miss, PSEL ++; if set 1 miss, PSEL --
-    int PSEL = 0; 
-    // since we use a saturate counter, the adaptibility is promised, so we do not reset the periodically
+    uint8_t* treeOf(unsigned setIdx) { return &PlruTree[setIdx * (ways - 1)]; }
+    AlignedVector<uint8_t> PlruTree;
 };
 
+/**
+ * @brief The RripPolicy class
+ * Re-reference interval prediction (Jaleel et al., ISCA 2010). Each way holds an M-bit re-reference prediction value
+ * (RRPV) in the counter column of the storage; 0 predicts a near-immediate re-reference, and the maximum value a distant
+ * one. Hits promote a way to RRPV 0. The victim is the first invalid way, or else the first way with the largest RRPV,
+ * which takes the least aging to be predicted distant. The victim search does not modify the set; the set is aged by
+ * that amount only once a line is actually filled into the victim, and the aging is recorded in the ReplUpdate of the
+ * fill such that undo can subtract it again.
+ *
+ * The insertion RRPV of a missing line depends on the insertion policy:
+ * - Static (SRRIP): a long re-reference interval (maximum - 1).
+ * - Bimodal (BRRIP): distant (maximum), except for 1 in @p bimodalThrottle insertions which are long.
+ * DRRIP duels the two; see DuelingPolicy.
+ */
+class RripPolicy final : public CachePolicyBase {
+public:
+    enum class Insertion { Static, Bimodal };
+
+    static constexpr unsigned s_maxRrpvBits = 8;
+
+    /**
+     * @p rrpvBits is the width M of the RRPV, of 1 up to s_maxRrpvBits bits.
+     */
+    RripPolicy(int number_ways, int number_sets, int number_blocks, Insertion insertion, unsigned bimodalThrottle = 32,
+               unsigned rrpvBits = 2);
+    unsigned locateEvictionWay(CacheStorage& storage, unsigned setIdx) override;
+    void updateCacheSetReplFields(CacheStorage& storage, unsigned setIdx, unsigned wayIdx, bool isHit) override;
+    void revertCacheSetReplFields(CacheStorage& storage, const CacheWay& oldWay, unsigned setIdx, unsigned wayIdx) override;
+    ReplUpdate lastUpdate() const override { return m_lastUpdate; }
+    void undoCacheSetReplFields(CacheStorage& storage, const CacheWay& oldWay, unsigned setIdx, unsigned wayIdx,
+                                const ReplUpdate& update) override;
+    unsigned getCacheSetReplCounter(const CacheStorage& storage, unsigned setIdx, unsigned wayIdx) const override;
+    ~RripPolicy() {}
+private:
+    Insertion m_insertion;
+    unsigned m_bimodalThrottle;
+    unsigned m_maxRrpv;
+    // Aging required by the victim last located, applied by the fill which follows
+    unsigned m_victimAging = 0;
+    ReplUpdate m_lastUpdate;
+    std::minstd_rand m_rng;
+};
 
-class PlruPolicy : public CachePolicyBase {
+/**
+ * @brief The NextUseOracle class
+ * Future knowledge of an access stream, for the OPT policy: for each access, the position of the next access to the
+ * same line. Computed in a single backward pass over the stream of line addresses.
+ */
+class NextUseOracle {
 public:
-    PlruPolicy(int number_ways, int number_sets, int number_blocks) : CachePolicyBase(number_ways, number_sets, number_blocks) {
-        PlruTree = new bool*[number_sets];
-        for(int i=0; i<number_sets; i++) {
-            PlruTree[i] = new bool[number_ways - 1](); // use an array to represent the BST
-            //memset(PlruTree[i], 0, sizeof(PlruTree[i]));
+    static constexpr uint32_t s_never = UINT32_MAX;
+
+    explicit NextUseOracle(const std::vector<uint32_t>& lineAddresses);
+
+    /**
+     * @brief nextUse
+     * @returns the position of the next access to the line accessed at @p position, or s_never if the line is not
+     * accessed again, or @p position lies beyond the stream.
+     */
+    uint32_t nextUse(uint64_t position) const { return position < m_nextUse.size() ? m_nextUse[position] : s_never; }
+    size_t size() const { return m_nextUse.size(); }
+
+private:
+    std::vector<uint32_t> m_nextUse;
+};
+
+/**
+ * @brief The OptPolicy class
+ * Belady's optimal replacement policy, for offline analysis of a known access stream. The counter column of each way
+ * holds the position of the next access to its line; the victim is the first invalid way, or else the way whose line
+ * is next accessed furthest in the future. The engine seeks the policy to the position of every access before
+ * performing it.
+ */
+class OptPolicy final : public CachePolicyBase {
+public:
+    OptPolicy(int number_ways, int number_sets, int number_blocks, std::shared_ptr<const NextUseOracle> oracle)
+        : CachePolicyBase(number_ways, number_sets, number_blocks), m_oracle(std::move(oracle)) {}
+    void seek(uint64_t position) { m_position = position; }
+    unsigned locateEvictionWay(CacheStorage& storage, unsigned setIdx) override;
+    void updateCacheSetReplFields(CacheStorage& storage, unsigned setIdx, unsigned wayIdx, bool isHit) override;
+    void revertCacheSetReplFields(CacheStorage& storage, const CacheWay& oldWay, unsigned setIdx, unsigned wayIdx) override;
+    ~OptPolicy() {}
+private:
+    std::shared_ptr<const NextUseOracle> m_oracle;
+    uint64_t m_position = 0;
+};
+
+/**
+ * @brief The SetDueling class
+ * Set dueling monitor (Qureshi et al., ISCA 2007). A number of leader sets is dedicated to each of two competing
+ * policies. Misses in the leader sets of the first policy increment a saturating PSEL counter, and misses in the leader
+ * sets of the second policy decrement it; the most significant bit of PSEL then selects the policy of all remaining
+ * (follower) sets.
+ *
+ * Leader sets are the sets with the lowest values of a hash of the set index, such that they are spread across the
+ * cache irrespective of its size. At most a quarter of the sets leads each policy, such that at least half of the sets
+ * follow; a cache of less than four sets has no leaders and uses the first policy throughout. PSEL starts just below
+ * its midpoint, favouring the first policy.
+ */
+class SetDueling {
+public:
+    SetDueling(unsigned sets, unsigned leaderSets, unsigned pselBits);
+
+    /**
+     * @brief recordMiss
+     * Records a miss in @p setIdx, updating PSEL if the set is a leader set. @returns the change of PSEL, which is 0
+     * for follower sets and once PSEL saturates.
+     */
+    int recordMiss(unsigned setIdx);
+    /**
+     * @brief undoMiss
+     * Reverts a miss whose recordMiss() call changed PSEL by @p delta.
+     */
+    void undoMiss(int delta) { m_psel -= delta; }
+
+    /**
+     * @brief usesSecond
+     * @returns true if @p setIdx is currently to use the second policy.
+     */
+    bool usesSecond(unsigned setIdx) const {
+        const uint8_t role = m_roles[setIdx];
+        return role == Follower ? (m_psel >> (m_pselBits - 1)) != 0 : role == SecondLeader;
+    }
+
+    unsigned psel() const { return m_psel; }
+
+private:
+    enum Role : uint8_t { Follower, FirstLeader, SecondLeader };
+
+    std::vector<uint8_t> m_roles;
+    unsigned m_pselBits;
+    unsigned m_psel;
+};
+
+/**
+ * @brief The DuelingPolicy class
+ * Duels two replacement policies through set dueling. Both policies operate on the same replacement fields of the
+ * storage, and must thereby agree on their meaning; they differ in how they insert or promote lines. Each access is
+ * handled by the policy which the set currently uses.
+ */
+template <typename First, typename Second>
+class DuelingPolicy final : public CachePolicyBase {
+public:
+    static constexpr bool s_updatesSetCounters = First::s_updatesSetCounters || Second::s_updatesSetCounters;
+
+    DuelingPolicy(int number_ways, int number_sets, int number_blocks, First first, Second second, unsigned leaderSets,
+                  unsigned pselBits)
+        : CachePolicyBase(number_ways, number_sets, number_blocks),
+          m_first(std::move(first)),
+          m_second(std::move(second)),
+          m_dueling(number_sets, leaderSets, pselBits) {}
+    unsigned locateEvictionWay(CacheStorage& storage, unsigned setIdx) override {
+        return m_dueling.usesSecond(setIdx) ? m_second.locateEvictionWay(storage, setIdx)
+                                            : m_first.locateEvictionWay(storage, setIdx);
+    }
+    void updateCacheSetReplFields(CacheStorage& storage, unsigned setIdx, unsigned wayIdx, bool isHit) override {
+        // The access is completed by the policy which located its victim, before the miss may flip PSEL
+        const bool second = m_dueling.usesSecond(setIdx);
+        const int8_t pselDelta = isHit ? 0 : static_cast<int8_t>(m_dueling.recordMiss(setIdx));
+        if (second) {
+            m_second.updateCacheSetReplFields(storage, setIdx, wayIdx, isHit);
+            m_lastUpdate = m_second.lastUpdate();
+        } else {
+            m_first.updateCacheSetReplFields(storage, setIdx, wayIdx, isHit);
+            m_lastUpdate = m_first.lastUpdate();
         }
+        m_lastUpdate.pselDelta = pselDelta;
+        m_lastUpdate.second = second;
     }
-    void locateEvictionWay(std::pair<unsigned, CacheWay*>& ew, CacheSet& cacheSet, unsigned setIdx) override;
-    void updateCacheSetReplFields(CacheSet& cacheSet, unsigned int setIdx, unsigned wayIdx, bool isHit) override;
-    void revertCacheSetReplFields(CacheSet& cacheSet, const CacheWay& oldWay, unsigned wayIdx) override;
-    ~PlruPolicy() {}
-private: 
-    bool **PlruTree;
+    void revertCacheSetReplFields(CacheStorage& storage, const CacheWay& oldWay, unsigned setIdx,
+                                  unsigned wayIdx) override {
+        revertWith(m_dueling.usesSecond(setIdx), storage, oldWay, setIdx, wayIdx);
+    }
+    ReplUpdate lastUpdate() const override { return m_lastUpdate; }
+    void undoCacheSetReplFields(CacheStorage& storage, const CacheWay& oldWay, unsigned setIdx, unsigned wayIdx,
+                                const ReplUpdate& update) override {
+        // The fields are reverted by the policy which updated them, whichever policy the set uses by now
+        if (update.second) {
+            m_second.undoCacheSetReplFields(storage, oldWay, setIdx, wayIdx, update);
+        } else {
+            m_first.undoCacheSetReplFields(storage, oldWay, setIdx, wayIdx, update);
+        }
+        m_dueling.undoMiss(update.pselDelta);
+    }
+    unsigned getCacheSetReplCounter(const CacheStorage& storage, unsigned setIdx, unsigned wayIdx) const override {
+        return m_first.getCacheSetReplCounter(storage, setIdx, wayIdx);
+    }
+    const SetDueling& getDueling() const { return m_dueling; }
+    ~DuelingPolicy() {}
+
+private:
+    void revertWith(bool second, CacheStorage& storage, const CacheWay& oldWay, unsigned setIdx, unsigned wayIdx) {
+        if (second) {
+            m_second.revertCacheSetReplFields(storage, oldWay, setIdx, wayIdx);
+        } else {
+            m_first.revertCacheSetReplFields(storage, oldWay, setIdx, wayIdx);
+        }
+    }
+
+    First m_first;
+    Second m_second;
+    SetDueling m_dueling;
+    ReplUpdate m_lastUpdate;
 };
 
+// DIP: LRU versus bimodal insertion. DRRIP: static versus bimodal RRIP.
+using DipPolicy = DuelingPolicy<LruLipPolicy, LruLipPolicy>;
+using DrripPolicy = DuelingPolicy<RripPolicy, RripPolicy>;
 
 }
 
@@ -1,6 +1,7 @@
 #include "cacheconfigwidget.h"
 #include "ui_cacheconfigwidget.h"
 
+#include <QCheckBox>
 #include <QMessageBox>
 #include <QPushButton>
 #include <QSpinBox>
@@ -16,8 +17,11 @@ CacheConfigWidget::CacheConfigWidget(QWidget* parent) : QWidget(parent), m_ui(ne
     m_ui->setupUi(this);
 
     // Gather a list of all items in this widget which will trigger a modification to the current configuration
-    m_configItems = {m_ui->presets,           m_ui->ways,   m_ui->sets, m_ui->blocks,
-                     m_ui->replacementPolicy, m_ui->wrMiss, m_ui->wrHit, m_ui->skewed};
+    m_configItems = {m_ui->presets,           m_ui->ways,       m_ui->sets,        m_ui->blocks,
+                     m_ui->replacementPolicy, m_ui->wrMiss,     m_ui->wrHit,       m_ui->skewed, m_ui->skewHash,
+                     m_ui->hitLatency,        m_ui->missPenalty, m_ui->writebackPenalty, m_ui->prefetcher,
+                     m_ui->victimEntries,     m_ui->writeBufferDepth, m_ui->drainCycles, m_ui->sectorNeighbors,
+                     m_ui->relocationLevels,  m_ui->missHeatmap};
 }
 
 void CacheConfigWidget::setCache(CacheSim* cache) {
@@ -34,6 +38,8 @@ void CacheConfigWidget::setCache(CacheSim* cache) {
     setupEnumCombobox(m_ui->wrHit, s_cacheWritePolicyStrings);
     setupEnumCombobox(m_ui->wrMiss, s_cacheWriteAllocateStrings);
     setupEnumCombobox(m_ui->skewed, s_cacheSkewedAssocStrings);
+    setupEnumCombobox(m_ui->skewHash, s_skewHashStrings);
+    setupEnumCombobox(m_ui->prefetcher, s_prefetcherStrings);
 
     m_ui->ways->setValue(m_cache->getWaysBits());
     m_ui->sets->setValue(m_cache->getSetBits());
@@ -46,8 +52,26 @@ void CacheConfigWidget::setCache(CacheSim* cache) {
     connect(m_ui->ways, QOverload<int>::of(&QSpinBox::valueChanged), m_cache, &CacheSim::setWays);
     connect(m_ui->blocks, QOverload<int>::of(&QSpinBox::valueChanged), m_cache, &CacheSim::setBlocks);
     connect(m_ui->sets, QOverload<int>::of(&QSpinBox::valueChanged), m_cache, &CacheSim::setSets);
+    connect(m_ui->victimEntries, QOverload<int>::of(&QSpinBox::valueChanged), m_cache, &CacheSim::setVictimBuffer);
+    for (auto* writeBufferItem : {m_ui->writeBufferDepth, m_ui->drainCycles}) {
+        connect(writeBufferItem, QOverload<int>::of(&QSpinBox::valueChanged), this,
+                &CacheConfigWidget::updateWriteBuffer);
+    }
+    connect(m_ui->sectorNeighbors, QOverload<int>::of(&QSpinBox::valueChanged), [=](int neighbors) {
+        // The special value below 0 disables sectoring
+        CacheSim::SectorConfig config;
+        config.enabled = neighbors >= 0;
+        config.neighbors = config.enabled ? neighbors : 0;
+        m_cache->setSectoring(config);
+    });
+    connect(m_ui->relocationLevels, QOverload<int>::of(&QSpinBox::valueChanged), m_cache, &CacheSim::setRelocation);
+    connect(m_ui->missHeatmap, &QCheckBox::toggled, m_cache, &CacheSim::setSetProfiling);
     connect(m_ui->sizeBreakdownButton, &QPushButton::clicked, this, &CacheConfigWidget::showSizeBreakdown);
 
+    for (auto* latencyItem : {m_ui->hitLatency, m_ui->missPenalty, m_ui->writebackPenalty}) {
+        connect(latencyItem, QOverload<int>::of(&QSpinBox::valueChanged), this, &CacheConfigWidget::updateLatency);
+    }
+
     connect(m_ui->replacementPolicy, QOverload<int>::of(&QComboBox::currentIndexChanged), [=](int index) {
         m_cache->setReplacementPolicy(qvariant_cast<CacheSim::ReplPolicy>(m_ui->replacementPolicy->itemData(index)));
     });
@@ -60,6 +84,12 @@ void CacheConfigWidget::setCache(CacheSim* cache) {
     connect(m_ui->skewed, QOverload<int>::of(&QComboBox::currentIndexChanged), [=](int index) {
         m_cache->setSkewedAssocPolicy(qvariant_cast<CacheSim::SkewedAssocPolicy>(m_ui->skewed->itemData(index)));
     });
+    connect(m_ui->skewHash, QOverload<int>::of(&QComboBox::currentIndexChanged), [=](int index) {
+        m_cache->setSkewHash(qvariant_cast<SkewHashType>(m_ui->skewHash->itemData(index)));
+    });
+    connect(m_ui->prefetcher, QOverload<int>::of(&QComboBox::currentIndexChanged), [=](int index) {
+        m_cache->setPrefetcher(qvariant_cast<PrefetcherType>(m_ui->prefetcher->itemData(index)));
+    });
 
     connect(m_cache, &CacheSim::configurationChanged, this, &CacheConfigWidget::handleConfigurationChanged);
     connect(m_cache, &CacheSim::configurationChanged, [=] { emit configurationChanged(); });
@@ -110,6 +140,21 @@ void CacheConfigWidget::setupPresets() {
 
 void CacheConfigWidget::updateCacheSize() {}
 
+void CacheConfigWidget::updateLatency() {
+    CacheSim::CacheLatency latency;
+    latency.hitLatency = m_ui->hitLatency->value();
+    latency.missPenalty = m_ui->missPenalty->value();
+    latency.writebackPenalty = m_ui->writebackPenalty->value();
+    m_cache->setLatency(latency);
+}
+
+void CacheConfigWidget::updateWriteBuffer() {
+    CacheSim::WriteBufferConfig config = m_cache->getWriteBufferConfig();
+    config.depth = m_ui->writeBufferDepth->value();
+    config.drainCycles = m_ui->drainCycles->value();
+    m_cache->setWriteBuffer(config);
+}
+
 void CacheConfigWidget::handleConfigurationChanged() {
     std::for_each(m_configItems.begin(), m_configItems.end(), [](QObject* o) { o->blockSignals(true); });
 
@@ -120,6 +165,18 @@ void CacheConfigWidget::handleConfigurationChanged() {
     setEnumIndex(m_ui->wrMiss, m_cache->getWriteAllocPolicy());
     setEnumIndex(m_ui->replacementPolicy, m_cache->getReplacementPolicy());
     setEnumIndex(m_ui->skewed, m_cache->getSkewedPolicy());
+    setEnumIndex(m_ui->skewHash, m_cache->getSkewHash());
+    setEnumIndex(m_ui->prefetcher, m_cache->getPrefetcherType());
+    m_ui->victimEntries->setValue(m_cache->getVictimBufferEntries());
+    m_ui->writeBufferDepth->setValue(m_cache->getWriteBufferConfig().depth);
+    m_ui->drainCycles->setValue(m_cache->getWriteBufferConfig().drainCycles);
+    const auto& sectors = m_cache->getSectoring();
+    m_ui->sectorNeighbors->setValue(sectors.enabled ? static_cast<int>(sectors.neighbors) : -1);
+    m_ui->relocationLevels->setValue(m_cache->getRelocationLevels());
+    m_ui->missHeatmap->setChecked(m_cache->getSetProfiling());
+    m_ui->hitLatency->setValue(m_cache->getLatency().hitLatency);
+    m_ui->missPenalty->setValue(m_cache->getLatency().missPenalty);
+    m_ui->writebackPenalty->setValue(m_cache->getLatency().writebackPenalty);
 
     if (!m_justSetPreset) {
         m_ui->presets->setCurrentIndex(-1);
@@ -138,6 +195,29 @@ void CacheConfigWidget::updateHitrate() {
     m_ui->hits->setText(QString::number(m_cache->getHits()));
     m_ui->misses->setText(QString::number(m_cache->getMisses()));
     m_ui->writebacks->setText(QString::number(m_cache->getWritebacks()));
+    m_ui->amat->setText(QString::number(m_cache->getAMAT(), 'G', 4));
+    m_ui->stallCycles->setText(QString::number(m_cache->getStallCycles()));
+
+    const unsigned unreverted = m_cache->getUnrevertedCycles();
+    m_ui->unrevertedWarning->setVisible(unreverted != 0);
+    m_ui->unrevertedWarning->setText(
+        QString("%1 reversed cycle(s) accessed the cache beyond its undo history; the cache contents and statistics "
+                "were not reverted for these. Reset the processor to resynchronize the cache.")
+            .arg(unreverted));
+
+    const auto& stats = m_cache->getEngine().getStatistics();
+    m_ui->prefetches->setText(QString::number(stats.prefetches));
+    m_ui->usefulPrefetches->setText(QString::number(stats.usefulPrefetches));
+    m_ui->latePrefetches->setText(QString::number(stats.latePrefetches));
+    m_ui->pollutingPrefetches->setText(QString::number(stats.pollutingPrefetches));
+    m_ui->victimHits->setText(QString::number(stats.victimHits));
+    m_ui->bufferStalls->setText(QString::number(stats.bufferStallCycles));
+    m_ui->coalescedWrites->setText(QString::number(stats.coalescedWrites));
+    m_ui->bufferDrains->setText(QString::number(stats.bufferDrains));
+    m_ui->sectorMisses->setText(QString::number(stats.sectorMisses));
+    m_ui->fetchedBlocks->setText(QString::number(stats.fetchedBlocks));
+    m_ui->relocations->setText(QString::number(stats.relocations));
+    m_ui->walkCandidates->setText(QString::number(stats.walkCandidates));
 }
 
 void CacheConfigWidget::showSizeBreakdown() {
@@ -146,7 +226,7 @@ void CacheConfigWidget::showSizeBreakdown() {
     const auto cacheSize = m_cache->getCacheSize();
 
     for (const auto& component : cacheSize.components) {
-        sizeText += component + "\n";
+        sizeText += QString::fromStdString(component) + "\n";
     }
 
     sizeText += "\nTotal: " + QString::number(cacheSize.bits) + " Bits";
@@ -28,6 +28,8 @@ public slots:
 
 private:
     void updateCacheSize();
+    void updateLatency();
+    void updateWriteBuffer();
     void updateIndexingText();
     void setupPresets();
     void showSizeBreakdown();
@@ -52,3 +54,5 @@ Q_DECLARE_METATYPE(Ripes::CacheSim::WriteAllocPolicy);
 Q_DECLARE_METATYPE(Ripes::CacheSim::ReplPolicy);
 Q_DECLARE_METATYPE(Ripes::CacheSim::CachePreset);
 Q_DECLARE_METATYPE(Ripes::CacheSim::SkewedAssocPolicy);
+Q_DECLARE_METATYPE(Ripes::PrefetcherType);
+Q_DECLARE_METATYPE(Ripes::SkewHashType);
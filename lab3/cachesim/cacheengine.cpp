@@ -0,0 +1,1148 @@
+#include "cacheengine.h"
+#include "cacheundolog.h"
+
+#include <algorithm>
+#include <iostream>
+#include <type_traits>
+#include <utility>
+
+namespace Ripes {
+
+namespace {
+
+unsigned generateMask(unsigned bits) {
+    return bits >= 32 ? static_cast<unsigned>(-1) : (1u << bits) - 1;
+}
+
+unsigned popcount(unsigned v) {
+    return __builtin_popcount(v);
+}
+
+}  // namespace
+
+CacheEngine::CacheEngine() {
+    reset();
+}
+
+void CacheEngine::setType(CacheType type) {
+    m_type = type;
+    reset();
+}
+
+void CacheEngine::setBlocks(unsigned blocks) {
+    m_blocks = blocks;
+    reset();
+}
+
+void CacheEngine::setSets(unsigned sets) {
+    m_sets = sets;
+    reset();
+}
+
+void CacheEngine::setWays(unsigned ways) {
+    m_ways = ways;
+    reset();
+}
+
+void CacheEngine::setWritePolicy(WritePolicy policy) {
+    m_wrPolicy = policy;
+    reset();
+}
+
+void CacheEngine::setWriteAllocatePolicy(WriteAllocPolicy policy) {
+    m_wrAllocPolicy = policy;
+    reset();
+}
+
+void CacheEngine::setReplacementPolicy(ReplPolicy policy) {
+    m_replPolicy = policy;
+    reset();
+}
+
+void CacheEngine::setSkewedAssocPolicy(SkewedAssocPolicy policy) {
+    m_skewPolicy = policy;
+    reset();
+}
+
+void CacheEngine::setPreset(const CachePreset& preset) {
+    m_blocks = preset.blocks;
+    m_ways = preset.ways;
+    m_sets = preset.sets;
+    m_wrPolicy = preset.wrPolicy;
+    m_wrAllocPolicy = preset.wrAllocPolicy;
+    m_replPolicy = preset.replPolicy;
+    m_skewPolicy = preset.skewPolicy;
+    m_skewHashType = preset.skewHash;
+    assert(preset.relocationLevels <= s_maxRelocationLevels && "Too many relocation levels");
+    m_relocationLevels = preset.relocationLevels;
+    reset();
+}
+
+void CacheEngine::setLatency(const CacheLatency& latency) {
+    // Every access occupies at least the cycle of the pipeline stage performing it
+    assert(latency.hitLatency >= 1 && "Cache hit latency must be at least a single cycle");
+    m_latency = latency;
+    reset();
+}
+
+void CacheEngine::setSetDueling(const SetDuelingConfig& config) {
+    assert(config.pselBits >= 1 && config.pselBits <= 16 && "Invalid PSEL width");
+    assert(config.rrpvBits >= 1 && config.rrpvBits <= RripPolicy::s_maxRrpvBits && "Invalid RRPV width");
+    m_dueling = config;
+    reset();
+}
+
+void CacheEngine::setSkewHash(SkewHashType type) {
+    m_skewHashType = type;
+    reset();
+}
+
+void CacheEngine::setRelocation(unsigned levels) {
+    assert(levels <= s_maxRelocationLevels && "Too many relocation levels");
+    m_relocationLevels = levels;
+    reset();
+}
+
+void CacheEngine::setFutureAccesses(std::shared_ptr<const std::vector<uint32_t>> addresses) {
+    m_futureAccesses = std::move(addresses);
+    reset();
+}
+
+void CacheEngine::setPrefetcher(std::unique_ptr<Prefetcher> prefetcher) {
+    m_prefetcher = std::move(prefetcher);
+    reset();
+}
+
+void CacheEngine::setVictimBuffer(unsigned entries) {
+    m_victimEntries = entries;
+    reset();
+}
+
+void CacheEngine::setWriteBuffer(const WriteBufferConfig& config) {
+    assert(config.depth <= WriteBuffer::s_maxDepth && "Write buffer too deep");
+    m_writeBufferConfig = config;
+    reset();
+}
+
+void CacheEngine::setSectoring(const SectorConfig& config) {
+    m_sectors = config;
+    reset();
+}
+
+void CacheEngine::setSetProfiling(bool enabled) {
+    m_setProfiling = enabled;
+    reset();
+}
+
+void CacheEngine::setMissClassification(bool enabled) {
+    m_missClassification = enabled;
+    reset();
+}
+
+void CacheEngine::reset() {
+    m_sectored = m_sectors.enabled && m_replPolicy != ReplPolicy::NoCache;
+    m_skewHash.configure(m_skewHashType, getSetBits(), 30 - getBlockBits(), isSkewed() ? getWays() : 0);
+    m_compactTags = isSkewed() && m_skewHash.invertible();
+    m_storage.reset(getSets(), getWays(), getBlocks(), m_sectored,
+                    isSkewed() && !m_compactTags ? 30 - getBlockBits() : 30 - getBlockBits() - getSetBits());
+    setReplacementPolicyObject();
+    m_stats = CacheStatistics();
+    m_setStats.assign(m_setProfiling ? m_storage.sets() : 0, SetStatistics());
+    m_classifyMisses = m_missClassification && m_replPolicy != ReplPolicy::NoCache;
+    if (m_classifyMisses) {
+        m_missClassifier.reset(m_storage.sets() * m_storage.ways(), 30 - getBlockBits());
+    }
+    m_prefetchTransactions.clear();
+    m_pollutionFilter.reset();
+    if (m_prefetcher) {
+        m_prefetcher->configure(4u << getBlockBits());
+        m_prefetchReady.assign(static_cast<size_t>(m_storage.sets()) * m_storage.ways(), 0);
+    } else {
+        m_prefetchReady.clear();
+    }
+    m_skewSets.assign(m_skewHash.ways(), 0);
+    m_walk.reserve(s_maxRelocationCandidates);
+    m_relocationPath.reserve(s_maxRelocationLevels);
+    m_victims.reset(m_replPolicy == ReplPolicy::NoCache ? 0 : m_victimEntries);
+    m_writeBuffer.clear();
+    m_drainedWrites.clear();
+    m_chunkWords = std::min<unsigned>(getBlocks(), WriteBuffer::s_maxChunkWords);
+    m_completeAccess =
+        m_replPolicy != ReplPolicy::NoCache && (m_victims.size() != 0 || m_writeBufferConfig.depth != 0);
+
+    // Recalculate masks
+    int bitoffset = 2;  // 2^2 = 4-byte offset (32-bit words in cache)
+
+    m_blockMask = generateMask(getBlockBits()) << bitoffset;
+    bitoffset += getBlockBits();
+
+    m_setMask = generateMask(getSetBits()) << bitoffset;
+    bitoffset += getSetBits();
+
+    m_tagMask = generateMask(32 - bitoffset) << bitoffset;
+}
+
+
+void CacheEngine::revertCacheSetReplFields(const CacheWay& oldWay, unsigned setIdx, unsigned wayIdx,
+                                           const ReplUpdate& update) {
+    this->m_replPolicyObject->undoCacheSetReplFields(m_storage, oldWay, setIdx, wayIdx, update);
+}
+
+unsigned CacheEngine::getReplCounterBits() const {
+    if (m_replPolicy == ReplPolicy::SRRIP || m_replPolicy == ReplPolicy::BRRIP || m_replPolicy == ReplPolicy::DRRIP) {
+        return m_dueling.rrpvBits;
+    }
+    return getWaysBits();
+}
+
+unsigned CacheEngine::getReplCounter(unsigned setIdx, unsigned wayIdx) const {
+    if (!m_replPolicyObject) {
+        return m_storage.counter(setIdx, wayIdx);
+    }
+    return m_replPolicyObject->getCacheSetReplCounter(m_storage, setIdx, wayIdx);
+}
+
+template <typename Policy>
+CacheEngine::AccessFn CacheEngine::selectAccessFn() const {
+    using WP = WritePolicy;
+    using WA = WriteAllocPolicy;
+    const bool skewed = m_skewPolicy == SkewedAssocPolicy::Skewed;
+    if (m_wrPolicy == WP::WriteBack) {
+        if (m_wrAllocPolicy == WA::WriteAllocate) {
+            return skewed ? &CacheEngine::performAccessImpl<Policy, WP::WriteBack, WA::WriteAllocate, true>
+                          : &CacheEngine::performAccessImpl<Policy, WP::WriteBack, WA::WriteAllocate, false>;
+        }
+        return skewed ? &CacheEngine::performAccessImpl<Policy, WP::WriteBack, WA::NoWriteAllocate, true>
+                      : &CacheEngine::performAccessImpl<Policy, WP::WriteBack, WA::NoWriteAllocate, false>;
+    }
+    if (m_wrAllocPolicy == WA::WriteAllocate) {
+        return skewed ? &CacheEngine::performAccessImpl<Policy, WP::WriteThrough, WA::WriteAllocate, true>
+                      : &CacheEngine::performAccessImpl<Policy, WP::WriteThrough, WA::WriteAllocate, false>;
+    }
+    return skewed ? &CacheEngine::performAccessImpl<Policy, WP::WriteThrough, WA::NoWriteAllocate, true>
+                  : &CacheEngine::performAccessImpl<Policy, WP::WriteThrough, WA::NoWriteAllocate, false>;
+}
+
+template <typename Policy, typename DispatchAs, typename... Args>
+void CacheEngine::installPolicy(Args&&... args) {
+    this->m_replPolicyObject = std::make_unique<Policy>(getWays(), getSets(), getBlocks(), std::forward<Args>(args)...);
+    this->m_accessFn = selectAccessFn<DispatchAs>();
+    this->m_recordSetCounters = Policy::s_updatesSetCounters;
+}
+
+void CacheEngine::setReplacementPolicyObject() {
+    this->m_replPolicyObject.reset();
+    this->m_accessFn = &CacheEngine::performUncachedAccess;
+    this->m_recordSetCounters = false;
+    switch (this->m_replPolicy) {
+    case ReplPolicy::Random: installPolicy<RandomPolicy>(); break;
+    case ReplPolicy::LRU: installPolicy<LruPolicy>(); break;
+    case ReplPolicy::LRU_LIP: installPolicy<LruLipPolicy>(); break;
+    case ReplPolicy::PLRU: installPolicy<PlruPolicy>(); break;
+    case ReplPolicy::DIP:
+        installPolicy<DipPolicy>(LruLipPolicy(getWays(), getSets(), getBlocks(), 1),
+                                 LruLipPolicy(getWays(), getSets(), getBlocks(), m_dueling.bimodalThrottle),
+                                 m_dueling.leaderSets, m_dueling.pselBits);
+        break;
+    case ReplPolicy::SRRIP:
+        installPolicy<RripPolicy>(RripPolicy::Insertion::Static, m_dueling.bimodalThrottle, m_dueling.rrpvBits);
+        break;
+    case ReplPolicy::BRRIP:
+        installPolicy<RripPolicy>(RripPolicy::Insertion::Bimodal, m_dueling.bimodalThrottle, m_dueling.rrpvBits);
+        break;
+    case ReplPolicy::DRRIP:
+        installPolicy<DrripPolicy>(RripPolicy(getWays(), getSets(), getBlocks(), RripPolicy::Insertion::Static,
+                                              m_dueling.bimodalThrottle, m_dueling.rrpvBits),
+                                   RripPolicy(getWays(), getSets(), getBlocks(), RripPolicy::Insertion::Bimodal,
+                                              m_dueling.bimodalThrottle, m_dueling.rrpvBits),
+                                   m_dueling.leaderSets, m_dueling.pselBits);
+        break;
+    case ReplPolicy::OPT: {
+        // The oracle is rebuilt for every geometry, given that it tracks reuse at the line granularity
+        std::shared_ptr<const NextUseOracle> oracle;
+        if (m_futureAccesses) {
+            std::vector<uint32_t> lines(m_futureAccesses->size());
+            const unsigned lineShift = 2 + getBlockBits();
+            std::transform(m_futureAccesses->begin(), m_futureAccesses->end(), lines.begin(),
+                           [lineShift](uint32_t address) { return address >> lineShift; });
+            oracle = std::make_shared<NextUseOracle>(lines);
+        }
+        installPolicy<OptPolicy>(std::move(oracle));
+        break;
+    }
+    case ReplPolicy::NoCache: break;
+    // A new policy is added as a ReplPolicy value and a final CachePolicyBase subclass (see cache_policy_object.h),
+    // installed here with installPolicy<NewPolicy>(), which instantiates the access paths specialized for it.
+    default: std::cerr << "unknown policy type" << std::endl; break;
+    }
+}
+
+template <typename Policy>
+unsigned CacheEngine::locateEvictionWay(const CacheTransaction& transaction) {
+    const unsigned wayIdx = policy<Policy>().locateEvictionWay(m_storage, transaction.index.set);
+
+    assert(wayIdx < static_cast<unsigned>(getWays()) && "Unable to locate way for eviction");
+    return wayIdx;
+}
+
+void CacheEngine::evictAndUpdate(CacheTransaction& transaction) {
+    const unsigned setIdx = transaction.index.set;
+    const unsigned wayIdx = transaction.index.way;
+
+    if (!m_storage.valid(setIdx, wayIdx)) {
+        // Record that this was an invalid->valid transition
+        transaction.transToValid = true;
+    } else {
+        transaction.evicted = true;
+        transaction.evictedPrefetched = m_storage.prefetched(setIdx, wayIdx);
+        // The tag of a line moved into the entry by relocate() only holds at the entry it was moved from
+        transaction.evictedAddress =
+            transaction.relocations != 0 ? m_relocatedLineAddress : getEntryLineAddress(setIdx, wayIdx);
+        if (m_storage.dirty(setIdx, wayIdx)) {
+            // The eviction will result in a writeback
+            transaction.isWriteback = true;
+            transaction.evictedDirty = true;
+        }
+        if (m_victims.size() != 0) {
+            m_evictedWay = m_storage.way(setIdx, wayIdx);
+        }
+    }
+    // Invalidate the target way
+    m_storage.invalidate(setIdx, wayIdx);
+    // Set required values in way, reflecting the newly loaded address
+    m_storage.fill(setIdx, wayIdx, getTag(transaction.address));
+    transaction.tagChanged = true;
+}
+
+template <typename Policy>
+void CacheEngine::analyzeCacheAccess(CacheTransaction& transaction) {
+    transaction.index.set = getSetIdx(transaction.address);
+    transaction.index.block = getBlockIdx(transaction.address);
+
+    transaction.index.way = m_storage.findTag(transaction.index.set, getTag(transaction.address));
+    transaction.isHit = transaction.index.way != m_storage.ways();
+    if (!transaction.isHit) {
+        transaction.index.way = locateEvictionWay<Policy>(transaction);
+    }
+}
+
+template <typename Policy>
+void CacheEngine::analyzeCacheAccessSkewedCache(CacheTransaction& transaction) {
+    if (this->m_type == CacheType::InstrCache) {
+        return analyzeCacheAccess<Policy>(transaction);
+    }
+    // ---------------------Part 3. TODO ------------------------------
+    // Implement the skewed-associative cache
+    // If 1 set
+    if (m_sets == 0) {
+        return analyzeCacheAccess<Policy>(transaction);
+    }
+    // If more than one sets
+    transaction.index.block = getBlockIdx(transaction.address);
+    transaction.isHit = false;
+    unsigned max_counter = 0;
+    int num_ways = getWays();
+    const uint32_t tag = getTag(transaction.address);
+    // The set index of every way is computed up front, in a single pass over the hash tables
+    m_skewHash.indices(getLineNumber(transaction.address), m_skewSets.data());
+    for(unsigned way_idx=0; way_idx<(unsigned)num_ways; way_idx++) {
+        unsigned set_idx = m_skewSets[way_idx];
+        if (m_storage.valid(set_idx, way_idx) && (m_storage.tag(set_idx, way_idx) == tag)) { // if hit
+            transaction.index.set = set_idx;
+            transaction.index.way = way_idx;
+            transaction.isHit = true;
+            break;
+        } else { // if miss
+            const unsigned counter = m_storage.counter(set_idx, way_idx);
+            if (counter >= max_counter) {
+                transaction.index.set = set_idx;
+                transaction.index.way = way_idx;
+                max_counter = counter;
+            }
+        }
+    }
+    return;
+}
+
+void CacheEngine::relocate(CacheTransaction& transaction) {
+    if (!m_storage.valid(transaction.index.set, transaction.index.way)) {
+        // A free entry needs no room to be made
+        return;
+    }
+    const unsigned ways = m_storage.ways();
+    m_walk.clear();
+    for (unsigned way = 0; way < ways; way++) {
+        m_walk.push_back({m_skewSets[way], way, s_invalidIndex, 0});
+    }
+
+    // Ties are resolved in favor of the shallowest candidate, which takes the fewest relocations to free
+    unsigned victim = transaction.index.way;
+    unsigned victimCounter = m_storage.counter(transaction.index.set, transaction.index.way);
+    unsigned examined = 0;
+    while (examined < m_walk.size()) {
+        const WalkNode node = m_walk[examined++];
+        if (!m_storage.valid(node.set, node.way)) {
+            victim = examined - 1;
+            break;
+        }
+        const unsigned counter = m_storage.counter(node.set, node.way);
+        if (counter > victimCounter) {
+            victim = examined - 1;
+            victimCounter = counter;
+        }
+        if (node.level == m_relocationLevels) {
+            continue;
+        }
+        // The resident line may move to its own candidate entry in any other way
+        const uint32_t line = getLineNumber(getEntryLineAddress(node.set, node.way));
+        for (unsigned way = 0; way < ways && m_walk.size() < s_maxRelocationCandidates; way++) {
+            const unsigned set = m_skewHash.index(way, line);
+            if (way == node.way || std::any_of(m_walk.begin(), m_walk.end(), [&](const WalkNode& other) {
+                    return other.set == set && other.way == way;
+                })) {
+                continue;
+            }
+            m_walk.push_back({set, way, examined - 1, node.level + 1});
+        }
+    }
+
+    // The path from the first level down to the victim
+    m_relocationPath.resize(m_walk[victim].level);
+    unsigned first = victim;
+    for (unsigned level = m_walk[victim].level; level > 0; level--) {
+        m_relocationPath[level - 1] = {m_walk[first].set, m_walk[first].way, transaction.index.block};
+        first = m_walk[first].parent;
+    }
+    transaction.walkCandidates = examined;
+    transaction.relocations = m_relocationPath.size();
+    m_stats.relocationWalks++;
+    m_stats.walkCandidates += examined;
+    m_stats.relocations += transaction.relocations;
+    m_stats.relocationDepths[transaction.relocations]++;
+    if (transaction.relocations == 0) {
+        transaction.index.set = m_walk[victim].set;
+        transaction.index.way = m_walk[victim].way;
+        return;
+    }
+
+    // Each line on the path moves one level down, and the victim up into the entry of the first level
+    const WalkNode& bottom = m_walk[victim];
+    const CacheWay evicted = m_storage.way(bottom.set, bottom.way);
+    const uint64_t ready = m_prefetchReady.empty() ? 0 : m_prefetchReady[bottom.set * ways + bottom.way];
+    m_relocatedLineAddress = getEntryLineAddress(bottom.set, bottom.way);
+    unsigned to = victim;
+    while (m_walk[to].parent != s_invalidIndex) {
+        const WalkNode& dst = m_walk[to];
+        const WalkNode& src = m_walk[dst.parent];
+        placeLine(dst.set, dst.way, m_storage.way(src.set, src.way),
+                  m_prefetchReady.empty() ? 0 : m_prefetchReady[src.set * ways + src.way]);
+        to = dst.parent;
+    }
+    placeLine(m_walk[first].set, m_walk[first].way, evicted, ready);
+    transaction.index.set = m_walk[first].set;
+    transaction.index.way = m_walk[first].way;
+}
+
+void CacheEngine::placeLine(unsigned setIdx, unsigned wayIdx, const CacheWay& line, uint64_t ready) {
+    m_storage.setWay(setIdx, wayIdx, line);
+    // The policy reorders the entry among its set as per the replacement state it now holds
+    m_replPolicyObject->revertCacheSetReplFields(m_storage, line, setIdx, wayIdx);
+    if (!m_prefetchReady.empty()) {
+        m_prefetchReady[setIdx * m_storage.ways() + wayIdx] = ready;
+    }
+}
+
+CacheEngine::CacheTransaction CacheEngine::access(uint32_t address, AccessType type, CacheUndoLog* log, uint32_t pc) {
+    if (log) {
+        log->beginAccess();
+    }
+    if (m_prefetcher && m_replPolicy != ReplPolicy::NoCache && m_replPolicy != ReplPolicy::OPT) {
+        return prefetchingAccess(address, type, log, pc);
+    }
+    if (m_completeAccess) {
+        CacheTransaction transaction = performAccess(address, type, log, Allocation::Policy, true);
+        completeAccess(transaction, log);
+        return transaction;
+    }
+    return performAccess(address, type, log, Allocation::Policy, true);
+}
+
+void CacheEngine::completeAccess(CacheTransaction& transaction, CacheUndoLog* log) {
+    if (m_victims.size() != 0) {
+        exchangeVictim(transaction, log, true);
+    }
+    if (m_writeBufferConfig.depth != 0) {
+        bufferAccess(transaction, log);
+    }
+}
+
+void CacheEngine::exchangeVictim(CacheTransaction& transaction, CacheUndoLog* log, bool countAccess) {
+    if (transaction.isHit || !transaction.tagChanged) {
+        // Hits and misses without allocation leave the buffer untouched
+        return;
+    }
+    unsigned slot = m_victims.find(getLineAddress(transaction.address));
+    const bool victimHit = slot != VictimBuffer::s_noSlot;
+    if (!victimHit) {
+        if (!transaction.evicted) {
+            return;
+        }
+        slot = m_victims.replacementSlot();
+    }
+    // On a victim hit, this is the accessed line itself; otherwise, the line leaving the buffer to make room for the
+    // evicted line
+    const VictimBuffer::Entry displaced = m_victims.entry(slot);
+    if (log) {
+        log->back().victimSlot = slot;
+        log->back().oldVictim = displaced;
+    }
+
+    unsigned latency = transaction.latency;
+    if (victimHit) {
+        // The line is swapped in from the buffer rather than fetched from below
+        displaced.dirtyBlocks.forEach(
+            [&](unsigned block) { m_storage.markDirty(transaction.index.set, transaction.index.way, block); });
+        m_victims.invalidate(slot);
+        if (!m_sectored || displaced.validBlocks.test(transaction.index.block)) {
+            transaction.isVictimHit = true;
+            latency -= m_latency.missPenalty;
+            if (countAccess) {
+                m_stats.victimHits++;
+                m_stats.fetchedBlocks -= transaction.fetchBlocks;
+            }
+            transaction.fetchBlocks = 0;
+        }
+        if (m_sectored) {
+            // The sectors held by the buffer are merged with those fetched, if the accessed sector was not held
+            DirtyBlockMask valid = displaced.validBlocks;
+            m_storage.validBlocks(transaction.index.set, transaction.index.way).forEach([&](unsigned block) {
+                valid.set(block);
+            });
+            m_storage.setValidBlocks(transaction.index.set, transaction.index.way, valid);
+        }
+    }
+    if (transaction.evicted) {
+        m_victims.insert(slot, transaction.evictedAddress, m_evictedWay);
+        const bool leaves = !victimHit && displaced.valid;
+        transaction.evicted = leaves;
+        transaction.evictedAddress = leaves ? displaced.lineAddress : 0;
+        transaction.evictedDirty = leaves && displaced.dirty;
+
+        const bool isWriteback = transaction.evictedDirty ||
+                                 (transaction.type == AccessType::Write && m_wrPolicy == WritePolicy::WriteThrough);
+        if (isWriteback != transaction.isWriteback) {
+            if (isWriteback) {
+                latency += m_latency.writebackPenalty;
+                m_stats.writebacks++;
+            } else {
+                latency -= m_latency.writebackPenalty;
+                m_stats.writebacks--;
+            }
+            transaction.isWriteback = isWriteback;
+        }
+    }
+    if (countAccess) {
+        m_stats.latencyCycles = m_stats.latencyCycles - transaction.latency + latency;
+    }
+    transaction.latency = latency;
+    if (log) {
+        log->back().transaction = transaction;
+    }
+}
+
+void CacheEngine::drainWriteBuffer(uint64_t time) {
+    while (!m_writeBuffer.empty() && m_writeBuffer.headDone() <= time) {
+        m_drainedWrites.push_back(m_writeBuffer.front());
+        m_writeBuffer.pop();
+        m_writeBuffer.setHeadDone(m_writeBuffer.headDone() + m_writeBufferConfig.drainCycles);
+    }
+}
+
+void CacheEngine::recordWriteBufferSlot(unsigned slot, CacheUndoLog* log) const {
+    // Drains leave the contents of the slots intact, such that the slot stored to is the only one modified
+    if (log) {
+        log->back().writeBufferSlot = slot;
+        log->back().oldWriteBufferEntry = m_writeBuffer.slotEntry(slot);
+    }
+}
+
+void CacheEngine::bufferAccess(CacheTransaction& transaction, CacheUndoLog* log) {
+    if (log) {
+        log->back().oldWriteBufferPosition = m_writeBuffer.position();
+    }
+    uint64_t now = m_stats.latencyCycles - transaction.latency;
+    m_drainedWrites.clear();
+    drainWriteBuffer(now);
+
+    const uint32_t chunk = transaction.address & ~(m_chunkWords * 4 - 1);
+    const uint64_t word = uint64_t(1) << ((transaction.address - chunk) / 4);
+    const int pending = m_writeBuffer.find(chunk);
+    unsigned stall = 0;
+    if (transaction.type == AccessType::Read) {
+        if (!transaction.isHit && !m_writeBuffer.empty()) {
+            if (!m_writeBufferConfig.readBypass) {
+                // The line is only fetched once all buffered writes have reached the level below
+                const uint64_t drained =
+                    m_writeBuffer.headDone() + uint64_t(m_writeBuffer.size() - 1) * m_writeBufferConfig.drainCycles;
+                stall = drained - now;
+                drainWriteBuffer(drained);
+            } else if (pending >= 0 && (m_writeBuffer.entry(pending).words & word)) {
+                transaction.isForwarded = true;
+                m_stats.bufferForwards++;
+            }
+        }
+    } else if (transaction.isWriteback && !transaction.evictedDirty) {
+        // The write is buffered rather than written through
+        transaction.isWriteback = false;
+        transaction.isBuffered = true;
+        transaction.latency -= m_latency.writebackPenalty;
+        m_stats.latencyCycles -= m_latency.writebackPenalty;
+        m_stats.writebacks--;
+        if (pending >= 0) {
+            recordWriteBufferSlot(m_writeBuffer.slot(pending), log);
+            m_writeBuffer.merge(pending, word);
+            transaction.isCoalesced = true;
+            m_stats.coalescedWrites++;
+        } else {
+            if (m_writeBuffer.size() == m_writeBufferConfig.depth) {
+                stall = m_writeBuffer.headDone() - now;
+                now = m_writeBuffer.headDone();
+                drainWriteBuffer(now);
+            }
+            if (m_writeBuffer.empty()) {
+                m_writeBuffer.setHeadDone(now + m_writeBufferConfig.drainCycles);
+            }
+            recordWriteBufferSlot(m_writeBuffer.slot(m_writeBuffer.size()), log);
+            m_writeBuffer.push(chunk, word);
+        }
+    }
+
+    transaction.bufferStall = stall;
+    transaction.latency += stall;
+    m_stats.latencyCycles += stall;
+    m_stats.bufferStallCycles += stall;
+    transaction.drainedWrites = m_drainedWrites.size();
+    m_stats.bufferDrains += transaction.drainedWrites;
+    m_stats.writebacks += transaction.drainedWrites;
+    if (log) {
+        log->back().transaction = transaction;
+    }
+}
+
+CacheEngine::CacheTransaction CacheEngine::prefetchingAccess(uint32_t address, AccessType type, CacheUndoLog* log,
+                                                             uint32_t pc) {
+    const uint64_t now = m_stats.latencyCycles;
+    CacheTransaction transaction = performAccess(address, type, log, Allocation::Policy, true);
+    if (m_completeAccess) {
+        completeAccess(transaction, log);
+    }
+    if (transaction.isHit && m_storage.prefetched(transaction.index.set, transaction.index.way)) {
+        m_storage.setPrefetched(transaction.index.set, transaction.index.way, false);
+        transaction.isPrefetchHit = true;
+        m_stats.usefulPrefetches++;
+        const uint64_t ready = m_prefetchReady[transaction.index.set * m_storage.ways() + transaction.index.way];
+        if (ready > now) {
+            transaction.prefetchWait = static_cast<unsigned>(ready - now);
+            transaction.latency += transaction.prefetchWait;
+            m_stats.latencyCycles += transaction.prefetchWait;
+            m_stats.latePrefetches++;
+        }
+    } else if (!transaction.isHit && !transaction.isSectorMiss &&
+               m_pollutionFilter.test(pollutionFilterSlot(address))) {
+        m_pollutionFilter.reset(pollutionFilterSlot(address));
+        transaction.isPollutionMiss = true;
+        m_stats.pollutingPrefetches++;
+    }
+    if (log) {
+        log->back().transaction = transaction;
+    }
+
+    Prefetcher::DemandAccess demand;
+    demand.address = address;
+    demand.pc = pc;
+    demand.isWrite = type == AccessType::Write;
+    demand.isHit = transaction.isHit;
+    demand.isPrefetchHit = transaction.isPrefetchHit;
+    m_prefetchRequests.clear();
+    m_prefetcher->observe(demand, m_prefetchRequests);
+
+    m_prefetchTransactions.clear();
+    for (const uint32_t lineAddress : m_prefetchRequests) {
+        unsigned setIdx, wayIdx;
+        if (findLine(lineAddress, setIdx, wayIdx)) {
+            continue;
+        }
+        CacheTransaction fill = performAccess(lineAddress, AccessType::Read, log, Allocation::Always, false);
+        if (m_victims.size() != 0) {
+            exchangeVictim(fill, log, false);
+        }
+        fill.isPrefetch = true;
+        m_storage.setPrefetched(fill.index.set, fill.index.way, true);
+        m_prefetchReady[fill.index.set * m_storage.ways() + fill.index.way] =
+            m_stats.latencyCycles + m_latency.missPenalty;
+        if (fill.evicted && !fill.evictedPrefetched) {
+            m_pollutionFilter.set(pollutionFilterSlot(fill.evictedAddress));
+        }
+        m_stats.prefetches++;
+        if (log) {
+            log->back().transaction = fill;
+        }
+        m_prefetchTransactions.push_back(fill);
+    }
+    return transaction;
+}
+
+CacheEngine::CacheTransaction CacheEngine::probe(uint32_t address, AccessType type) {
+    return performAccess(address, type, nullptr, Allocation::Never, true);
+}
+
+CacheEngine::CacheTransaction CacheEngine::insert(uint32_t address, bool dirty) {
+    return performAccess(address, dirty ? AccessType::Write : AccessType::Read, nullptr, Allocation::Always, false);
+}
+
+bool CacheEngine::findLine(uint32_t address, unsigned& setIdx, unsigned& wayIdx) const {
+    const uint32_t tag = getTag(address);
+    const bool skewed = isSkewed();
+    for (unsigned way = 0; way < m_storage.ways(); way++) {
+        const unsigned set = skewed ? m_skewHash.index(way, getLineNumber(address)) : getSetIdx(address);
+        if (m_storage.valid(set, way) && m_storage.tag(set, way) == tag) {
+            setIdx = set;
+            wayIdx = way;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool CacheEngine::contains(uint32_t address) const {
+    unsigned setIdx, wayIdx;
+    return m_replPolicy != ReplPolicy::NoCache &&
+           (findLine(address, setIdx, wayIdx) || m_victims.find(getLineAddress(address)) != VictimBuffer::s_noSlot);
+}
+
+bool CacheEngine::invalidate(uint32_t address, bool* wasDirty) {
+    if (m_replPolicy == ReplPolicy::NoCache) {
+        return false;
+    }
+    unsigned setIdx, wayIdx;
+    if (!findLine(address, setIdx, wayIdx)) {
+        const unsigned slot = m_victims.find(getLineAddress(address));
+        if (slot == VictimBuffer::s_noSlot) {
+            return false;
+        }
+        if (wasDirty) {
+            *wasDirty = m_victims.entry(slot).dirty;
+        }
+        m_victims.invalidate(slot);
+        return true;
+    }
+    if (wasDirty) {
+        *wasDirty = m_storage.dirty(setIdx, wayIdx);
+    }
+    m_replPolicyObject->invalidateCacheSetReplFields(m_storage, setIdx, wayIdx);
+    m_storage.invalidate(setIdx, wayIdx);
+    return true;
+}
+
+CacheEngine::CacheTransaction CacheEngine::performUncachedAccess(uint32_t address, AccessType type, CacheUndoLog*,
+                                                                 Allocation, bool) {
+    CacheTransaction transaction;
+    transaction.address = address & ~0b11;
+    transaction.type = type;
+    // Every access goes directly to the level below
+    transaction.latency = type == AccessType::Read ? m_latency.missPenalty : m_latency.writebackPenalty;
+    return transaction;
+}
+
+template <typename Policy, CacheEngine::WritePolicy wrPolicy, CacheEngine::WriteAllocPolicy wrAllocPolicy, bool skewed>
+CacheEngine::CacheTransaction CacheEngine::performAccessImpl(uint32_t address, AccessType type, CacheUndoLog* log,
+                                                             Allocation allocation, bool countAccess) {
+    address = address & ~0b11;  // Disregard unaligned accesses
+    CacheTransaction transaction;
+    transaction.address = address;
+    transaction.type = type;
+
+    if (skewed) {
+        analyzeCacheAccessSkewedCache<Policy>(transaction); // this should analyze the set and way
+    } else {
+        analyzeCacheAccess<Policy>(transaction);
+    }
+    if (m_sectored && transaction.isHit &&
+        !m_storage.blockValid(transaction.index.set, transaction.index.way, transaction.index.block)) {
+        // The line is present, but not the accessed sector
+        transaction.isHit = false;
+        transaction.isSectorMiss = true;
+    }
+
+    const bool allocate =
+        allocation == Allocation::Always ||
+        (allocation == Allocation::Policy &&
+         (type == AccessType::Read || wrAllocPolicy == WriteAllocPolicy::WriteAllocate));
+    if (skewed && m_relocationLevels != 0 && !transaction.isHit && !transaction.isSectorMiss && allocate &&
+        isSkewed()) {
+        relocate(transaction);
+    }
+
+    if constexpr (std::is_same<Policy, OptPolicy>::value) {
+        // The position of this access within the stream given by setFutureAccesses()
+        policy<Policy>().seek(m_stats.accesses());
+    }
+
+    // Record the prior state of the accessed entry, in case of rollbacks
+    CacheUndoLog::Record* record = nullptr;
+    if (log) {
+        record = &log->push();
+        const unsigned setIdx = transaction.index.set;
+        const unsigned wayIdx = transaction.index.way;
+        record->oldTag = m_storage.tag(setIdx, wayIdx);
+        record->oldCounter = m_storage.counter(setIdx, wayIdx);
+        record->oldFlags = m_storage.flags(setIdx)[wayIdx];
+        if (m_sectored) {
+            std::copy_n(m_storage.validWords(setIdx, wayIdx), m_storage.maskWords(), log->backValidMask());
+        }
+        if (m_recordSetCounters) {
+            std::copy_n(m_storage.counters(setIdx), m_storage.ways(), log->backSetCounters());
+        }
+        std::copy_n(m_relocationPath.begin(), transaction.relocations, record->relocationPath);
+    }
+
+    if (!transaction.isHit && allocate) {
+        // A sector miss has no line to evict; the missing sectors are fetched into the present line
+        if (!transaction.isSectorMiss) {
+            if (record) {
+                record->allocated = true;
+                if (record->oldFlags & CacheStorage::Dirty) {
+                    std::copy_n(m_storage.dirtyWords(transaction.index.set, transaction.index.way),
+                                m_storage.maskWords(), log->backMask());
+                }
+            }
+            evictAndUpdate(transaction);
+        }
+        if (m_sectored) {
+            transaction.fetchBlocks =
+                std::min<unsigned>(1 + m_sectors.neighbors, getBlocks() - transaction.index.block);
+            m_storage.validateBlocks(transaction.index.set, transaction.index.way, transaction.index.block,
+                                     transaction.fetchBlocks);
+        } else {
+            transaction.fetchBlocks = getBlocks();
+        }
+    }
+
+    // === Update dirty and metadata bits ===
+    // Initially, we need a check for the case of a miss without allocation, ie. "write + miss + noWriteAlloc". In this
+    // case, we should not update replacement/dirty fields. In all other cases, this is a valid action.
+    const bool missNoAlloc = !transaction.isHit && !allocate;
+
+    if (!missNoAlloc) {
+        if (type == AccessType::Write && wrPolicy == WritePolicy::WriteBack) {
+            if (record) {
+                record->blockWasClean =
+                    !m_storage.blockDirty(transaction.index.set, transaction.index.way, transaction.index.block);
+            }
+            m_storage.markDirty(transaction.index.set, transaction.index.way, transaction.index.block);
+        }
+        // A sector miss is a hit as far as replacement is concerned, given that the line was already present
+        policy<Policy>().updateCacheSetReplFields(m_storage, transaction.index.set, transaction.index.way,
+                                                  transaction.isHit || transaction.isSectorMiss);
+        if (record) {
+            record->replUpdate = policy<Policy>().lastUpdate();
+        }
+    } else if (type == AccessType::Write) {
+        // In case of a write miss with no write allocate, the value is always written through to memory (a writeback)
+        transaction.isWriteback = true;
+    }
+
+    // If our WritePolicy is WriteThrough and this access is a write, the transaction will always result in a WriteBack
+    if (type == AccessType::Write && wrPolicy == WritePolicy::WriteThrough) {
+        transaction.isWriteback = true;
+    }
+
+    // === Some sanity checking ===
+    // It should never be possible that a read returns an invalid way index
+    if (type == AccessType::Read) {
+        transaction.index.assertValid();
+    }
+
+    // It should never be possible that a write returns an invalid way index if we write-allocate
+    if (type == AccessType::Write && allocate) {
+        transaction.index.assertValid();
+    }
+
+    // === Access latency ===
+    transaction.latency = m_latency.hitLatency;
+    if (!transaction.isHit && allocate) {
+        transaction.latency += m_latency.missPenalty;
+    }
+    if (transaction.isWriteback) {
+        transaction.latency += m_latency.writebackPenalty;
+    }
+
+    // === Update statistics ===
+    m_stats.writebacks += transaction.isWriteback ? 1 : 0;
+    if (countAccess) {
+        m_stats.latencyCycles += transaction.latency;
+        m_stats.reads += type == AccessType::Read ? 1 : 0;
+        m_stats.writes += type == AccessType::Write ? 1 : 0;
+        m_stats.hits += transaction.isHit ? 1 : 0;
+        m_stats.misses += transaction.isHit ? 0 : 1;
+        m_stats.sectorMisses += transaction.isSectorMiss ? 1 : 0;
+        m_stats.fetchedBlocks += transaction.fetchBlocks;
+    }
+    if (m_setProfiling) {
+        SetStatistics& set = m_setStats[transaction.index.set];
+        set.accesses += countAccess ? 1 : 0;
+        set.misses += countAccess && !transaction.isHit ? 1 : 0;
+        set.evictions += transaction.evicted ? 1 : 0;
+        set.writebacks += transaction.isWriteback ? 1 : 0;
+    }
+    if (m_classifyMisses && countAccess) {
+        transaction.missClass = m_missClassifier.access(getLineNumber(address),
+                                                        !transaction.isHit && !transaction.isSectorMiss,
+                                                        record ? &record->missChange : nullptr);
+        m_stats.compulsoryMisses += transaction.missClass == MissClass::Compulsory ? 1 : 0;
+        m_stats.capacityMisses += transaction.missClass == MissClass::Capacity ? 1 : 0;
+        m_stats.conflictMisses += transaction.missClass == MissClass::Conflict ? 1 : 0;
+    }
+
+    if (record) {
+        record->transaction = transaction;
+        record->setWriteback = transaction.isWriteback;
+    }
+    return transaction;
+}
+
+bool CacheEngine::undo(CacheUndoLog& log) {
+    if (log.empty()) {
+        return false;
+    }
+    // The prefetch fills of the access were recorded after its demand transaction, which starts the access
+    bool accessStart = false;
+    while (!accessStart && !log.empty()) {
+        accessStart = log.back().accessStart;
+        undoRecord(log);
+    }
+    return true;
+}
+
+void CacheEngine::undoRecord(CacheUndoLog& log) {
+    const CacheUndoLog::Record& record = log.back();
+    const CacheTransaction& transaction = record.transaction;
+    const unsigned& setIdx = transaction.index.set;
+    const unsigned& wayIdx = transaction.index.way;
+
+    CacheWay oldWay;
+    oldWay.tag = record.oldTag;
+    oldWay.counter = record.oldCounter;
+    oldWay.valid = record.oldFlags & CacheStorage::Valid;
+    oldWay.dirty = record.oldFlags & CacheStorage::Dirty;
+    oldWay.prefetched = record.oldFlags & CacheStorage::Prefetched;
+
+    // Case 1: A line was loaded into the way, either into an invalid way or by evicting a valid line. In both cases,
+    // the old entry is restored as a whole.
+    if (record.allocated) {
+        if (oldWay.dirty) {
+            oldWay.dirtyBlocks.load(log.backMask(), log.maskWords());
+        }
+        if (m_sectored) {
+            oldWay.validBlocks.load(log.backValidMask(), log.maskWords());
+        }
+        m_storage.setWay(setIdx, wayIdx, oldWay);
+        revertCacheSetReplFields(oldWay, setIdx, wayIdx, record.replUpdate);
+    }
+    // Case 2: A cache hit or a sector miss; revert the dirty bit which may have been set, the fetched sectors and the
+    // replacement fields
+    else if (transaction.isHit || transaction.isSectorMiss) {
+        if (m_sectored) {
+            m_storage.setValidWords(setIdx, wayIdx, log.backValidMask());
+        }
+        if (record.blockWasClean) {
+            m_storage.unmarkDirty(setIdx, wayIdx, transaction.index.block, oldWay.dirty);
+        }
+        m_storage.setPrefetched(setIdx, wayIdx, oldWay.prefetched);
+        revertCacheSetReplFields(oldWay, setIdx, wayIdx, record.replUpdate);
+    }
+    // Case 3: A write miss without write allocation; the cache contents were not modified
+    if (m_recordSetCounters) {
+        std::copy_n(log.backSetCounters(), m_storage.ways(), m_storage.counters(setIdx));
+    }
+
+    if (transaction.relocations != 0) {
+        // The relocated lines move back up the path, and the evicted line, now restored into the accessed entry, back
+        // to the bottom of it
+        const unsigned ways = m_storage.ways();
+        const CacheWay evicted = m_storage.way(setIdx, wayIdx);
+        const uint64_t ready = m_prefetchReady.empty() ? 0 : m_prefetchReady[setIdx * ways + wayIdx];
+        CacheIndex to = transaction.index;
+        for (unsigned level = 0; level < transaction.relocations; level++) {
+            const CacheIndex& from = record.relocationPath[level];
+            placeLine(to.set, to.way, m_storage.way(from.set, from.way),
+                      m_prefetchReady.empty() ? 0 : m_prefetchReady[from.set * ways + from.way]);
+            to = from;
+        }
+        placeLine(to.set, to.way, evicted, ready);
+    }
+    if (m_setProfiling) {
+        // The victim buffer may since have changed whether the transaction evicted or wrote back a line, but not
+        // whether it replaced a valid line
+        SetStatistics& set = m_setStats[setIdx];
+        set.accesses -= transaction.isPrefetch ? 0 : 1;
+        set.misses -= transaction.isPrefetch || transaction.isHit ? 0 : 1;
+        set.evictions -= transaction.tagChanged && !transaction.transToValid ? 1 : 0;
+        set.writebacks -= record.setWriteback ? 1 : 0;
+    }
+    if (transaction.walkCandidates != 0) {
+        m_stats.relocationWalks--;
+        m_stats.walkCandidates -= transaction.walkCandidates;
+        m_stats.relocations -= transaction.relocations;
+        m_stats.relocationDepths[transaction.relocations]--;
+    }
+    if (m_classifyMisses) {
+        m_missClassifier.undo(record.missChange);
+        m_stats.compulsoryMisses -= transaction.missClass == MissClass::Compulsory ? 1 : 0;
+        m_stats.capacityMisses -= transaction.missClass == MissClass::Capacity ? 1 : 0;
+        m_stats.conflictMisses -= transaction.missClass == MissClass::Conflict ? 1 : 0;
+    }
+
+    if (record.victimSlot != VictimBuffer::s_noSlot) {
+        m_victims.restore(record.victimSlot, record.oldVictim);
+    }
+    if (m_writeBufferConfig.depth != 0 && !transaction.isPrefetch) {
+        m_writeBuffer.restore(record.oldWriteBufferPosition, record.writeBufferSlot, record.oldWriteBufferEntry);
+    }
+
+    m_stats.writebacks -= (transaction.isWriteback ? 1 : 0) + transaction.drainedWrites;
+    if (transaction.isPrefetch) {
+        // Prefetch fills are not counted as accesses
+        m_stats.prefetches--;
+    } else {
+        m_stats.reads -= transaction.type == AccessType::Read ? 1 : 0;
+        m_stats.writes -= transaction.type == AccessType::Write ? 1 : 0;
+        m_stats.hits -= transaction.isHit ? 1 : 0;
+        m_stats.misses -= transaction.isHit ? 0 : 1;
+        m_stats.sectorMisses -= transaction.isSectorMiss ? 1 : 0;
+        m_stats.fetchedBlocks -= transaction.fetchBlocks;
+        m_stats.latencyCycles -= transaction.latency;
+        m_stats.usefulPrefetches -= transaction.isPrefetchHit ? 1 : 0;
+        m_stats.latePrefetches -= transaction.prefetchWait != 0 ? 1 : 0;
+        m_stats.pollutingPrefetches -= transaction.isPollutionMiss ? 1 : 0;
+        m_stats.victimHits -= transaction.isVictimHit ? 1 : 0;
+        m_stats.coalescedWrites -= transaction.isCoalesced ? 1 : 0;
+        m_stats.bufferDrains -= transaction.drainedWrites;
+        m_stats.bufferStallCycles -= transaction.bufferStall;
+        m_stats.bufferForwards -= transaction.isForwarded ? 1 : 0;
+    }
+
+    log.pop();
+}
+
+unsigned CacheEngine::getSetIdx(const uint32_t address) const {
+    uint32_t maskedAddress = address & m_setMask;
+    maskedAddress >>= 2 + getBlockBits();
+    return maskedAddress;
+}
+
+CacheEngine::CacheSize CacheEngine::getCacheSize() const {
+    CacheSize size;
+
+    const int entries = getSets() * getWays();
+
+    // Valid bits
+    unsigned componentBits = m_sectored ? entries * getBlocks() : entries;  // 1 bit per entry, or per sector
+    size.components.push_back("Valid bits: " + std::to_string(componentBits));
+    size.bits += componentBits;
+
+    if (m_wrPolicy == WritePolicy::WriteBack) {
+        // Dirty bits
+        unsigned componentBits = entries;  // 1 bit per entry
+        size.components.push_back("Dirty bits: " + std::to_string(componentBits));
+        size.bits += componentBits;
+    }
+
+    if (m_replPolicy == ReplPolicy::LRU || m_replPolicy == ReplPolicy::LRU_LIP || m_replPolicy == ReplPolicy::DIP) {
+        // counter bits
+        componentBits = getWaysBits() * entries;
+        size.components.push_back("Counter bits: " + std::to_string(componentBits));
+        size.bits += componentBits;
+    }
+
+    if (m_replPolicy == ReplPolicy::SRRIP || m_replPolicy == ReplPolicy::BRRIP || m_replPolicy == ReplPolicy::DRRIP) {
+        // RRPV bits
+        componentBits = getReplCounterBits() * entries;
+        size.components.push_back("RRPV bits: " + std::to_string(componentBits));
+        size.bits += componentBits;
+    }
+
+    if (m_replPolicy == ReplPolicy::DIP || m_replPolicy == ReplPolicy::DRRIP) {
+        // Policy selection counter, shared by all sets
+        componentBits = m_dueling.pselBits;
+        size.components.push_back("PSEL bits: " + std::to_string(componentBits));
+        size.bits += componentBits;
+    }
+
+    // Tag bits. Skewed caches whose index functions cannot be inverted store the whole line number.
+    componentBits = (isSkewed() && !m_compactTags ? 32 - 2 - getBlockBits() : popcount(m_tagMask)) * entries;
+    size.components.push_back("Tag bits: " + std::to_string(componentBits));
+    size.bits += componentBits;
+
+    // Data bits
+    componentBits = 32 * entries * getBlocks();
+    size.components.push_back("Data bits: " + std::to_string(componentBits));
+    size.bits += componentBits;
+
+    if (m_victims.size() != 0) {
+        // Victim buffer entries hold a valid bit, a dirty bit, the line address, the line data and an LRU counter
+        unsigned lruBits = 0;
+        while ((1u << lruBits) < m_victims.size()) {
+            lruBits++;
+        }
+        const unsigned entryBits = 1 + (m_wrPolicy == WritePolicy::WriteBack ? 1 : 0) + (32 - 2 - getBlockBits()) +
+                                   32 * getBlocks() + lruBits;
+        componentBits = entryBits * m_victims.size();
+        size.components.push_back("Victim buffer bits: " + std::to_string(componentBits));
+        size.bits += componentBits;
+    }
+
+    if (m_writeBufferConfig.depth != 0 && m_replPolicy != ReplPolicy::NoCache) {
+        // Write buffer entries hold the chunk address, a valid bit per word and the data of the chunk
+        const unsigned chunkBits = popcount(m_chunkWords - 1);
+        const unsigned entryBits = (32 - 2 - chunkBits) + m_chunkWords + 32 * m_chunkWords;
+        componentBits = entryBits * m_writeBufferConfig.depth;
+        size.components.push_back("Write buffer bits: " + std::to_string(componentBits));
+        size.bits += componentBits;
+    }
+
+    // We do not take the PLRU tree (PLRU) bits into consideration
+
+    return size;
+}
+
+uint32_t CacheEngine::buildAddress(unsigned tag, unsigned setIdx, unsigned wayIdx, unsigned blockIdx) const {
+    if (!isSkewed()) {
+        uint32_t address = 0;
+        address |= tag << (2 /*byte offset*/ + getBlockBits() + getSetBits());
+        address |= setIdx << (2 /*byte offset*/ + getBlockBits());
+        address |= blockIdx << (2 /*byte offset*/);
+        return address;
+    } else {
+        const uint32_t line = m_compactTags ? m_skewHash.line(wayIdx, setIdx, tag) : tag;
+        return (line << (2 /*byte offset*/ + getBlockBits())) | (blockIdx << 2 /*byte offset*/);
+    }
+}
+
+unsigned CacheEngine::getTag(const uint32_t address) const {
+    if (!isSkewed() || m_compactTags) {
+        uint32_t maskedAddress = address & m_tagMask;
+        maskedAddress >>= 2 + getBlockBits() + getSetBits();
+        return maskedAddress;
+    } else {
+        return getLineNumber(address);
+    }
+}
+
+unsigned CacheEngine::getBlockIdx(const uint32_t address) const {
+    uint32_t maskedAddress = address & m_blockMask;
+    maskedAddress >>= 2;
+    return maskedAddress;
+}
+
+}  // namespace Ripes
@@ -0,0 +1,690 @@
+#pragma once
+
+#include <array>
+#include <bitset>
+#include <cassert>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "cache_organize_component.h"
+#include "cache_policy_object.h"
+#include "cachemissclass.h"
+#include "cacheprefetcher.h"
+#include "cacheskewhash.h"
+
+namespace Ripes {
+
+class CacheUndoLog;
+
+/**
+ * @brief The CacheEngine class
+ * The cache model itself, free of any Qt or processor dependencies. The engine holds the cache configuration and
+ * contents, and performs accesses upon request. The GUI CacheSim wraps an engine and feeds it the memory accesses of the
+ * simulated processor, whereas headless tools drive it directly from a recorded access trace (see cachetrace.h).
+ */
+class CacheEngine {
+public:
+    static constexpr unsigned s_invalidIndex = static_cast<unsigned>(-1);
+    // Bounds of the relocation walk of a z-cache (see setRelocation())
+    static constexpr unsigned s_maxRelocationLevels = 3;
+    static constexpr unsigned s_maxRelocationCandidates = 64;
+
+    enum class WriteAllocPolicy { WriteAllocate, NoWriteAllocate };
+    enum class SkewedAssocPolicy { Skewed, NonSkewed };
+    enum class WritePolicy { WriteThrough, WriteBack };
+    // OPT replaces optimally given the future access stream (see setFutureAccesses()), and is thus only available
+    // to trace-driven tools
+    enum class ReplPolicy { Random, LRU, LRU_LIP, NoCache, PLRU, DIP, SRRIP, BRRIP, DRRIP, OPT };
+    enum class AccessType { Read, Write };
+    enum class CacheType { DataCache, InstrCache };
+
+    struct CacheSize {
+        unsigned bits = 0;
+        std::vector<std::string> components;
+    };
+
+    struct CachePreset {
+        int blocks = 0;
+        int sets = 0;
+        int ways = 0;
+
+        WritePolicy wrPolicy = WritePolicy::WriteBack;
+        WriteAllocPolicy wrAllocPolicy = WriteAllocPolicy::WriteAllocate;
+        ReplPolicy replPolicy = ReplPolicy::LRU;
+        SkewedAssocPolicy skewPolicy = SkewedAssocPolicy::NonSkewed;
+        SkewHashType skewHash = SkewHashType::Seznec;
+        unsigned relocationLevels = 0;  // See setRelocation()
+    };
+
+    /**
+     * @brief The CacheLatency struct
+     * Timing of the cache, in cycles. Every access takes hitLatency cycles to look up the cache. A miss which allocates
+     * the line additionally waits missPenalty cycles for the line to be fetched, and any access writing to the level
+     * below (a dirty eviction, a write-through write or a write miss without allocation) waits writebackPenalty cycles.
+     */
+    struct CacheLatency {
+        unsigned hitLatency = 1;
+        unsigned missPenalty = 10;
+        unsigned writebackPenalty = 10;
+    };
+
+    /**
+     * @brief The SetDuelingConfig struct
+     * Parameters of the adaptive policies, which pick between two insertion policies through set dueling (see
+     * SetDueling): DIP duels LRU against bimodal insertion (BIP), and DRRIP duels SRRIP against BRRIP. The bimodal
+     * policies insert 1 in bimodalThrottle missing lines as their counterpart would; 0 disables this, such that DIP
+     * duels LRU against LIP. The throttle, and the width of the RRPV of each way, also apply to SRRIP and BRRIP on their
+     * own.
+     */
+    struct SetDuelingConfig {
+        unsigned leaderSets = 32;  // Leader sets per competing policy
+        unsigned pselBits = 10;
+        unsigned bimodalThrottle = 32;
+        unsigned rrpvBits = 2;  // 1 up to RripPolicy::s_maxRrpvBits
+    };
+
+    /**
+     * @brief The WriteBufferConfig struct
+     * Parameters of the write buffer (see setWriteBuffer()). The buffer holds up to depth entries (at most
+     * WriteBuffer::s_maxDepth; 0 disables the buffer), and writes one entry to the level below every drainCycles
+     * cycles. With readBypass, read misses are served ahead of the buffered writes; otherwise, a read miss waits for
+     * the buffer to drain.
+     */
+    struct WriteBufferConfig {
+        unsigned depth = 0;
+        unsigned drainCycles = 10;
+        bool readBypass = true;
+    };
+
+    /**
+     * @brief The SectorConfig struct
+     * Sectoring of the cache lines (see setSectoring()). Each block of a sectored line is a sector with a valid bit of
+     * its own; a miss fetches the accessed sector along with up to neighbors sectors following it within the line.
+     */
+    struct SectorConfig {
+        bool enabled = false;
+        unsigned neighbors = 0;
+    };
+
+    struct CacheIndex {
+        unsigned set = s_invalidIndex;
+        unsigned way = s_invalidIndex;
+        unsigned block = s_invalidIndex;
+        void assertValid() const {
+            assert(set != s_invalidIndex && "Cache set index is invalid");
+            assert(way != s_invalidIndex && "Cache way index is invalid");
+            assert(block != s_invalidIndex && "Cache block index is invalid");
+        }
+    };
+
+    struct CacheTransaction {
+        uint32_t address;
+        CacheIndex index;
+
+        bool isHit = false;
+        bool isWriteback = false;  // True if the transaction resulted in an eviction of a dirty cache set
+        AccessType type;
+        bool transToValid = false;  // True if the cache set just transitioned from invalid to valid
+        bool tagChanged = false;    // True if transToValid or the previous entry was evicted
+
+        bool evicted = false;         // True if a valid line was evicted to make room for the accessed line
+        bool evictedDirty = false;    // True if the evicted line was dirty
+        uint32_t evictedAddress = 0;  // Address of the first word of the evicted line
+
+        unsigned latency = 0;  // Cycles taken to complete the access, as per the configured CacheLatency
+
+        bool isPrefetch = false;         // True if the transaction is a prefetch fill, rather than a demand access
+        bool isPrefetchHit = false;      // True if the access was the first demand hit on a prefetched line
+        unsigned prefetchWait = 0;       // Cycles a prefetch hit waited for the prefetch fill to complete
+        bool isPollutionMiss = false;    // True if the access missed on a line evicted by a prefetch fill
+        bool evictedPrefetched = false;  // True if the evicted line was prefetched, and never demanded
+
+        bool isVictimHit = false;  // True if the missing line was found in the victim buffer, and swapped back in
+
+        bool isBuffered = false;     // True if the write was placed in the write buffer, rather than written through
+        bool isCoalesced = false;    // True if the write was merged into a pending write buffer entry
+        bool isForwarded = false;    // True if the read missed on a word pending in the write buffer
+        unsigned bufferStall = 0;    // Cycles waited for the write buffer to free an entry, or to drain
+        unsigned drainedWrites = 0;  // Write buffer entries written to the level below during the access
+
+        bool isSectorMiss = false;  // True if the line was present, but not the accessed sector
+        // Blocks fetched from the level below: the whole line, or in sectored caches the blocks from the accessed block
+        // onwards
+        unsigned fetchBlocks = 0;
+
+        unsigned walkCandidates = 0;  // Candidates examined by the relocation walk of the miss; 0 if none was performed
+        unsigned relocations = 0;     // Lines moved to an alternative position to make room for the accessed line
+
+        MissClass missClass = MissClass::None;  // 3C class of a tag miss (see setMissClassification())
+    };
+
+    /**
+     * @brief The CacheStatistics struct
+     * Aggregate access counters of the engine. 64-bit counters are used given that headless runs may replay traces of
+     * billions of accesses.
+     */
+    struct CacheStatistics {
+        uint64_t reads = 0;
+        uint64_t writes = 0;
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t writebacks = 0;
+        uint64_t latencyCycles = 0;  // Sum of the latencies of all accesses
+
+        // Prefetching (see setPrefetcher())
+        uint64_t prefetches = 0;           // Prefetch fills performed
+        uint64_t usefulPrefetches = 0;     // Prefetched lines which were demanded before being evicted
+        uint64_t latePrefetches = 0;       // Useful prefetches demanded before their fill had completed
+        uint64_t pollutingPrefetches = 0;  // Demand misses on lines evicted by prefetch fills
+
+        uint64_t victimHits = 0;  // Misses served by the victim buffer (see setVictimBuffer())
+
+        // Write buffering (see setWriteBuffer()). Drained entries are also counted as writebacks.
+        uint64_t coalescedWrites = 0;    // Writes merged into a pending entry
+        uint64_t bufferDrains = 0;       // Entries written to the level below
+        uint64_t bufferStallCycles = 0;  // Cycles accesses waited on the write buffer
+        uint64_t bufferForwards = 0;     // Read misses on words pending in the buffer
+
+        // Misses on a present line whose accessed sector was not (see setSectoring()). Also counted as misses; the
+        // remaining misses are tag misses.
+        uint64_t sectorMisses = 0;
+        uint64_t fetchedBlocks = 0;  // Blocks fetched from the level below by accesses
+
+        // Z-cache relocation (see setRelocation()). As writebacks, these also cover the lines filled by insert() and
+        // by prefetches.
+        uint64_t relocationWalks = 0;
+        uint64_t walkCandidates = 0;  // Candidates examined by all walks
+        uint64_t relocations = 0;     // Lines moved to an alternative position
+        // Walks per relocation depth, ie. the level of the tree at which the victim was found
+        std::array<uint64_t, s_maxRelocationLevels + 1> relocationDepths{};
+
+        // 3C classification of the tag misses (see setMissClassification())
+        uint64_t compulsoryMisses = 0;
+        uint64_t capacityMisses = 0;
+        uint64_t conflictMisses = 0;
+
+        uint64_t accesses() const { return hits + misses; }
+        double hitRate() const { return accesses() == 0 ? 0 : static_cast<double>(hits) / accesses(); }
+        /**
+         * @brief amat
+         * Average memory access time, in cycles.
+         */
+        double amat() const { return accesses() == 0 ? 0 : static_cast<double>(latencyCycles) / accesses(); }
+        /**
+         * @brief stallCycles
+         * Cycles which accesses took beyond the single cycle of the pipeline stage performing them.
+         */
+        uint64_t stallCycles() const { return latencyCycles - accesses(); }
+    };
+
+    /**
+     * @brief The SetStatistics struct
+     * Access counters of a single set (see setSetProfiling()). An access is attributed to the set of the entry it
+     * looked up or replaced; in a skewed cache, the set of the way which hit or received the line. Evictions and
+     * writebacks are those determined by the cache itself, before any victim buffer or write buffer applies.
+     */
+    struct SetStatistics {
+        uint64_t accesses = 0;
+        uint64_t misses = 0;
+        uint64_t evictions = 0;
+        uint64_t writebacks = 0;
+    };
+
+    CacheEngine();
+    CacheEngine(const CacheEngine&) = delete;
+    CacheEngine& operator=(const CacheEngine&) = delete;
+
+    /**
+     * Configuration setters. Any change to the configuration resets the contents and statistics of the cache.
+     */
+    void setType(CacheType type);
+    void setBlocks(unsigned blocks);
+    void setSets(unsigned sets);
+    void setWays(unsigned ways);
+    void setWritePolicy(WritePolicy policy);
+    void setWriteAllocatePolicy(WriteAllocPolicy policy);
+    void setReplacementPolicy(ReplPolicy policy);
+    void setSkewedAssocPolicy(SkewedAssocPolicy policy);
+    void setPreset(const CachePreset& preset);
+    void setLatency(const CacheLatency& latency);
+    void setSetDueling(const SetDuelingConfig& config);
+    /**
+     * @brief setSkewHash
+     * Selects the family of per-way set index functions used by a skewed-associative data cache (see SkewHashType).
+     */
+    void setSkewHash(SkewHashType type);
+    /**
+     * @brief setRelocation
+     * Turns a skewed-associative data cache into a z-cache (after Sanchez and Kozyrakis, MICRO 2010) with @p levels
+     * levels of relocation, at most s_maxRelocationLevels; 0 disables relocation. On a miss which allocates a line, the
+     * candidate entries of the line in every way form the first level of a tree, which is walked breadth-first: the
+     * children of a candidate are the entries its resident line could be moved to in the other ways, down to @p levels
+     * levels below the first and up to s_maxRelocationCandidates candidates, and an invalid candidate ends the walk.
+     * The least valuable line of the tree, as per the replacement counters, is evicted, and each line on the path from
+     * the first level down to it is moved one level down, such that the accessed line takes the place of the first.
+     * Relocations are performed off the critical path of the access, and take no cycles.
+     */
+    void setRelocation(unsigned levels);
+
+    /**
+     * @brief setFutureAccesses
+     * Provides the addresses of the complete stream of counted accesses which is to be performed on the cache, in
+     * order, from which the OPT policy derives its next-use knowledge. The stream is kept across resets and
+     * reconfigurations. Accesses beyond the end of the stream are treated as never being reused.
+     */
+    void setFutureAccesses(std::shared_ptr<const std::vector<uint32_t>> addresses);
+
+    /**
+     * @brief setPrefetcher
+     * Attaches @p prefetcher to the cache, replacing any previous one; nullptr disables prefetching. The prefetcher
+     * observes every demand access performed through access(), and the lines it requests are filled into the cache
+     * right after the access, as reads which are not counted as accesses. A prefetch fill completes missPenalty cycles
+     * after being issued, measured in the accumulated latency of the accesses; a demand hit on a line whose fill has
+     * not yet completed is a late prefetch, and waits for the remaining cycles. Prefetch fills which evict a line are
+     * recorded in a pollution filter (after Srinath et al.), and a later demand miss on such a line counts the prefetch
+     * as polluting. Prefetching is disabled for the NoCache and OPT policies.
+     *
+     * Prefetch fills are recorded in the undo log as records of their own, following the record of the access which
+     * triggered them (see CacheTransaction::isPrefetch); undo() reverts them along with their statistics. The training
+     * state of the prefetcher and the pollution filter are not reverted.
+     */
+    void setPrefetcher(std::unique_ptr<Prefetcher> prefetcher);
+    Prefetcher* getPrefetcher() const { return m_prefetcher.get(); }
+
+    /**
+     * @brief setVictimBuffer
+     * Attaches a fully associative victim buffer of @p entries lines to the cache; 0 disables it. Lines evicted by
+     * access() are moved into the buffer rather than being discarded, and an allocating miss on a line held by the
+     * buffer swaps it back into the cache with its dirty blocks, in place of fetching it (a victim hit, still counted
+     * as a miss, but without the miss penalty). The transaction of such an access reports the line displaced from the
+     * buffer as its evicted line, and only writes it back if it is dirty. insert() and probe() bypass the buffer, while
+     * contains() and invalidate() cover it. The buffer is not available with the NoCache policy.
+     */
+    void setVictimBuffer(unsigned entries);
+    unsigned getVictimBufferEntries() const { return m_victimEntries; }
+    const VictimBuffer& getVictimBuffer() const { return m_victims; }
+
+    /**
+     * @brief setWriteBuffer
+     * Configures a write buffer between the cache and the level below. Writes which would otherwise be written through
+     * by access() (all writes of a write-through cache, and write misses without allocation) are placed in the buffer
+     * instead, and no longer take the writeback penalty. Entries cover the line, or 64 words of it for wider lines, and
+     * writes to a chunk which is already pending are coalesced into its entry. Time is measured in the accumulated
+     * latency of the accesses, as for prefetching: the oldest entry is written to the level below drainCycles after it
+     * reached the head of the buffer, and a write which finds the buffer full waits for its oldest entry to drain.
+     * Entries still pending when the trace ends are not counted as drained. The buffer is not available with the
+     * NoCache policy.
+     */
+    void setWriteBuffer(const WriteBufferConfig& config);
+    const WriteBufferConfig& getWriteBufferConfig() const { return m_writeBufferConfig; }
+    const WriteBuffer& getWriteBuffer() const { return m_writeBuffer; }
+    unsigned getWriteBufferChunkWords() const { return m_chunkWords; }
+
+    /**
+     * @brief getDrainedWrites
+     * The write buffer entries written to the level below during the most recent call to access(), in order.
+     */
+    const std::vector<WriteBuffer::Entry>& getDrainedWrites() const { return m_drainedWrites; }
+
+    /**
+     * @brief setSectoring
+     * Configures the cache as a sectored cache, in which each block of a line is valid on its own. A miss on a line
+     * (a tag miss) allocates the line but only fetches the accessed block and its neighbors, and a later access to a
+     * block of the line which was not fetched is a sector miss: it fetches the block and its neighbors into the line,
+     * without evicting anything. Sector misses take the miss penalty and count as misses; the fill bandwidth saved on
+     * sparsely used lines shows in CacheStatistics::fetchedBlocks. Dirty blocks are always valid, and a write miss
+     * without allocation leaves the sectors of a present line untouched. Sectoring is not available with the NoCache
+     * policy.
+     */
+    void setSectoring(const SectorConfig& config);
+    const SectorConfig& getSectoring() const { return m_sectors; }
+
+    /**
+     * @brief setSetProfiling
+     * Enables the per-set access counters, kept in a flat array indexed by set (see getSetStatistics()). Inserted and
+     * prefetched lines count towards the evictions and writebacks of their set, but not towards its accesses. The
+     * counters are disabled by default, such that sweeps over large caches do not carry them.
+     */
+    void setSetProfiling(bool enabled);
+    bool getSetProfiling() const { return m_setProfiling; }
+    const std::vector<SetStatistics>& getSetStatistics() const { return m_setStats; }
+
+    /**
+     * @brief setMissClassification
+     * Enables the 3C classification of the misses of demand accesses into compulsory, capacity and conflict misses (see
+     * MissClassifier), against a fully associative LRU shadow cache of as many lines as the cache. The shadow cache
+     * observes the line of every demand access, but not prefetch fills nor inserted lines. Sector misses are not
+     * classified, given that their line is present. The classification is disabled by default, and is not available
+     * with the NoCache policy.
+     */
+    void setMissClassification(bool enabled);
+    bool getMissClassification() const { return m_missClassification; }
+
+    /**
+     * @brief reset
+     * Invalidates all cache contents, clears the statistics and reallocates the storage and the replacement policy
+     * state as per the current configuration.
+     */
+    void reset();
+
+    /**
+     * @brief access
+     * Performs a single access to the cache and returns the resulting transaction. If @p log is provided, the changes
+     * performed by the access are recorded in it, such that the access may later be undone through undo(). Headless
+     * callers which never undo should leave @p log as nullptr. @p pc is the address of the accessing instruction, if
+     * known, as observed by the prefetcher.
+     */
+    CacheTransaction access(uint32_t address, AccessType type, CacheUndoLog* log = nullptr,
+                            uint32_t pc = Prefetcher::s_noPc);
+
+    /**
+     * @brief getPrefetchTransactions
+     * The prefetch fills performed in response to the most recent call to access(), in order.
+     */
+    const std::vector<CacheTransaction>& getPrefetchTransactions() const { return m_prefetchTransactions; }
+
+    /**
+     * @brief probe
+     * As access(), but a missing line is never allocated, regardless of the write allocate policy.
+     */
+    CacheTransaction probe(uint32_t address, AccessType type);
+
+    /**
+     * @brief insert
+     * Allocates the line of @p address, marking the accessed block dirty if @p dirty is set, as when a line is handed
+     * down from a higher cache level. The insertion is not counted as an access in the statistics; a writeback caused
+     * by evicting a dirty line is.
+     */
+    CacheTransaction insert(uint32_t address, bool dirty);
+
+    /**
+     * @brief invalidate
+     * Removes the line of @p address from the cache, if present. @returns true if the line was present; @p wasDirty
+     * is then set to whether the line was dirty.
+     */
+    bool invalidate(uint32_t address, bool* wasDirty = nullptr);
+
+    /**
+     * @brief contains
+     * @returns true if the line of @p address is present in the cache. Does not modify any cache state.
+     */
+    bool contains(uint32_t address) const;
+
+    /**
+     * @brief undo
+     * Reverts the newest access recorded in @p log, along with the prefetch fills performed in response to it, and
+     * removes its records from the log. @returns false if the log is empty.
+     */
+    bool undo(CacheUndoLog& log);
+    /**
+     * @brief getUndoSetWays
+     * The number of replacement counters which the undo log must hold per record for the current replacement policy,
+     * to be passed to CacheUndoLog::reset(); 0 unless the policy updates the counters of the whole set.
+     */
+    unsigned getUndoSetWays() const { return m_recordSetCounters ? m_storage.ways() : 0; }
+
+    WriteAllocPolicy getWriteAllocPolicy() const { return m_wrAllocPolicy; }
+    ReplPolicy getReplacementPolicy() const { return m_replPolicy; }
+    WritePolicy getWritePolicy() const { return m_wrPolicy; }
+    SkewedAssocPolicy getSkewedPolicy() const { return m_skewPolicy; }
+    CacheType getCacheType() const { return m_type; }
+    const CacheLatency& getLatency() const { return m_latency; }
+    const SetDuelingConfig& getSetDueling() const { return m_dueling; }
+    SkewHashType getSkewHash() const { return m_skewHashType; }
+    unsigned getRelocationLevels() const { return m_relocationLevels; }
+
+    const CacheStatistics& getStatistics() const { return m_stats; }
+    CacheSize getCacheSize() const;
+
+    /**
+     * @brief buildAddress
+     * Address of block @p blockIdx of the line stored with @p tag at (@p setIdx, @p wayIdx). Skewed caches store the
+     * bits of the line number above the set bits as the tag, from which the set index functions of the way recover the
+     * line number (see SkewHash::line()); if the functions are not invertible, the full line number is stored instead.
+     */
+    uint32_t buildAddress(unsigned tag, unsigned setIdx, unsigned wayIdx, unsigned blockIdx) const;
+
+    int getBlockBits() const { return m_blocks; }
+    int getWaysBits() const { return m_ways; }
+    int getSetBits() const { return m_sets; }
+    int getTagBits() const { return 32 - 2 /*byte offset*/ - getBlockBits() - getSetBits(); }
+
+    int getBlocks() const { return 1 << m_blocks; }
+    int getWays() const { return 1 << m_ways; }
+    int getSets() const { return 1 << m_sets; }
+    unsigned getBlockMask() const { return m_blockMask; }
+    unsigned getTagMask() const { return m_tagMask; }
+    unsigned getSetMask() const { return m_setMask; }
+
+    unsigned getSetIdx(const uint32_t address) const;
+    unsigned getBlockIdx(const uint32_t address) const;
+    unsigned getTag(const uint32_t address) const;
+    uint32_t getLineAddress(const uint32_t address) const { return address & ~(m_blockMask | 0b11); }
+
+    const CacheStorage& getStorage() const { return m_storage; }
+
+    /**
+     * @brief getReplCounter
+     * Replacement counter of the entry at (@p setIdx, @p wayIdx), as interpreted by the replacement policy.
+     */
+    unsigned getReplCounter(unsigned setIdx, unsigned wayIdx) const;
+    /**
+     * @brief getReplCounterBits
+     * Width of the replacement counter of each entry: the RRPV width of the RRIP policies, else the number of ways bits.
+     */
+    unsigned getReplCounterBits() const;
+
+private:
+    enum class Allocation { Policy, Never, Always };
+
+    CacheTransaction performAccess(uint32_t address, AccessType type, CacheUndoLog* log, Allocation allocation,
+                                   bool countAccess) {
+        return (this->*m_accessFn)(address, type, log, allocation, countAccess);
+    }
+
+    /**
+     * @brief performAccessImpl
+     * The access path, specialized for a replacement policy class, write policy, write allocate policy and skew mode.
+     * Calls to a policy class declared final are resolved statically and inlined. One specialization per
+     * configuration is selected by reset(), such that an access performs a single indirect call.
+     */
+    template <typename Policy, WritePolicy wrPolicy, WriteAllocPolicy wrAllocPolicy, bool skewed>
+    CacheTransaction performAccessImpl(uint32_t address, AccessType type, CacheUndoLog* log, Allocation allocation,
+                                       bool countAccess);
+    CacheTransaction performUncachedAccess(uint32_t address, AccessType type, CacheUndoLog* log, Allocation allocation,
+                                           bool countAccess);
+    using AccessFn = CacheTransaction (CacheEngine::*)(uint32_t, AccessType, CacheUndoLog*, Allocation, bool);
+    template <typename Policy>
+    AccessFn selectAccessFn() const;
+    /**
+     * @brief installPolicy
+     * Instantiates the replacement policy object as a @p Policy, passing @p args after the cache geometry to its
+     * constructor, and selects the access path which calls it as a @p DispatchAs.
+     */
+    template <typename Policy, typename DispatchAs = Policy, typename... Args>
+    void installPolicy(Args&&... args);
+    template <typename Policy>
+    Policy& policy() {
+        return static_cast<Policy&>(*m_replPolicyObject);
+    }
+
+    /**
+     * @brief findLine
+     * Locates the entry holding the line of @p address without modifying any state. @returns false if the line is not
+     * present.
+     */
+    bool findLine(uint32_t address, unsigned& setIdx, unsigned& wayIdx) const;
+
+    /**
+     * @brief prefetchingAccess
+     * access() with a prefetcher attached: performs the demand access, accounts for prefetch hits and pollution misses,
+     * and performs the prefetch fills requested by the prefetcher.
+     */
+    CacheTransaction prefetchingAccess(uint32_t address, AccessType type, CacheUndoLog* log, uint32_t pc);
+    unsigned pollutionFilterSlot(uint32_t address) const {
+        const uint32_t line = address >> (2 + getBlockBits());
+        return (line ^ (line >> 12)) % s_pollutionFilterBits;
+    }
+
+    /**
+     * @brief exchangeVictim
+     * Moves the line evicted by @p transaction into the victim buffer, and swaps the accessed line back in from the
+     * buffer if it was found there. Updates @p transaction, its undo record in @p log and, if @p countAccess, the
+     * access statistics accordingly.
+     */
+    void exchangeVictim(CacheTransaction& transaction, CacheUndoLog* log, bool countAccess);
+
+    /**
+     * @brief completeAccess
+     * Applies the victim buffer and write buffer, if enabled, to the demand access @p transaction just performed.
+     */
+    void completeAccess(CacheTransaction& transaction, CacheUndoLog* log);
+
+    /**
+     * @brief bufferAccess
+     * Drains the write buffer up to the start of @p transaction, and places a written through write in the buffer.
+     * Updates @p transaction, its undo record in @p log and the statistics accordingly.
+     */
+    void bufferAccess(CacheTransaction& transaction, CacheUndoLog* log);
+    void drainWriteBuffer(uint64_t time);
+    /**
+     * @brief recordWriteBufferSlot
+     * Records @p slot of the write buffer, and its current entry, as the slot modified by the access recorded last in
+     * @p log.
+     */
+    void recordWriteBufferSlot(unsigned slot, CacheUndoLog* log) const;
+    template <typename Policy>
+    unsigned locateEvictionWay(const CacheTransaction& transaction);
+    void evictAndUpdate(CacheTransaction& transaction);
+    template <typename Policy>
+    void analyzeCacheAccess(CacheTransaction& transaction);
+    template <typename Policy>
+    void analyzeCacheAccessSkewedCache(CacheTransaction& transaction);
+    /**
+     * @brief relocate
+     * Performs the relocation walk of the missing line of @p transaction (see setRelocation()), whose index holds the
+     * victim chosen among the first level. Moves the lines on the path to the least valuable candidate, and points the
+     * index of @p transaction to the entry freed for the missing line, which then holds the line to be evicted. The
+     * entries which received a relocated line are left in m_relocationPath, and the address of the line to be evicted
+     * in m_relocatedLineAddress.
+     */
+    void relocate(CacheTransaction& transaction);
+    /**
+     * @brief placeLine
+     * Stores @p line, which keeps its replacement state, and the prefetch completion time @p ready in the entry at
+     * (@p setIdx, @p wayIdx).
+     */
+    void placeLine(unsigned setIdx, unsigned wayIdx, const CacheWay& line, uint64_t ready);
+    /**
+     * @brief getEntryLineAddress
+     * Address of the first word of the line held by the entry at (@p setIdx, @p wayIdx).
+     */
+    uint32_t getEntryLineAddress(unsigned setIdx, unsigned wayIdx) const {
+        return buildAddress(m_storage.tag(setIdx, wayIdx), setIdx, wayIdx, 0);
+    }
+    /**
+     * @brief undoRecord
+     * Reverts the newest record of @p log and removes it from the log.
+     */
+    void undoRecord(CacheUndoLog& log);
+    void setReplacementPolicyObject();
+    /**
+     * @brief revertCacheSetReplFields
+     * Called whenever undoing a transaction to the cache. Reverts a cache set's replacement fields according to the
+     * configured replacement policy, along with the policy state which the transaction changed as per @p update.
+     */
+    void revertCacheSetReplFields(const CacheWay& oldWay, unsigned setIdx, unsigned wayIdx, const ReplUpdate& update);
+
+    /**
+     * @brief isSkewed
+     * True if accesses are indexed through the per-way functions of m_skewHash.
+     */
+    bool isSkewed() const {
+        return m_skewPolicy == SkewedAssocPolicy::Skewed && m_type == CacheType::DataCache && m_sets != 0;
+    }
+    uint32_t getLineNumber(uint32_t address) const { return address >> (2 + getBlockBits()); }
+
+    ReplPolicy m_replPolicy = ReplPolicy::LRU;
+    std::unique_ptr<CachePolicyBase> m_replPolicyObject;
+    AccessFn m_accessFn = nullptr;
+    bool m_recordSetCounters = false;  // See CachePolicyBase::s_updatesSetCounters
+
+    WritePolicy m_wrPolicy = WritePolicy::WriteBack;
+    WriteAllocPolicy m_wrAllocPolicy = WriteAllocPolicy::WriteAllocate;
+    SkewedAssocPolicy m_skewPolicy = SkewedAssocPolicy::NonSkewed;
+    SkewHashType m_skewHashType = SkewHashType::Seznec;
+    SkewHash m_skewHash;
+    // The set index of the accessed line in every way, as computed once per access by m_skewHash
+    std::vector<unsigned> m_skewSets;
+    // Set if the cache is skewed and m_skewHash recovers line numbers, such that tags are those of a non-skewed cache
+    bool m_compactTags = false;
+
+    unsigned m_relocationLevels = 0;
+    struct WalkNode {
+        unsigned set;
+        unsigned way;
+        unsigned parent;  // Node of the line which would move into this entry
+        unsigned level;
+    };
+    // The relocation tree of the most recent walk, in breadth-first order
+    std::vector<WalkNode> m_walk;
+    // The entries which received a relocated line during the most recent walk, from the first level downwards
+    std::vector<CacheIndex> m_relocationPath;
+    uint32_t m_relocatedLineAddress = 0;
+    CacheType m_type = CacheType::DataCache;
+    CacheLatency m_latency;
+    SetDuelingConfig m_dueling;
+    std::shared_ptr<const std::vector<uint32_t>> m_futureAccesses;
+
+    static constexpr unsigned s_pollutionFilterBits = 4096;
+    std::unique_ptr<Prefetcher> m_prefetcher;
+    std::vector<uint32_t> m_prefetchRequests;
+    std::vector<CacheTransaction> m_prefetchTransactions;
+    // Per entry: the accumulated latency at which the prefetch fill of the entry completes
+    std::vector<uint64_t> m_prefetchReady;
+    // Lines evicted by prefetch fills, hashed
+    std::bitset<s_pollutionFilterBits> m_pollutionFilter;
+
+    unsigned m_victimEntries = 0;
+    VictimBuffer m_victims;
+    // Snapshot of the line most recently evicted by evictAndUpdate(), taken only if the victim buffer is enabled
+    CacheWay m_evictedWay;
+
+    WriteBufferConfig m_writeBufferConfig;
+    WriteBuffer m_writeBuffer;
+    unsigned m_chunkWords = 1;  // Words covered by a write buffer entry
+    std::vector<WriteBuffer::Entry> m_drainedWrites;
+    // Set if access() is to call completeAccess()
+    bool m_completeAccess = false;
+
+    SectorConfig m_sectors;
+    bool m_sectored = false;  // m_sectors.enabled, for caches with storage
+
+    bool m_setProfiling = false;
+    std::vector<SetStatistics> m_setStats;
+
+    bool m_missClassification = false;
+    bool m_classifyMisses = false;  // m_missClassification, for caches with storage
+    MissClassifier m_missClassifier;
+
+    unsigned m_blockMask = -1;
+    unsigned m_setMask = -1;
+    unsigned m_tagMask = -1;
+
+    int m_blocks = 0;  // Some power of 2
+    int m_sets = 3;    // Some power of 2
+    int m_ways = 2;    // Some power of 2
+
+    /**
+     * @brief m_storage
+     * The datastructure for storing our cache hierachy, as per the current cache configuration. All sets and ways are
+     * allocated up front in a flat layout whenever the configuration changes.
+     */
+    CacheStorage m_storage;
+
+    CacheStatistics m_stats;
+};
+
+}  // namespace Ripes
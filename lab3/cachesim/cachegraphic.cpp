@@ -1,5 +1,7 @@
 #include "cachegraphic.h"
 
+#include <algorithm>
+
 #include <QGraphicsLineItem>
 #include <QGraphicsRectItem>
 #include <QGraphicsScene>
@@ -9,19 +11,6 @@
 #include "processorhandler.h"
 #include "radix.h"
 
-namespace {
-
-// Return a set of all keys in a map
-template <typename TK, typename TV>
-std::set<TK> keys(std::map<TK, TV> const& input_map) {
-    std::set<TK> keyset;
-    for (auto const& element : input_map) {
-        keyset.insert(element.first);
-    }
-    return keyset;
-}
-}  // namespace
-
 namespace Ripes {
 
 CacheGraphic::CacheGraphic(CacheSim& cache) : QGraphicsObject(nullptr), m_cache(cache), m_fm(m_font) {
@@ -34,13 +23,6 @@ CacheGraphic::CacheGraphic(CacheSim& cache) : QGraphicsObject(nullptr), m_cache(
 }
 
 void CacheGraphic::updateSetReplFields(unsigned setIdx) {
-    auto* cacheSet = m_cache.getSet(setIdx);
-
-    if (cacheSet == nullptr) {
-        // Nothing to do
-        return;
-    }
-
     if (m_cacheTextItems.at(0).at(0).counter == nullptr) {
         // The current cache configuration does not have any replacement field
         return;
@@ -49,8 +31,8 @@ void CacheGraphic::updateSetReplFields(unsigned setIdx) {
     for (const auto& way : m_cacheTextItems[setIdx]) {
         // If counter was just initialized, the actual (software) counter value may be very large. Mask to the
         // number of actual counter bits.
-        unsigned counterVal = cacheSet->at(way.first).counter;
-        counterVal &= generateBitmask(m_cache.getWaysBits());
+        unsigned counterVal = m_cache.getEngine().getReplCounter(setIdx, way.first);
+        counterVal &= generateBitmask(m_cache.getEngine().getReplCounterBits());
         const QString counterText = QString::number(counterVal);
         way.second.counter->setText(counterText);
 
@@ -64,10 +46,16 @@ void CacheGraphic::updateSetReplFields(unsigned setIdx) {
 
 void CacheGraphic::updateWay(unsigned setIdx, unsigned wayIdx) {
     CacheWay& way = m_cacheTextItems.at(setIdx).at(wayIdx);
-    const auto& simWay = m_cache.getSet(setIdx)->at(wayIdx);
+    const auto simWay = m_cache.getStorage().way(setIdx, wayIdx);
     // ======================== Update block text fields ======================
     if (simWay.valid) {
+        const bool sectored = m_cache.getStorage().sectored();
         for (int i = 0; i < m_cache.getBlocks(); i++) {
+            if (sectored && !simWay.validBlocks.test(i)) {
+                // The sector has not been fetched
+                way.blocks.erase(i);
+                continue;
+            }
             QGraphicsSimpleTextItem* blockTextItem = nullptr;
             if (way.blocks.count(i) == 0) {
                 // Block text item has not yet been created
@@ -82,7 +70,7 @@ void CacheGraphic::updateWay(unsigned setIdx, unsigned wayIdx) {
             }
 
             // Update block text
-            const uint32_t addressForBlock = m_cache.buildAddress(simWay.tag, setIdx, i);
+            const uint32_t addressForBlock = m_cache.buildAddress(simWay.tag, setIdx, wayIdx, i);
             const auto data = ProcessorHandler::get()->getMemory().readMemConst(addressForBlock);
             const QString text = encodeRadixValue(data, Radix::Hex);
             blockTextItem->setText(text);
@@ -125,20 +113,19 @@ void CacheGraphic::updateWay(unsigned setIdx, unsigned wayIdx) {
     }
 
     // ==================== Update dirty blocks highlighting ==================
-    const std::set<unsigned> graphicDirtyBlocks = keys(way.dirtyBlocks);
-    std::set<unsigned> newDirtyBlocks;
-    std::set<unsigned> dirtyBlocksToDelete;
-    std::set_difference(graphicDirtyBlocks.begin(), graphicDirtyBlocks.end(), simWay.dirtyBlocks.begin(),
-                        simWay.dirtyBlocks.end(), std::inserter(dirtyBlocksToDelete, dirtyBlocksToDelete.begin()));
-    std::set_difference(simWay.dirtyBlocks.begin(), simWay.dirtyBlocks.end(), graphicDirtyBlocks.begin(),
-                        graphicDirtyBlocks.end(), std::inserter(newDirtyBlocks, newDirtyBlocks.begin()));
-
     // Delete blocks which are not in sync with the current dirty status of the way
-    for (const unsigned& blockToDelete : dirtyBlocksToDelete) {
-        way.dirtyBlocks.erase(blockToDelete);
+    for (auto it = way.dirtyBlocks.begin(); it != way.dirtyBlocks.end();) {
+        if (!simWay.dirtyBlocks.test(it->first)) {
+            it = way.dirtyBlocks.erase(it);
+        } else {
+            ++it;
+        }
     }
     // Create all required new blocks
-    for (const auto& blockIdx : newDirtyBlocks) {
+    simWay.dirtyBlocks.forEach([&](unsigned blockIdx) {
+        if (way.dirtyBlocks.count(blockIdx) != 0) {
+            return;
+        }
         const auto topLeft =
             QPointF(blockIdx * m_blockWidth + m_widthBeforeBlocks, setIdx * m_setHeight + wayIdx * m_wayHeight);
         const auto bottomRight = QPointF((blockIdx + 1) * m_blockWidth + m_widthBeforeBlocks,
@@ -149,7 +136,7 @@ void CacheGraphic::updateWay(unsigned setIdx, unsigned wayIdx) {
         dirtyRectItem->setZValue(-1);
         dirtyRectItem->setOpacity(0.4);
         dirtyRectItem->setBrush(Qt::darkCyan);
-    }
+    });
 
 }
 
@@ -171,12 +158,37 @@ std::unique_ptr<QGraphicsSimpleTextItem> CacheGraphic::createGraphicsTextItemSP(
 
 void CacheGraphic::cacheInvalidated() {
     for (int setIdx = 0; setIdx < m_cache.getSets(); setIdx++) {
-        if (const auto* set = m_cache.getSet(setIdx)) {
-            for (const auto& way : *set) {
-                updateWay(setIdx, way.first);
-            }
-            updateSetReplFields(setIdx);
+        for (int wayIdx = 0; wayIdx < m_cache.getWays(); wayIdx++) {
+            updateWay(setIdx, wayIdx);
         }
+        updateSetReplFields(setIdx);
+    }
+    updateSetStatistics();
+}
+
+void CacheGraphic::updateSetStatistics() {
+    const auto& sets = m_cache.getEngine().getSetStatistics();
+    if (sets.size() != m_setHeatItems.size()) {
+        return;
+    }
+    uint64_t maxMisses = 0;
+    for (const auto& set : sets) {
+        maxMisses = std::max(maxMisses, set.misses);
+    }
+    for (unsigned setIdx = 0; setIdx < sets.size(); setIdx++) {
+        const auto& set = sets[setIdx];
+        const int alpha = maxMisses == 0 ? 0 : static_cast<int>(160 * set.misses / maxMisses);
+        m_setHeatItems[setIdx]->setBrush(QColor(255, 0, 0, alpha));
+        m_setHeatItems[setIdx]->setToolTip(QString("Accesses: %1\nMisses: %2\nEvictions: %3\nWritebacks: %4")
+                                               .arg(set.accesses)
+                                               .arg(set.misses)
+                                               .arg(set.evictions)
+                                               .arg(set.writebacks));
+
+        const QString missText = QString::number(set.misses);
+        m_setMissItems[setIdx]->setText(missText);
+        m_setMissItems[setIdx]->setPos(m_cacheWidth + m_heatWidth / 2 - m_fm.width(missText) / 2,
+                                       setIdx * m_setHeight + m_setHeight / 2 - m_wayHeight / 2);
     }
 }
 
@@ -196,6 +208,7 @@ void CacheGraphic::dataChanged(const CacheSim::CacheTransaction* transaction) {
     } else {
         updateHighlighting(false, nullptr);
     }
+    updateSetStatistics();
 }
 
 QGraphicsSimpleTextItem* CacheGraphic::drawText(const QString& text, qreal x, qreal y) {
@@ -250,7 +263,6 @@ void CacheGraphic::updateHighlighting(bool active, const CacheSim::CacheTransact
 void CacheGraphic::initializeControlBits() {
     for (int setIdx = 0; setIdx < m_cache.getSets(); setIdx++) {
         auto& set = m_cacheTextItems[setIdx];
-        auto* cacheSet = m_cache.getSet(setIdx);
         for (int wayIdx = 0; wayIdx < m_cache.getWays(); wayIdx++) {
             const qreal y = setIdx * m_setHeight + wayIdx * m_wayHeight;
             qreal x;
@@ -285,6 +297,8 @@ void CacheGraphic::cacheParametersChanged() {
     // Remove all items
     m_highlightingItems.clear();
     m_cacheTextItems.clear();
+    m_setHeatItems.clear();
+    m_setMissItems.clear();
     for (const auto& item : childItems())
         delete item;
 
@@ -293,7 +307,9 @@ void CacheGraphic::cacheParametersChanged() {
     m_setHeight = m_wayHeight * m_cache.getWays();
     m_blockWidth = m_fm.width(" 0x00000000 ");
     m_bitWidth = m_fm.width("00");
-    m_counterWidth = m_fm.width(QString::number(m_cache.getWays()) + "   ");
+    const unsigned maxCounter =
+        std::max<unsigned>(m_cache.getWays(), generateBitmask(m_cache.getEngine().getReplCounterBits()));
+    m_counterWidth = m_fm.width(QString::number(maxCounter) + "   ");
     m_cacheHeight = m_setHeight * m_cache.getSets();
     m_tagWidth = m_blockWidth;
 
@@ -381,7 +397,24 @@ void CacheGraphic::cacheParametersChanged() {
     const qreal x = -m_fm.width(indexText) * 1.2;
     drawText(indexText, x, -m_fm.height());
 
+    // Draw the miss heatmap column, to the right of the cache, if the per-set counters are enabled
+    if (m_cache.getSetProfiling()) {
+        m_heatWidth = m_fm.width(" 00000000 ");
+        const QString missText = "Misses";
+        auto* missItem =
+            drawText(missText, m_cacheWidth + m_heatWidth / 2 - m_fm.width(missText) / 2, -m_fm.height());
+        missItem->setToolTip("Misses per set, shaded relative to the set with the most misses");
+        for (int i = 0; i < m_cache.getSets(); i++) {
+            auto* heatItem =
+                new QGraphicsRectItem(QRectF(m_cacheWidth, i * m_setHeight, m_heatWidth, m_setHeight), this);
+            heatItem->setZValue(-1);
+            m_setHeatItems.push_back(heatItem);
+            m_setMissItems.push_back(drawText("0", 0, 0));
+        }
+    }
+
     initializeControlBits();
+    updateSetStatistics();
 }
 
 }  // namespace Ripes
@@ -74,6 +74,12 @@ private:
     // Graphical update functions
     void updateSetReplFields(unsigned setIdx);
     void updateWay(unsigned setIdx, unsigned wayIdx);
+    /**
+     * @brief updateSetStatistics
+     * Updates the miss heatmap column drawn next to the cache, shading each set by its misses relative to the set with
+     * the most misses.
+     */
+    void updateSetStatistics();
 
     QFont m_font = QFont("Inconsolata", 12);
     CacheSim& m_cache;
@@ -95,6 +101,11 @@ private:
     qreal m_widthBeforeCounter = 0;
     qreal m_widthBeforeDirty = 0;
     qreal m_counterWidth = 0;
+    qreal m_heatWidth = 0;
+
+    // Per set: the shaded cell and miss count of the heatmap column
+    std::vector<QGraphicsRectItem*> m_setHeatItems;
+    std::vector<QGraphicsSimpleTextItem*> m_setMissItems;
 
     /**
      * @brief m_cacheTextItems
@@ -0,0 +1,249 @@
+#include "cachehierarchy.h"
+
+namespace Ripes {
+
+namespace {
+
+/**
+ * Calls @p f for each line of @p cache overlapping the @p bytes bytes at @p address. The first call receives
+ * @p address itself, such that single-word requests keep their block index.
+ */
+template <typename F>
+void forEachLine(const CacheEngine& cache, uint32_t address, unsigned bytes, F f) {
+    const uint64_t end = static_cast<uint64_t>(address) + bytes;
+    const unsigned step = 4u << cache.getBlockBits();
+    for (uint64_t line = cache.getLineAddress(address); line < end; line += step) {
+        f(line < address ? address : static_cast<uint32_t>(line));
+    }
+}
+
+}  // namespace
+
+CacheHierarchy::CacheHierarchy() {
+    m_l1i.setType(CacheEngine::CacheType::InstrCache);
+    m_l1d.setType(CacheEngine::CacheType::DataCache);
+}
+
+CacheEngine& CacheHierarchy::addLevel(InclusionPolicy inclusion) {
+    m_levels.push_back(std::make_unique<Level>());
+    m_levels.back()->inclusion = inclusion;
+    reset();
+    return m_levels.back()->engine;
+}
+
+void CacheHierarchy::clearLevels() {
+    m_levels.clear();
+    reset();
+}
+
+void CacheHierarchy::setInclusionPolicy(unsigned idx, InclusionPolicy inclusion) {
+    m_levels.at(idx)->inclusion = inclusion;
+    reset();
+}
+
+void CacheHierarchy::reset() {
+    m_l1i.reset();
+    m_l1d.reset();
+    for (auto& level : m_levels) {
+        level->engine.reset();
+    }
+    m_memory = MemoryStatistics();
+    m_latencyCycles = 0;
+    m_accesses = 0;
+}
+
+void CacheHierarchy::setMemoryLatency(unsigned readLatency, unsigned writeLatency) {
+    m_memoryReadLatency = readLatency;
+    m_memoryWriteLatency = writeLatency;
+    reset();
+}
+
+unsigned CacheHierarchy::access(uint32_t address, CacheEngine::AccessType type, bool isInstr, uint32_t pc) {
+    CacheEngine& l1 = isInstr ? m_l1i : m_l1d;
+    m_accessLatency = 0;
+    if (l1.getReplacementPolicy() == CacheEngine::ReplPolicy::NoCache) {
+        if (type == CacheEngine::AccessType::Read) {
+            fetch(0, address, 4);
+        } else {
+            write(0, address, 4, false);
+        }
+    } else {
+        const auto transaction = l1.access(address, type, nullptr, isInstr ? address : pc);
+        m_accessLatency += l1.getLatency().hitLatency;
+        handleTransaction(l1, -1, 0, transaction, false);
+        handlePrefetches(l1, -1, 0);
+        handleDrains(l1, 0);
+    }
+    m_latencyCycles += m_accessLatency;
+    m_accesses++;
+    return m_accessLatency;
+}
+
+void CacheHierarchy::handleTransaction(CacheEngine& cache, int self, unsigned next,
+                                       const CacheEngine::CacheTransaction& transaction, bool fullLine) {
+    const unsigned bytes = lineBytes(cache);
+
+    // A line was allocated; fetch its contents from below, unless it was swapped in from the victim buffer. This is
+    // done before handing down the evicted line, such that an exclusive level below has released the fetched line
+    // before receiving the victim. A sectored cache only fetches the sectors it validated, including on sector misses.
+    if (transaction.fetchBlocks != 0 && !fullLine) {
+        if (cache.getSectoring().enabled) {
+            fetch(next, transaction.address, transaction.fetchBlocks * 4);
+        } else {
+            fetch(next, cache.getLineAddress(transaction.address), bytes);
+        }
+    }
+
+    if (transaction.evicted) {
+        if (self >= 0 && m_levels[self]->inclusion == InclusionPolicy::Inclusive) {
+            backInvalidate(self, transaction.evictedAddress, bytes);
+        }
+        if (isExclusive(next)) {
+            insertVictim(next, transaction.evictedAddress, bytes, transaction.evictedDirty);
+        } else if (transaction.evictedDirty) {
+            write(next, transaction.evictedAddress, bytes, true);
+        }
+    }
+
+    // Writes which are not retained by this level (write-through, or write misses without allocation)
+    if (transaction.type == CacheEngine::AccessType::Write && transaction.isWriteback && !transaction.evictedDirty) {
+        write(next, transaction.address, fullLine ? bytes : 4, fullLine);
+    }
+}
+
+void CacheHierarchy::handlePrefetches(CacheEngine& cache, int self, unsigned next) {
+    if (cache.getPrefetchTransactions().empty()) {
+        return;
+    }
+    // Prefetch fills are off the critical path of the access which triggered them
+    const unsigned accessLatency = m_accessLatency;
+    // Handling the fills may access the same cache again through back-invalidations; iterate over a copy
+    const std::vector<CacheEngine::CacheTransaction> fills = cache.getPrefetchTransactions();
+    for (const auto& fill : fills) {
+        handleTransaction(cache, self, next, fill, false);
+    }
+    m_accessLatency = accessLatency;
+}
+
+void CacheHierarchy::handleDrains(CacheEngine& cache, unsigned next) {
+    if (cache.getDrainedWrites().empty()) {
+        return;
+    }
+    // As prefetch fills, buffered writes drain off the critical path
+    const unsigned accessLatency = m_accessLatency;
+    const unsigned chunkWords = cache.getWriteBufferChunkWords();
+    const uint64_t allWords = chunkWords >= 64 ? ~uint64_t(0) : (uint64_t(1) << chunkWords) - 1;
+    const std::vector<WriteBuffer::Entry> drained = cache.getDrainedWrites();
+    for (const auto& entry : drained) {
+        if (entry.words == allWords) {
+            write(next, entry.address, chunkWords * 4, chunkWords * 4 >= lineBytes(cache));
+            continue;
+        }
+        for (unsigned word = 0; word < chunkWords; word++) {
+            if (entry.words & (uint64_t(1) << word)) {
+                write(next, entry.address + word * 4, 4, false);
+            }
+        }
+    }
+    m_accessLatency = accessLatency;
+}
+
+void CacheHierarchy::fetch(unsigned level, uint32_t address, unsigned bytes) {
+    if (level >= m_levels.size()) {
+        m_memory.reads++;
+        m_accessLatency += m_memoryReadLatency;
+        return;
+    }
+    CacheEngine& cache = m_levels[level]->engine;
+    if (cache.getReplacementPolicy() == CacheEngine::ReplPolicy::NoCache) {
+        fetch(level + 1, address, bytes);
+        return;
+    }
+
+    forEachLine(cache, address, bytes, [&](uint32_t lineAddress) {
+        m_accessLatency += cache.getLatency().hitLatency;
+        if (isExclusive(level)) {
+            const auto transaction = cache.probe(lineAddress, CacheEngine::AccessType::Read);
+            if (transaction.isHit) {
+                // The line moves up into the requesting level
+                bool dirty = false;
+                cache.invalidate(lineAddress, &dirty);
+                if (dirty) {
+                    write(level + 1, cache.getLineAddress(lineAddress), lineBytes(cache), true);
+                }
+            } else {
+                fetch(level + 1, lineAddress, lineBytes(cache));
+            }
+        } else {
+            const auto transaction = cache.access(lineAddress, CacheEngine::AccessType::Read);
+            handleTransaction(cache, level, level + 1, transaction, false);
+            handlePrefetches(cache, level, level + 1);
+            handleDrains(cache, level + 1);
+        }
+    });
+}
+
+void CacheHierarchy::write(unsigned level, uint32_t address, unsigned bytes, bool fullLine) {
+    if (level >= m_levels.size()) {
+        m_memory.writes++;
+        m_accessLatency += m_memoryWriteLatency;
+        return;
+    }
+    CacheEngine& cache = m_levels[level]->engine;
+    if (cache.getReplacementPolicy() == CacheEngine::ReplPolicy::NoCache) {
+        write(level + 1, address, bytes, fullLine);
+        return;
+    }
+
+    // A line write only covers a line of this level entirely if the lines of this level are not larger
+    const bool coversLine = fullLine && bytes >= lineBytes(cache);
+    forEachLine(cache, address, bytes, [&](uint32_t lineAddress) {
+        m_accessLatency += cache.getLatency().hitLatency;
+        if (isExclusive(level)) {
+            handleTransaction(cache, level, level + 1, cache.probe(lineAddress, CacheEngine::AccessType::Write),
+                              coversLine);
+        } else {
+            handleTransaction(cache, level, level + 1, cache.access(lineAddress, CacheEngine::AccessType::Write),
+                              coversLine);
+            handlePrefetches(cache, level, level + 1);
+            handleDrains(cache, level + 1);
+        }
+    });
+}
+
+void CacheHierarchy::insertVictim(unsigned level, uint32_t address, unsigned bytes, bool dirty) {
+    CacheEngine& cache = m_levels[level]->engine;
+    if (cache.getReplacementPolicy() == CacheEngine::ReplPolicy::NoCache) {
+        if (dirty) {
+            write(level + 1, address, bytes, true);
+        }
+        return;
+    }
+    forEachLine(cache, address, bytes, [&](uint32_t lineAddress) {
+        m_accessLatency += cache.getLatency().hitLatency;
+        const auto transaction = cache.insert(lineAddress, dirty);
+        handleTransaction(cache, level, level + 1, transaction, true);
+    });
+}
+
+void CacheHierarchy::backInvalidate(unsigned level, uint32_t address, unsigned bytes) {
+    auto invalidateIn = [&](CacheEngine& cache) {
+        forEachLine(cache, address, bytes, [&](uint32_t lineAddress) {
+            bool dirty = false;
+            if (cache.invalidate(lineAddress, &dirty)) {
+                m_memory.backInvalidations++;
+                if (dirty) {
+                    // The upper copy is the newest version of the line
+                    write(level + 1, cache.getLineAddress(lineAddress), lineBytes(cache), true);
+                }
+            }
+        });
+    };
+    invalidateIn(m_l1i);
+    invalidateIn(m_l1d);
+    for (unsigned upper = 0; upper < level; upper++) {
+        invalidateIn(m_levels[upper]->engine);
+    }
+}
+
+}  // namespace Ripes
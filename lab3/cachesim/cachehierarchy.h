@@ -0,0 +1,162 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "cacheengine.h"
+
+namespace Ripes {
+
+/**
+ * @brief The CacheHierarchy class
+ * A multi-level cache hierarchy: split L1 instruction and data caches, backed by any number of shared (unified) levels
+ * and finally main memory. Each level is an independent CacheEngine with its own geometry and policies, and thereby its
+ * own statistics.
+ *
+ * Misses of a level fetch the line from the level below it, and lines written back (or written through) by a level are
+ * written to the level below it. Lines are transferred in units of the line size of the level sending the request; if
+ * the level below has smaller lines, the request is split across them.
+ *
+ * Each shared level has an inclusion policy, describing its relation to the levels above it:
+ * - NonInclusive: lines are allocated on fetches and writebacks; evictions do not affect the levels above.
+ * - Inclusive: as NonInclusive, but evicting a line also invalidates it in all levels above (back-invalidation). The
+ *   newest copy of a line which was dirty in a level above is written to the level below.
+ * - Exclusive: the level only holds lines evicted from the levels above (clean or dirty). A fetch which hits moves the
+ *   line up and removes it from the level; a fetch which misses is served by the level below without allocating.
+ *   The dirty state of a line moved up is not tracked in the receiving level; it is written to the level below instead.
+ *   A line held by both L1 caches is handed down when either evicts it, and may thus coexist with the other L1 copy.
+ *
+ * The latency of an access is the sum of the hit latencies of all cache lookups it causes, and the memory latency of
+ * all of its memory requests; transfers are not overlapped. Only the hit latency of the CacheLatency of each level is
+ * used, given that its miss and writeback penalties are determined by the levels below it.
+ *
+ * Prefetch fills of a level with a prefetcher attached are fetched from the level below as any other fill, without
+ * adding to the latency of the access triggering them. Only the L1 prefetchers observe the PC of the accessing
+ * instruction. Likewise, the entries drained from the write buffer of a level are written to the level below off the
+ * critical path; stalls on a full write buffer only show in the statistics of its level.
+ *
+ * A sectored level (see CacheEngine::setSectoring()) fetches only the sectors filled by a miss from the level below. A
+ * request to a sectored level is looked up at its first word; the sectors it fetches are those of that word onwards.
+ */
+class CacheHierarchy {
+public:
+    enum class InclusionPolicy { NonInclusive, Inclusive, Exclusive };
+
+    /**
+     * @brief The MemoryStatistics struct
+     * Requests between the last cache level and main memory.
+     */
+    struct MemoryStatistics {
+        uint64_t reads = 0;
+        uint64_t writes = 0;
+        uint64_t backInvalidations = 0;  // Lines invalidated in upper levels by inclusive evictions
+    };
+
+    CacheHierarchy();
+    CacheHierarchy(const CacheHierarchy&) = delete;
+    CacheHierarchy& operator=(const CacheHierarchy&) = delete;
+
+    CacheEngine& getL1I() { return m_l1i; }
+    CacheEngine& getL1D() { return m_l1d; }
+    const CacheEngine& getL1I() const { return m_l1i; }
+    const CacheEngine& getL1D() const { return m_l1d; }
+
+    /**
+     * @brief addLevel
+     * Appends a shared level below the current lowest level. @returns the engine of the new level, to be configured
+     * by the caller.
+     */
+    CacheEngine& addLevel(InclusionPolicy inclusion = InclusionPolicy::NonInclusive);
+    void clearLevels();
+
+    /**
+     * Shared levels are indexed from 0, being the L2.
+     */
+    unsigned getLevelCount() const { return m_levels.size(); }
+    CacheEngine& getLevel(unsigned idx) { return m_levels.at(idx)->engine; }
+    const CacheEngine& getLevel(unsigned idx) const { return m_levels.at(idx)->engine; }
+    InclusionPolicy getInclusionPolicy(unsigned idx) const { return m_levels.at(idx)->inclusion; }
+    void setInclusionPolicy(unsigned idx, InclusionPolicy inclusion);
+
+    /**
+     * @brief reset
+     * Invalidates the contents and clears the statistics of all levels.
+     */
+    void reset();
+
+    /**
+     * @brief access
+     * Performs an access of the processor to the L1 instruction cache (@p isInstr) or L1 data cache, and propagates
+     * all resulting line transfers through the hierarchy. @p pc is the address of the accessing data instruction, if
+     * known; for instruction fetches, it is @p address itself. @returns the latency of the access, in cycles.
+     */
+    unsigned access(uint32_t address, CacheEngine::AccessType type, bool isInstr, uint32_t pc = Prefetcher::s_noPc);
+
+    /**
+     * @brief setMemoryLatency
+     * Cycles taken by main memory to serve a read or write request.
+     */
+    void setMemoryLatency(unsigned readLatency, unsigned writeLatency);
+
+    const MemoryStatistics& getMemoryStatistics() const { return m_memory; }
+
+    /**
+     * @brief getAMAT
+     * Average latency of the accesses performed through access(), in cycles.
+     */
+    double getAMAT() const { return m_accesses == 0 ? 0 : static_cast<double>(m_latencyCycles) / m_accesses; }
+
+private:
+    struct Level {
+        CacheEngine engine;
+        InclusionPolicy inclusion = InclusionPolicy::NonInclusive;
+    };
+
+    static unsigned lineBytes(const CacheEngine& cache) { return 4u << cache.getBlockBits(); }
+    bool isExclusive(unsigned level) const {
+        return level < m_levels.size() && m_levels[level]->inclusion == InclusionPolicy::Exclusive;
+    }
+
+    /**
+     * @brief handleTransaction
+     * Propagates the consequences of @p transaction, performed on @p cache, to the level @p next below it. @p self is
+     * the shared level index of @p cache, or -1 for an L1 cache. If @p fullLine is set, the transaction wrote an entire
+     * line, and a missing line does not have to be fetched.
+     */
+    void handleTransaction(CacheEngine& cache, int self, unsigned next, const CacheEngine::CacheTransaction& transaction,
+                           bool fullLine);
+
+    /**
+     * @brief handlePrefetches
+     * Propagates the prefetch fills performed by the most recent access to @p cache, as handleTransaction(). Their
+     * latency is not accounted to the access.
+     */
+    void handlePrefetches(CacheEngine& cache, int self, unsigned next);
+
+    /**
+     * @brief handleDrains
+     * Writes the write buffer entries drained by the most recent access to @p cache to level @p next. As prefetch
+     * fills, their latency is not accounted to the access.
+     */
+    void handleDrains(CacheEngine& cache, unsigned next);
+
+    void fetch(unsigned level, uint32_t address, unsigned bytes);
+    void write(unsigned level, uint32_t address, unsigned bytes, bool fullLine);
+    void insertVictim(unsigned level, uint32_t address, unsigned bytes, bool dirty);
+    void backInvalidate(unsigned level, uint32_t address, unsigned bytes);
+
+    CacheEngine m_l1i;
+    CacheEngine m_l1d;
+    std::vector<std::unique_ptr<Level>> m_levels;
+    MemoryStatistics m_memory;
+
+    unsigned m_memoryReadLatency = 100;
+    unsigned m_memoryWriteLatency = 100;
+    // Latency of the access currently being performed, accumulated as it propagates through the hierarchy
+    unsigned m_accessLatency = 0;
+    uint64_t m_latencyCycles = 0;
+    uint64_t m_accesses = 0;
+};
+
+}  // namespace Ripes
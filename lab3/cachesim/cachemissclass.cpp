@@ -0,0 +1,108 @@
+#include "cachemissclass.h"
+
+#include <cassert>
+
+namespace Ripes {
+
+void MissClassifier::reset(unsigned lines, unsigned lineBits) {
+    const unsigned pages = lineBits > s_pageBits ? 1u << (lineBits - s_pageBits) : 1;
+    m_touched.clear();
+    m_touched.resize(pages);
+    m_lines.assign(lines, 0);
+    m_prev.assign(lines, s_noNode);
+    m_next.assign(lines, s_noNode);
+    m_size = 0;
+    m_head = s_noNode;
+    m_tail = s_noNode;
+    m_nodes.clear();
+    m_nodes.reserve(lines);
+}
+
+MissClass MissClassifier::access(uint32_t line, bool miss, Change* change) {
+    assert(!m_lines.empty() && "Miss classifier was not reset");
+    Change local;
+    Change& c = change ? *change : local;
+    c = Change();
+    c.observed = true;
+
+    std::vector<uint64_t>& page = m_touched[(line >> s_pageBits) % m_touched.size()];
+    if (page.empty()) {
+        page.assign((1u << s_pageBits) / 64, 0);
+    }
+    const unsigned bit = line & ((1u << s_pageBits) - 1);
+    c.firstTouch = !((page[bit / 64] >> (bit % 64)) & 1);
+    page[bit / 64] |= uint64_t(1) << (bit % 64);
+
+    unsigned node;
+    const auto it = m_nodes.find(line);
+    c.shadowHit = it != m_nodes.end();
+    if (c.shadowHit) {
+        node = it->second;
+        c.next = m_next[node];
+        unlink(node);
+    } else {
+        if (m_size < m_lines.size()) {
+            node = m_size++;
+        } else {
+            node = m_tail;
+            c.evicted = true;
+            c.evictedLine = m_lines[node];
+            m_nodes.erase(c.evictedLine);
+            unlink(node);
+        }
+        m_lines[node] = line;
+        m_nodes.emplace(line, node);
+    }
+    insertBefore(node, m_head);
+
+    if (!miss) {
+        return MissClass::None;
+    }
+    return c.firstTouch ? MissClass::Compulsory : c.shadowHit ? MissClass::Conflict : MissClass::Capacity;
+}
+
+void MissClassifier::undo(const Change& change) {
+    if (!change.observed) {
+        return;
+    }
+    const unsigned node = m_head;
+    const uint32_t line = m_lines[node];
+    unlink(node);
+    if (change.shadowHit) {
+        insertBefore(node, change.next);
+    } else {
+        m_nodes.erase(line);
+        if (change.evicted) {
+            m_lines[node] = change.evictedLine;
+            m_nodes.emplace(change.evictedLine, node);
+            insertBefore(node, s_noNode);
+        } else {
+            // Nodes are taken from the pool in order, so the most recently taken one is the last in use
+            assert(node == m_size - 1);
+            m_size--;
+        }
+    }
+    if (change.firstTouch) {
+        const unsigned bit = line & ((1u << s_pageBits) - 1);
+        m_touched[(line >> s_pageBits) % m_touched.size()][bit / 64] &= ~(uint64_t(1) << (bit % 64));
+    }
+}
+
+void MissClassifier::unlink(unsigned node) {
+    const unsigned prev = m_prev[node];
+    const unsigned next = m_next[node];
+    (prev == s_noNode ? m_head : m_next[prev]) = next;
+    (next == s_noNode ? m_tail : m_prev[next]) = prev;
+    m_prev[node] = s_noNode;
+    m_next[node] = s_noNode;
+}
+
+void MissClassifier::insertBefore(unsigned node, unsigned next) {
+    const unsigned prev = next == s_noNode ? m_tail : m_prev[next];
+    m_prev[node] = prev;
+    m_next[node] = next;
+    (prev == s_noNode ? m_head : m_next[prev]) = node;
+    (next == s_noNode ? m_tail : m_prev[next]) = node;
+}
+
+}  // namespace Ripes
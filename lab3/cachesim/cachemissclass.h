@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace Ripes {
+
+/**
+ * @brief The MissClass enum
+ * The 3C classification of a miss (see MissClassifier); None for hits and unclassified accesses.
+ */
+enum class MissClass { None, Compulsory, Capacity, Conflict };
+
+/**
+ * @brief The MissClassifier class
+ * Online 3C classification of the misses of a cache, after Hill. A miss on a line which was never accessed before is
+ * compulsory. Any other miss is a capacity miss if it also misses in a fully associative LRU cache of the same number
+ * of lines (the shadow cache), and a conflict miss otherwise.
+ *
+ * The accessed lines are kept in a bitmap over line numbers, whose pages are allocated upon their first touch. The
+ * shadow cache is an intrusive recency list over a fixed pool of nodes, along with a map from line numbers to nodes.
+ * Every access may be reverted through undo(), given the Change it recorded, in reverse order of the accesses.
+ */
+class MissClassifier {
+public:
+    static constexpr unsigned s_noNode = static_cast<unsigned>(-1);
+
+    /**
+     * @brief The Change struct
+     * The changes performed by a single access, as required by undo().
+     */
+    struct Change {
+        bool observed = false;     // The access was observed by the classifier
+        bool firstTouch = false;   // The access was the first to the line
+        bool shadowHit = false;    // The line was held by the shadow cache
+        bool evicted = false;      // The access evicted the LRU line of the shadow cache
+        unsigned next = s_noNode;  // On a shadow hit, the node following the line in recency order prior to the access
+        uint32_t evictedLine = 0;
+    };
+
+    /**
+     * @brief reset
+     * Forgets all accessed lines, and sizes the shadow cache to @p lines lines of line numbers of @p lineBits bits.
+     */
+    void reset(unsigned lines, unsigned lineBits);
+
+    /**
+     * @brief access
+     * Observes an access to @p line, which missed in the cache if @p miss. @returns the class of the miss, or
+     * MissClass::None for hits. If @p change is provided, the changes performed by the access are recorded to it.
+     */
+    MissClass access(uint32_t line, bool miss, Change* change = nullptr);
+
+    /**
+     * @brief undo
+     * Reverts the access which recorded @p change. Accesses must be reverted in reverse order.
+     */
+    void undo(const Change& change);
+
+private:
+    static constexpr unsigned s_pageBits = 15;  // Line numbers per page of the bitmap, in log2
+
+    void unlink(unsigned node);
+    // Inserts @p node before @p next, or at the LRU end of the list if next is s_noNode
+    void insertBefore(unsigned node, unsigned next);
+
+    // Pages of the bitmap of accessed lines; empty until touched
+    std::vector<std::vector<uint64_t>> m_touched;
+
+    // Shadow cache nodes; the first m_size nodes are in use
+    std::vector<uint32_t> m_lines;
+    std::vector<unsigned> m_prev;
+    std::vector<unsigned> m_next;
+    unsigned m_size = 0;
+    unsigned m_head = s_noNode;  // Most recently used
+    unsigned m_tail = s_noNode;  // Least recently used
+    std::unordered_map<uint32_t, unsigned> m_nodes;
+};
+
+}  // namespace Ripes
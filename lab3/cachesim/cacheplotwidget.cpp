@@ -3,11 +3,13 @@
 
 #include <QClipboard>
 #include <QFileDialog>
+#include <QMessageBox>
 #include <QToolBar>
 #include <QtCharts/QAreaSeries>
 #include <QtCharts/QChartView>
 #include <QtCharts/QLineSeries>
 #include <QtCharts/QValueAxis>
+#include <algorithm>
 
 #include "enumcombobox.h"
 #include "processorhandler.h"
@@ -61,7 +63,7 @@ void finishSeries(QLineSeries& series, const unsigned max) {
 
 namespace Ripes {
 
-CachePlotWidget::CachePlotWidget(const CacheSim& sim, QWidget* parent)
+CachePlotWidget::CachePlotWidget(CacheSim& sim, QWidget* parent)
     : QDialog(parent), m_ui(new Ui::CachePlotWidget), m_cache(sim) {
     m_ui->setupUi(this);
     setWindowTitle("Cache Access Statistics");
@@ -140,17 +142,55 @@ void CachePlotWidget::setupToolbar() {
 void CachePlotWidget::plotTypeChanged() {
     m_plotType = getEnumValue<PlotType>(m_ui->plotType);
 
+    // The reuse profiler is off by default; selecting one of its plots enables it, starting an empty profile
+    const bool profilePlot = m_plotType == PlotType::ReuseDistance || m_plotType == PlotType::WorkingSet;
+    const bool profilingStarted = profilePlot && !m_cache.getReuseProfiling();
+    if (profilingStarted) {
+        m_cache.setReuseProfiling(true);
+    }
+
     if (m_plotType == PlotType::Ratio) {
         m_ui->configWidget->setCurrentWidget(m_ui->ratioConfigPage);
     } else if (m_plotType == PlotType::Stacked) {
         m_ui->configWidget->setCurrentWidget(m_ui->stackedConfigPage);
+    } else if (m_plotType == PlotType::ReuseDistance) {
+        m_ui->configWidget->setCurrentWidget(m_ui->profileConfigPage);
+        m_ui->profileInfo->setText(
+            "Hit rate of a fully associative LRU cache by capacity, for every block size, as given by the reuse "
+            "distances of the profiled accesses to the cache. " +
+            profileScope(profilingStarted));
+    } else if (m_plotType == PlotType::WorkingSet) {
+        m_ui->configWidget->setCurrentWidget(m_ui->profileConfigPage);
+        m_ui->profileInfo->setText(
+            QString("Bytes touched within every window of %1 profiled accesses to the cache, for every block size. ")
+                .arg(m_cache.getReuseProfiler().getWindow()) +
+            profileScope(profilingStarted));
     } else {
         Q_ASSERT(false);
     }
 
+    // The cycle range only applies to the access statistics
+    const bool cycleRange = m_plotType == PlotType::Ratio || m_plotType == PlotType::Stacked;
+    m_ui->rangeMin->setEnabled(cycleRange);
+    m_ui->rangeMax->setEnabled(cycleRange);
+
     variablesChanged();
 }
 
+QString CachePlotWidget::profileScope(bool profilingStarted) const {
+    if (profilingStarted) {
+        return "Profiling has now been enabled; the accesses of the cycles stepped through from here on are "
+               "profiled.";
+    }
+    QString scope = "Only the accesses of cycles stepped through since profiling was enabled are profiled; "
+                    "asynchronous runs are not.";
+    if (m_cache.getReuseReversals() != 0) {
+        scope += QString(" %1 reversed cycles are still included, as the profile cannot be rolled back.")
+                     .arg(m_cache.getReuseReversals());
+    }
+    return scope;
+}
+
 void CachePlotWidget::savePlot() {
     const QString filename = QFileDialog::getSaveFileName(this, "Save file", "", "Images (*.png)");
     if (!filename.isEmpty()) {
@@ -164,7 +204,7 @@ void CachePlotWidget::copyPlotDataToClipboard() const {
     for (int i = 0; i < N_Variables; i++) {
         allVariables.push_back(static_cast<Variable>(i));
     }
-    const auto& allData = gatherData(allVariables);
+    const auto& allData = gatherData(allVariables, m_ui->rangeMin->value(), m_ui->rangeMax->value());
 
     std::map<unsigned /*cycle*/, QStringList> dataStrings;
     QStringList header;
@@ -195,10 +235,6 @@ void CachePlotWidget::copyPlotDataToClipboard() const {
 }
 
 void CachePlotWidget::rangeChanged() {
-    if (m_currentPlot) {
-        m_currentPlot->axes(Qt::Horizontal).first()->setRange(m_ui->rangeMin->value(), m_ui->rangeMax->value());
-    }
-
     // Update allowed ranges
     const auto& accessTrace = m_cache.getAccessTrace();
     const unsigned cycles = ProcessorHandler::get()->getProcessor()->getCycleCount();
@@ -206,6 +242,11 @@ void CachePlotWidget::rangeChanged() {
     m_ui->rangeMin->setMaximum(m_ui->rangeMax->value());
     m_ui->rangeMax->setMinimum(m_ui->rangeMin->value());
     m_ui->rangeMax->setMaximum(cycles);
+
+    // Only the access statistics within the range are gathered, so the plot is recreated
+    if (m_currentPlot && (m_plotType == PlotType::Ratio || m_plotType == PlotType::Stacked)) {
+        variablesChanged();
+    }
 }
 
 std::vector<CachePlotWidget::Variable> CachePlotWidget::gatherVariables() const {
@@ -221,26 +262,52 @@ std::vector<CachePlotWidget::Variable> CachePlotWidget::gatherVariables() const
                 variables.push_back(qvariant_cast<Variable>(item->data(Qt::UserRole)));
             }
         }
-    } else {
-        Q_ASSERT(false);
     }
+    // The reuse distance and working set plots do not plot any variables
     return variables;
 }
 
+void CachePlotWidget::requestMissClassification(const std::vector<Variable>& variables) {
+    if (m_classificationRequested || m_cache.getMissClassification()) {
+        return;
+    }
+    const bool missClasses = std::any_of(variables.begin(), variables.end(), [](Variable variable) {
+        return variable == Variable::CompulsoryMisses || variable == Variable::CapacityMisses ||
+               variable == Variable::ConflictMisses;
+    });
+    if (!missClasses) {
+        return;
+    }
+
+    m_classificationRequested = true;
+    const auto answer = QMessageBox::question(
+        this, "Miss Classification",
+        "Misses are not being classified into compulsory, capacity and conflict misses. Enabling the classification "
+        "resets the processor; the miss classes are then recorded for the accesses which follow. Enable it?");
+    if (answer == QMessageBox::Yes) {
+        m_cache.setMissClassification(true);
+    }
+}
+
 void CachePlotWidget::variablesChanged() {
     const auto vars = gatherVariables();
+    requestMissClassification(vars);
     if (m_plotType == PlotType::Ratio) {
         Q_ASSERT(vars.size() == 2);
         setPlot(createRatioPlot(vars[0], vars[1]));
     } else if (m_plotType == PlotType::Stacked) {
         setPlot(createStackedPlot(vars));
+    } else if (m_plotType == PlotType::ReuseDistance) {
+        setPlot(createReuseDistancePlot());
+    } else if (m_plotType == PlotType::WorkingSet) {
+        setPlot(createWorkingSetPlot());
     } else {
         Q_ASSERT(false);
     }
 }
 
 std::map<CachePlotWidget::Variable, QList<QPoint>>
-CachePlotWidget::gatherData(const std::vector<Variable>& types) const {
+CachePlotWidget::gatherData(const std::vector<Variable>& types, unsigned firstCycle, unsigned lastCycle) const {
     const auto& trace = m_cache.getAccessTrace();
 
     std::map<Variable, QList<QPoint>> data;
@@ -257,32 +324,50 @@ CachePlotWidget::gatherData(const std::vector<Variable>& types) const {
     }
 
     // Gather data
-    for (const auto& entry : trace) {
+    const auto gatherEntry = [&](const AccessTraceSeries::Entry& entry) {
         if (varSet.count(Variable::Writes)) {
-            data[Variable::Writes].append(QPoint(entry.first, entry.second.writes));
+            data[Variable::Writes].append(QPoint(entry.cycle, entry.trace.writes));
         }
         if (varSet.count(Variable::Reads)) {
-            data[Variable::Reads].append(QPoint(entry.first, entry.second.reads));
+            data[Variable::Reads].append(QPoint(entry.cycle, entry.trace.reads));
         }
         if (varSet.count(Variable::Hits)) {
-            data[Variable::Hits].append(QPoint(entry.first, entry.second.hits));
+            data[Variable::Hits].append(QPoint(entry.cycle, entry.trace.hits));
         }
         if (varSet.count(Variable::Misses)) {
-            data[Variable::Misses].append(QPoint(entry.first, entry.second.misses));
+            data[Variable::Misses].append(QPoint(entry.cycle, entry.trace.misses));
         }
         if (varSet.count(Variable::Writebacks)) {
-            data[Variable::Writebacks].append(QPoint(entry.first, entry.second.writebacks));
+            data[Variable::Writebacks].append(QPoint(entry.cycle, entry.trace.writebacks));
         }
         if (varSet.count(Variable::Accesses)) {
-            data[Variable::Accesses].append(QPoint(entry.first, entry.second.hits + entry.second.misses));
+            data[Variable::Accesses].append(QPoint(entry.cycle, entry.trace.hits + entry.trace.misses));
         }
+        if (varSet.count(Variable::CompulsoryMisses)) {
+            data[Variable::CompulsoryMisses].append(QPoint(entry.cycle, entry.trace.compulsoryMisses));
+        }
+        if (varSet.count(Variable::CapacityMisses)) {
+            data[Variable::CapacityMisses].append(QPoint(entry.cycle, entry.trace.capacityMisses));
+        }
+        if (varSet.count(Variable::ConflictMisses)) {
+            data[Variable::ConflictMisses].append(QPoint(entry.cycle, entry.trace.conflictMisses));
+        }
+    };
+
+    // The statistics are cumulative; the range starts off with those of the last access preceding it
+    const size_t first = trace.lowerBound(firstCycle);
+    if (first > 0 && (first == trace.size() || trace.at(first).cycle != firstCycle)) {
+        gatherEntry({firstCycle, trace.at(first - 1).trace});
     }
+    trace.forEachInRange(firstCycle, lastCycle, gatherEntry);
 
     return data;
 }
 
 QChart* CachePlotWidget::createRatioPlot(const Variable num, const Variable den) const {
-    const auto data = gatherData({num, den});
+    const unsigned minX = m_ui->rangeMin->value();
+    const unsigned maxX = m_ui->rangeMax->value();
+    const auto data = gatherData({num, den}, minX, maxX);
 
     const QList<QPoint>& numerator = data.at(num);
     const QList<QPoint>& denominator = data.at(den);
@@ -311,7 +396,6 @@ QChart* CachePlotWidget::createRatioPlot(const Variable num, const Variable den)
         series->append(p1.x(), ratio);
         maxY = ratio > maxY ? ratio : maxY;
     }
-    const unsigned maxX = ProcessorHandler::get()->getProcessor()->getCycleCount();
 
     stepifySeries(*series);
     finishSeries(*series, maxX);
@@ -319,7 +403,7 @@ QChart* CachePlotWidget::createRatioPlot(const Variable num, const Variable den)
     chart->addSeries(series);
 
     chart->createDefaultAxes();
-    chart->axes(Qt::Horizontal).first()->setRange(0, maxX);
+    chart->axes(Qt::Horizontal).first()->setRange(minX, maxX);
     chart->axes(Qt::Vertical).first()->setRange(0, maxY * 1.1);
 
     chart->legend()->hide();
@@ -344,7 +428,9 @@ QChart* CachePlotWidget::createStackedPlot(const std::vector<Variable>& variable
         return nullptr;
     }
 
-    const auto data = gatherData(variables);
+    const unsigned minX = m_ui->rangeMin->value();
+    const unsigned maxX = m_ui->rangeMax->value();
+    const auto data = gatherData(variables, minX, maxX);
     const unsigned len = data.at(*variables.begin()).size();
     for (const auto& iter : data) {
         Q_ASSERT(len == iter.second.size());
@@ -363,7 +449,6 @@ QChart* CachePlotWidget::createStackedPlot(const std::vector<Variable>& variable
     std::vector<std::pair<Variable, QLineSeries*>> lineSeries;
     QLineSeries* lowerSeries = nullptr;
     QLineSeries* upperSeries = nullptr;
-    const unsigned maxX = ProcessorHandler::get()->getProcessor()->getCycleCount();
     unsigned maxY = 0;
     for (const auto& variableData : data) {
         upperSeries = new QLineSeries(chart);
@@ -409,7 +494,7 @@ QChart* CachePlotWidget::createStackedPlot(const std::vector<Variable>& variable
     // Add space to label to add space between labels and axis
     QValueAxis* axisY = qobject_cast<QValueAxis*>(chart->axes(Qt::Vertical).first());
     QValueAxis* axisX = qobject_cast<QValueAxis*>(chart->axes(Qt::Horizontal).first());
-    axisX->setRange(0, maxX);
+    axisX->setRange(minX, maxX);
     axisY->setRange(0, axisY->max());
 
     Q_ASSERT(axisY);
@@ -420,6 +505,87 @@ QChart* CachePlotWidget::createStackedPlot(const std::vector<Variable>& variable
     return chart;
 }
 
+QChart* CachePlotWidget::createReuseDistancePlot() const {
+    const ReuseProfiler& profiler = m_cache.getReuseProfiler();
+
+    QChart* chart = new QChart();
+    chart->setTitle("Hit rate by capacity");
+    QFont font;
+    font.setPointSize(16);
+    chart->setTitleFont(font);
+
+    unsigned maxX = 0;
+    for (unsigned blockBits = 0; blockBits <= profiler.getMaxBlockBits(); blockBits++) {
+        QLineSeries* series = new QLineSeries(chart);
+        series->setName(QString("%1 word(s) per block").arg(1 << blockBits));
+        for (unsigned capacityBits = 0; capacityBits <= profiler.getMaxDistanceBits(); capacityBits++) {
+            const uint64_t hits = profiler.hits(blockBits, capacityBits);
+            const double hitRate = profiler.accesses() == 0 ? 0 : static_cast<double>(hits) / profiler.accesses();
+            // Capacity in bytes, as log2
+            const unsigned x = capacityBits + blockBits + 2;
+            series->append(x, hitRate * 100);
+            maxX = x > maxX ? x : maxX;
+        }
+        chart->addSeries(series);
+    }
+
+    chart->createDefaultAxes();
+    QValueAxis* axisY = qobject_cast<QValueAxis*>(chart->axes(Qt::Vertical).first());
+    QValueAxis* axisX = qobject_cast<QValueAxis*>(chart->axes(Qt::Horizontal).first());
+    Q_ASSERT(axisX && axisY);
+    axisX->setRange(2, maxX);
+    axisY->setRange(0, 100);
+
+    axisY->setLabelFormat("%.1f  ");
+    axisY->setTitleText("%");
+
+    axisX->setLabelFormat("%d  ");
+    axisX->setTitleText("Capacity (log2 bytes)");
+
+    return chart;
+}
+
+QChart* CachePlotWidget::createWorkingSetPlot() const {
+    const ReuseProfiler& profiler = m_cache.getReuseProfiler();
+
+    QChart* chart = new QChart();
+    chart->setTitle(QString("Working set per %1 accesses").arg(profiler.getWindow()));
+    QFont font;
+    font.setPointSize(16);
+    chart->setTitleFont(font);
+
+    unsigned maxY = 0;
+    for (unsigned blockBits = 0; blockBits <= profiler.getMaxBlockBits(); blockBits++) {
+        QLineSeries* series = new QLineSeries(chart);
+        series->setName(QString("%1 word(s) per block").arg(1 << blockBits));
+        const auto& workingSets = profiler.workingSets(blockBits);
+        QVector<QPointF> points;
+        points.reserve(workingSets.size());
+        for (size_t i = 0; i < workingSets.size(); i++) {
+            const unsigned bytes = workingSets[i] * (4u << blockBits);
+            points << QPointF(static_cast<double>(i + 1) * profiler.getWindow(), bytes);
+            maxY = bytes > maxY ? bytes : maxY;
+        }
+        series->replace(points);
+        chart->addSeries(series);
+    }
+
+    chart->createDefaultAxes();
+    QValueAxis* axisY = qobject_cast<QValueAxis*>(chart->axes(Qt::Vertical).first());
+    QValueAxis* axisX = qobject_cast<QValueAxis*>(chart->axes(Qt::Horizontal).first());
+    Q_ASSERT(axisX && axisY);
+    axisX->setRange(0, profiler.accesses());
+    axisY->setRange(0, maxY * 1.1);
+
+    axisY->setLabelFormat("%d  ");
+    axisY->setTitleText("Bytes");
+
+    axisX->setLabelFormat("%d  ");
+    axisX->setTitleText("Accesses");
+
+    return chart;
+}
+
 void CachePlotWidget::setPlot(QChart* plot) {
     if (plot == nullptr)
         return;
@@ -4,6 +4,8 @@
 #include <QMetaType>
 #include <QtCharts/QChartGlobal>
 
+#include <limits>
+
 #include "cachesim.h"
 
 QT_FORWARD_DECLARE_CLASS(QToolBar);
@@ -26,9 +28,20 @@ class CachePlotWidget : public QDialog {
     Q_OBJECT
 
 public:
-    enum Variable { Writes = 0, Reads, Hits, Misses, Writebacks, Accesses, N_Variables };
-    enum class PlotType { Ratio, Stacked };
-    explicit CachePlotWidget(const CacheSim& sim, QWidget* parent = nullptr);
+    enum Variable {
+        Writes = 0,
+        Reads,
+        Hits,
+        Misses,
+        Writebacks,
+        Accesses,
+        CompulsoryMisses,
+        CapacityMisses,
+        ConflictMisses,
+        N_Variables
+    };
+    enum class PlotType { Ratio, Stacked, ReuseDistance, WorkingSet };
+    explicit CachePlotWidget(CacheSim& sim, QWidget* parent = nullptr);
     ~CachePlotWidget();
 
 public slots:
@@ -42,23 +55,50 @@ private:
     /**
      * @brief gatherData
      * @returns a list of QPoints containing plotable data gathered from the cache simulator, as per the specified
+     * variables, for the accesses within the cycle range [firstCycle, lastCycle]. The statistics as of firstCycle are
+     * included as its first point.
      */
-    std::map<Variable, QList<QPoint>> gatherData(const std::vector<Variable>& variables) const;
+    std::map<Variable, QList<QPoint>> gatherData(const std::vector<Variable>& variables, unsigned firstCycle = 0,
+                                                 unsigned lastCycle = std::numeric_limits<unsigned>::max()) const;
     void setupToolbar();
     void setupStackedVariablesList();
     void setPlot(QChart* plot);
     void copyPlotDataToClipboard() const;
     void savePlot();
     std::vector<CachePlotWidget::Variable> gatherVariables() const;
+    /**
+     * @brief requestMissClassification
+     * Offers to enable the miss classification of the cache if any of @p variables is a 3C miss class. Enabling it
+     * resets the processor, so the user is only asked once per plot window.
+     */
+    void requestMissClassification(const std::vector<Variable>& variables);
+    /**
+     * @brief profileScope
+     * Describes which accesses the reuse profile of the cache covers. @p profilingStarted indicates that the profiler
+     * has just been enabled by selecting the plot.
+     */
+    QString profileScope(bool profilingStarted) const;
 
     QChart* createRatioPlot(const Variable num, const Variable den) const;
     QChart* createStackedPlot(const std::vector<Variable>& variables) const;
+    /**
+     * @brief createReuseDistancePlot
+     * Plots the hit rate of a fully associative LRU cache against its capacity, per block size, as given by the reuse
+     * distances of the accesses (see ReuseProfiler).
+     */
+    QChart* createReuseDistancePlot() const;
+    /**
+     * @brief createWorkingSetPlot
+     * Plots the working set of every window of accesses, in bytes, per block size.
+     */
+    QChart* createWorkingSetPlot() const;
 
     PlotType m_plotType = PlotType::Ratio;
     QChart* m_currentPlot = nullptr;
 
     Ui::CachePlotWidget* m_ui;
-    const CacheSim& m_cache;
+    CacheSim& m_cache;
+    bool m_classificationRequested = false;
 
     QToolBar* m_toolbar = nullptr;
     QAction* m_copyDataAction = nullptr;
@@ -72,11 +112,16 @@ const static std::map<CachePlotWidget::Variable, QString> s_cacheVariableStrings
     {CachePlotWidget::Variable::Hits, "Hits"},
     {CachePlotWidget::Variable::Misses, "Misses"},
     {CachePlotWidget::Variable::Writebacks, "Writebacks"},
-    {CachePlotWidget::Variable::Accesses, "Total accesses"}};
+    {CachePlotWidget::Variable::Accesses, "Total accesses"},
+    {CachePlotWidget::Variable::CompulsoryMisses, "Compulsory misses"},
+    {CachePlotWidget::Variable::CapacityMisses, "Capacity misses"},
+    {CachePlotWidget::Variable::ConflictMisses, "Conflict misses"}};
 
 const static std::map<CachePlotWidget::PlotType, QString> s_cachePlotTypeStrings{
     {CachePlotWidget::PlotType::Ratio, "Ratio"},
-    {CachePlotWidget::PlotType::Stacked, "Stacked"}};
+    {CachePlotWidget::PlotType::Stacked, "Stacked"},
+    {CachePlotWidget::PlotType::ReuseDistance, "Reuse distance"},
+    {CachePlotWidget::PlotType::WorkingSet, "Working set"}};
 
 }  // namespace Ripes
 
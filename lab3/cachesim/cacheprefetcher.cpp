@@ -0,0 +1,139 @@
+#include "cacheprefetcher.h"
+
+#include <algorithm>
+
+namespace Ripes {
+
+void Prefetcher::request(int64_t line, std::vector<uint32_t>& prefetches) const {
+    const int64_t address = line * m_lineBytes;
+    if (line >= 0 && address <= UINT32_MAX) {
+        prefetches.push_back(static_cast<uint32_t>(address));
+    }
+}
+
+void NextLinePrefetcher::observe(const DemandAccess& access, std::vector<uint32_t>& prefetches) {
+    if (access.isHit && !access.isPrefetchHit) {
+        return;
+    }
+    const int64_t line = lineOf(access.address);
+    for (unsigned i = 1; i <= m_degree; i++) {
+        request(line + i, prefetches);
+    }
+}
+
+void StridePrefetcher::reset() {
+    std::fill(m_table.begin(), m_table.end(), Entry());
+}
+
+void StridePrefetcher::observe(const DemandAccess& access, std::vector<uint32_t>& prefetches) {
+    if (access.pc == s_noPc || m_table.empty()) {
+        return;
+    }
+    Entry& entry = m_table[(access.pc >> 2) % m_table.size()];
+    if (entry.pc != access.pc) {
+        entry = Entry();
+        entry.pc = access.pc;
+        entry.lastAddress = access.address;
+        return;
+    }
+
+    const int64_t stride = static_cast<int64_t>(access.address) - entry.lastAddress;
+    if (stride == entry.stride) {
+        entry.confidence += entry.confidence < s_maxConfidence ? 1 : 0;
+    } else if (entry.confidence > 0) {
+        entry.confidence--;
+    } else {
+        entry.stride = stride;
+    }
+    entry.lastAddress = access.address;
+
+    if (entry.confidence < s_prefetchConfidence || entry.stride == 0) {
+        return;
+    }
+    // Strides smaller than a line map several strided addresses to the same line; each line is requested once
+    int64_t lastLine = lineOf(access.address);
+    for (unsigned i = 1; i <= m_degree; i++) {
+        const int64_t target = access.address + entry.stride * i;
+        if (target < 0 || target > UINT32_MAX) {
+            break;
+        }
+        const int64_t line = lineOf(static_cast<uint32_t>(target));
+        if (line != lastLine) {
+            request(line, prefetches);
+            lastLine = line;
+        }
+    }
+}
+
+void StreamPrefetcher::reset() {
+    std::fill(m_streams.begin(), m_streams.end(), Stream());
+    m_misses.assign(s_missHistory, -1);
+    m_missHead = 0;
+    m_clock = 0;
+}
+
+void StreamPrefetcher::advance(Stream& stream, std::vector<uint32_t>& prefetches) const {
+    while ((stream.tail - stream.head) * stream.direction < static_cast<int64_t>(m_depth)) {
+        request(stream.tail, prefetches);
+        stream.tail += stream.direction;
+    }
+}
+
+void StreamPrefetcher::observe(const DemandAccess& access, std::vector<uint32_t>& prefetches) {
+    const int64_t line = lineOf(access.address);
+    m_clock++;
+
+    // An access within the prefetched window of a stream moves the stream ahead
+    for (auto& stream : m_streams) {
+        if (stream.valid && (line - stream.head) * stream.direction >= 0 &&
+            (line - stream.tail) * stream.direction < 0) {
+            stream.head = line + stream.direction;
+            stream.lastUse = m_clock;
+            advance(stream, prefetches);
+            return;
+        }
+    }
+    if (access.isHit || m_streams.empty()) {
+        return;
+    }
+
+    // Allocate a stream if an adjacent line missed recently
+    int direction = 0;
+    for (const int64_t missed : m_misses) {
+        if (missed == line - 1) {
+            direction = 1;
+        } else if (missed == line + 1) {
+            direction = -1;
+        }
+    }
+    m_misses[m_missHead] = line;
+    m_missHead = (m_missHead + 1) % s_missHistory;
+    if (direction == 0) {
+        return;
+    }
+
+    auto victim = std::min_element(m_streams.begin(), m_streams.end(), [](const Stream& a, const Stream& b) {
+        return a.valid == b.valid ? a.lastUse < b.lastUse : !a.valid;
+    });
+    victim->valid = true;
+    victim->direction = direction;
+    victim->head = line + direction;
+    victim->tail = victim->head;
+    victim->lastUse = m_clock;
+    advance(*victim, prefetches);
+}
+
+std::unique_ptr<Prefetcher> makePrefetcher(PrefetcherType type) {
+    switch (type) {
+        case PrefetcherType::NextLine:
+            return std::make_unique<NextLinePrefetcher>();
+        case PrefetcherType::Stride:
+            return std::make_unique<StridePrefetcher>();
+        case PrefetcherType::Stream:
+            return std::make_unique<StreamPrefetcher>();
+        default:
+            return nullptr;
+    }
+}
+
+}  // namespace Ripes
@@ -0,0 +1,153 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace Ripes {
+
+/**
+ * @brief The Prefetcher class
+ * A hardware prefetcher attached to a cache (see CacheEngine::setPrefetcher()). The prefetcher observes every demand
+ * access performed on the cache, and may respond by requesting lines to be prefetched into it. Requests for lines which
+ * are already cached are dropped by the cache.
+ */
+class Prefetcher {
+public:
+    static constexpr uint32_t s_noPc = UINT32_MAX;
+
+    /**
+     * @brief The DemandAccess struct
+     * A demand access, as observed by the prefetcher after it has been performed.
+     */
+    struct DemandAccess {
+        uint32_t address = 0;
+        uint32_t pc = s_noPc;       // Address of the instruction performing the access, or s_noPc if unknown
+        bool isWrite = false;
+        bool isHit = false;
+        bool isPrefetchHit = false;  // The first demand hit on a line brought in by a prefetch
+    };
+
+    virtual ~Prefetcher() {}
+
+    /**
+     * @brief configure
+     * Called by the cache upon every reset, with its line size in bytes. Clears all learned state.
+     */
+    void configure(unsigned lineBytes) {
+        m_lineBytes = lineBytes;
+        reset();
+    }
+
+    /**
+     * @brief observe
+     * Trains the prefetcher on @p access, and appends the addresses of the lines to prefetch in response to
+     * @p prefetches, in order of priority.
+     */
+    virtual void observe(const DemandAccess& access, std::vector<uint32_t>& prefetches) = 0;
+
+protected:
+    virtual void reset() = 0;
+
+    int64_t lineOf(uint32_t address) const { return address / m_lineBytes; }
+    /**
+     * @brief request
+     * Appends the address of @p line to @p prefetches, unless the line lies outside of the address space.
+     */
+    void request(int64_t line, std::vector<uint32_t>& prefetches) const;
+
+    unsigned m_lineBytes = 4;
+};
+
+/**
+ * @brief The NextLinePrefetcher class
+ * Tagged next-line prefetching: upon a miss, or the first demand hit on a prefetched line, the @p degree lines
+ * following the accessed line are prefetched.
+ */
+class NextLinePrefetcher : public Prefetcher {
+public:
+    explicit NextLinePrefetcher(unsigned degree = 1) : m_degree(degree) {}
+    void observe(const DemandAccess& access, std::vector<uint32_t>& prefetches) override;
+
+protected:
+    void reset() override {}
+
+private:
+    unsigned m_degree;
+};
+
+/**
+ * @brief The StridePrefetcher class
+ * PC-indexed stride prefetching, after the reference prediction table of Chen and Baer. A direct-mapped table indexed
+ * by the PC of the accessing instruction holds the last address and stride of each instruction, and a saturating
+ * confidence counter which is incremented when the stride repeats and decremented otherwise. The stride of an entry is
+ * only replaced once its confidence has dropped to zero. Once confident, the lines of the next @p degree strided
+ * addresses are prefetched. Accesses of an unknown PC are ignored.
+ */
+class StridePrefetcher : public Prefetcher {
+public:
+    explicit StridePrefetcher(unsigned entries = 64, unsigned degree = 2) : m_table(entries), m_degree(degree) {}
+    void observe(const DemandAccess& access, std::vector<uint32_t>& prefetches) override;
+
+protected:
+    void reset() override;
+
+private:
+    static constexpr uint8_t s_maxConfidence = 3;
+    static constexpr uint8_t s_prefetchConfidence = 2;
+
+    struct Entry {
+        uint32_t pc = s_noPc;
+        uint32_t lastAddress = 0;
+        int64_t stride = 0;
+        uint8_t confidence = 0;
+    };
+
+    std::vector<Entry> m_table;
+    unsigned m_degree;
+};
+
+/**
+ * @brief The StreamPrefetcher class
+ * Stream buffers, after Jouppi and Palacharla and Kessler, prefetching into the cache itself. A stream is allocated
+ * upon a miss to a line adjacent to a recently missed line, in the direction of the two misses, and is thereafter kept
+ * @p depth lines ahead of the most recent demand access within its prefetched window. @p streams streams are tracked,
+ * and the least recently used one is replaced upon allocation.
+ */
+class StreamPrefetcher : public Prefetcher {
+public:
+    explicit StreamPrefetcher(unsigned streams = 4, unsigned depth = 4) : m_streams(streams), m_depth(depth) {}
+    void observe(const DemandAccess& access, std::vector<uint32_t>& prefetches) override;
+
+protected:
+    void reset() override;
+
+private:
+    static constexpr unsigned s_missHistory = 16;
+
+    struct Stream {
+        bool valid = false;
+        int direction = 1;
+        int64_t head = 0;  // Next line expected to be demanded
+        int64_t tail = 0;  // Next line to prefetch; lines [head, tail) have been prefetched
+        uint64_t lastUse = 0;
+    };
+
+    void advance(Stream& stream, std::vector<uint32_t>& prefetches) const;
+
+    std::vector<Stream> m_streams;
+    unsigned m_depth;
+    std::vector<int64_t> m_misses;  // Ring buffer of recently missed lines
+    unsigned m_missHead = 0;
+    uint64_t m_clock = 0;
+};
+
+enum class PrefetcherType { None, NextLine, Stride, Stream };
+
+/**
+ * @brief makePrefetcher
+ * @returns a prefetcher of @p type with its default parameters, or nullptr for PrefetcherType::None.
+ */
+std::unique_ptr<Prefetcher> makePrefetcher(PrefetcherType type);
+
+}  // namespace Ripes
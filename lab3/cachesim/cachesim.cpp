@@ -1,14 +1,10 @@
 #include "cachesim.h"
-#include "binutils.h"
-#include "cache_policy_object.h"
 
 #include "processorhandler.h"
+#include "processors/RISC-V/rv5s_hz/rv5s_hz.h"
 
 #include <QApplication>
 #include <QThread>
-#include <random>
-#include <utility>
-#include <bitset>
 
 
 namespace Ripes {
@@ -17,6 +13,7 @@ CacheSim::CacheSim(QObject* parent) : QObject(parent) {
     connect(ProcessorHandler::get(), &ProcessorHandler::reqProcessorReset, this, &CacheSim::processorReset);
 
     connect(ProcessorHandler::get(), &ProcessorHandler::runFinished, this, [=] {
+        finishRun();
         // Given that we are not updating the graphical state of the cache simulator whilst the processor is running,
         // once running is finished, the entirety of the cache view should be reloaded in the graphical view.
         emit hitrateChanged();
@@ -26,402 +23,176 @@ CacheSim::CacheSim(QObject* parent) : QObject(parent) {
     updateConfiguration();
 }
 
-void CacheSim::updateCacheSetReplFields(CacheSet& cacheSet, unsigned int setIdx, unsigned wayIdx, bool isHit) {
-    this->m_replPolicyObject->updateCacheSetReplFields(cacheSet, setIdx, wayIdx, isHit);
-}
-
-void CacheSim::revertCacheSetReplFields(CacheSet& cacheSet, const CacheWay& oldWay, unsigned wayIdx) {
-    this->m_replPolicyObject->revertCacheSetReplFields(cacheSet, oldWay, wayIdx);
-}
-
 void CacheSim::setReplacementPolicy(ReplPolicy policy) {
-    if (this->m_replPolicyObject != nullptr) {
-        delete this->m_replPolicyObject;
-        this->m_replPolicyObject = nullptr;
-    }
-    m_replPolicy = policy;
-    this->setReplacementPolicyObject();
+    m_engine.setReplacementPolicy(policy);
     processorReset();
 }
 
-void CacheSim::setReplacementPolicyObject() {
-    if (this->m_replPolicyObject != nullptr) {
-        delete this->m_replPolicyObject;
-        this->m_replPolicyObject = nullptr;
-    }
-    switch (this->m_replPolicy) {
-    case ReplPolicy::Random: this->m_replPolicyObject = new RandomPolicy(getWays(), getSets(), getBlocks()); break;
-    case ReplPolicy::LRU: this->m_replPolicyObject = new LruPolicy(getWays(), getSets(), getBlocks()); break;
-    case ReplPolicy::LRU_LIP: this->m_replPolicyObject = new LruLipPolicy(getWays(), getSets(), getBlocks()); break;
-    case ReplPolicy::PLRU: this-> m_replPolicyObject = new PlruPolicy(getWays(), getSets(), getBlocks()); break;
-    case ReplPolicy::DIP: this-> m_replPolicyObject = new DipPolicy(getWays(), getSets(), getBlocks()); break;
-    case ReplPolicy::NoCache: break;
-    // TODO: add codes for the cache policy defined by you.
-    default: std::cerr << "unknown policy type" << std::endl; break;
-    }
-}
-
-std::pair<unsigned, CacheWay*> CacheSim::locateEvictionWay(const CacheTransaction& transaction) {
-    auto& cacheSet = m_cacheSets[transaction.index.set];
-
-    std::pair<unsigned, CacheWay*> ew;
-    ew.first = s_invalidIndex;
-    ew.second = nullptr;
-
-    this->m_replPolicyObject->locateEvictionWay(ew, cacheSet, transaction.index.set);
-
-    Q_ASSERT(ew.first != s_invalidIndex && "Unable to locate way for eviction");
-    Q_ASSERT(ew.second != nullptr && "Unable to locate way for eviction");
-    return ew;
-}
-
-CacheWay CacheSim::evictAndUpdate(CacheTransaction& transaction) {
-    const unsigned wayIdx = transaction.index.way;
-    auto& cacheSet = m_cacheSets[transaction.index.set];
-    CacheWay* wayPtr = &cacheSet[wayIdx];
-
-    CacheWay eviction;
-
-    if (!wayPtr->valid) {
-        // Record that this was an invalid->valid transition
-        transaction.transToValid = true;
-    } else {
-        // Store the old way info in our eviction trace, in case of rollbacks
-        eviction = *wayPtr;
-        if (eviction.dirty) {
-            // The eviction will result in a writeback
-            transaction.isWriteback = true;
-        }
-    }
-    // Invalidate the target way
-    *wayPtr = CacheWay();
-    // Set required values in way, reflecting the newly loaded address
-    wayPtr->valid = true;
-    wayPtr->dirty = false;
-    wayPtr->tag = getTag(transaction.address);
-    transaction.tagChanged = true;
-
-    return eviction;
-}
-
-void CacheSim::analyzeCacheAccess(CacheTransaction& transaction) {
-    transaction.index.set = getSetIdx(transaction.address);
-    transaction.index.block = getBlockIdx(transaction.address);
-    transaction.isHit = false;
-
-    if (m_cacheSets.count(transaction.index.set) != 0) {
-        for (const auto& way : m_cacheSets.at(transaction.index.set)) {
-            if ((way.second.tag == getTag(transaction.address)) && way.second.valid) {
-                transaction.index.way = way.first;
-                transaction.isHit = true;
-                break;
-            }
-        }
-    }
-    if (!transaction.isHit) {
-        const auto [wayIdx, wayPtr] = locateEvictionWay(transaction);
-        transaction.index.way = wayIdx;
-    }
+void CacheSim::setSkewedAssocPolicy(SkewedAssocPolicy policy) {
+    m_engine.setSkewedAssocPolicy(policy);
+    processorReset();
 }
 
-unsigned CacheSim::H(unsigned y) {
-    unsigned LSB = y & 0b1; // LSB: least significant bit y1
-    unsigned MSB = y & (1 << (m_sets-1)); //MSB: the n-th bit yn, n = m_sets
-    return (y >> 1) ^ ( MSB ^ (LSB << (m_sets-1)));
+void CacheSim::setSkewHash(SkewHashType type) {
+    m_engine.setSkewHash(type);
+    processorReset();
 }
 
-unsigned CacheSim::RH(unsigned y) {
-    unsigned LSB = y & 0b1;
-    unsigned MSB = y & (1 << (m_sets-1));
-    y &= ~(1 << (m_sets-1));
-    return (y << 1) ^ ((MSB >> (m_sets-1)) ^ LSB);
+void CacheSim::setPrefetcher(PrefetcherType type) {
+    m_prefetcherType = type;
+    m_engine.setPrefetcher(makePrefetcher(type));
+    processorReset();
 }
 
-unsigned CacheSim::f(unsigned way_idx, uint32_t address) {
-    int hash_idx = way_idx & 0b11; // use hash_idx to choose 4 hash functions: f0, f1, f2, f3
-    // extract A1
-    unsigned A1 = getSetIdx(address);
-    // extract A2
-    unsigned A2 = getTag(address);
-    A2 &= ((1 << m_sets) - 1); // A2 is the last m_sets bits of tag
-    // calculate the set index
-    unsigned set_idx;
-    switch(hash_idx) {
-        case 0: { // f0
-            set_idx = (H(A1) ^ RH(A2)) ^ A2;
-            break;
-        }
-        case 1: { // f1
-            set_idx = (H(A1) ^ RH(A2)) ^ A1;
-            break;
-        }
-        case 2: { // f2
-            set_idx = (RH(A1) ^ H(A2)) ^ A2;
-            break;
-        }
-        case 3: { // f3
-            set_idx = (RH(A1) ^ H(A2)) ^ A1;
-            break;
-        }
+void CacheSim::access(uint32_t address, AccessType type) {
+    if (m_reuseProfiling && !isAsynchronouslyAccessed()) {
+        m_reuseProfiler.access(address);
     }
-    return set_idx;
-}
-
 
-void CacheSim::analyzeCacheAccessSkewedCache(CacheTransaction& transaction) {
-    if (this->m_type == CacheType::InstrCache) {
-        return analyzeCacheAccess(transaction);
-    }
-    // ---------------------Part 3. TODO ------------------------------
-    // Implement the skewed-associative cache
-    // If 1 set
-    if (m_sets == 0) {
-        return analyzeCacheAccess(transaction);
-    }
-    // If more than one sets
-    transaction.index.block = getBlockIdx(transaction.address);
-    transaction.isHit = false;
-    unsigned max_counter = 0;
-    int num_ways = getWays();
-    for(unsigned way_idx=0; way_idx<(unsigned)num_ways; way_idx++) {
-        unsigned set_idx = f(way_idx, transaction.address);
-        // Lazily ensure that the located set and way has been initialized
-        CacheSet& set = m_cacheSets[set_idx];
-        for(int i=0; i<num_ways; i++) { // since all ways of this set should be updated in method `updateCacheSetReplFields()`, so we must lazily initialize all ways here
-            set[i];
-        }
-        CacheWay& way = set[way_idx];
-        if (way.valid && (way.tag == getTag(transaction.address))) { // if hit
-            transaction.index.set = set_idx;
-            transaction.index.way = way_idx;
-            transaction.isHit = true;
-            break;
-        } else { // if miss 
-            if (way.counter >= max_counter) {
-                transaction.index.set = set_idx;
-                transaction.index.way = way_idx;
-                max_counter = way.counter;
-            }
-        }
+    if (getReplacementPolicy() == ReplPolicy::NoCache) {
+        // The engine only determines the memory latency of the access
+        emitAccessSignals(m_engine.access(address, type));
+        return;
     }
-    return;
-}
 
-void CacheSim::access(uint32_t address, AccessType type) {
-    address = address & ~0b11;  // Disregard unaligned accesses
-    CacheTrace trace;
-    CacheWay oldWay;
-    CacheTransaction transaction;
-    transaction.address = address;
-    transaction.type = type;
-
-    if (this->m_replPolicy == ReplPolicy::NoCache) {
-        sigCacheIsHit.Emit(false);
+    if (isAsynchronouslyAccessed()) {
+        runAccess(address, type);
         return;
     }
 
-    if (this->m_skewPolicy == SkewedAssocPolicy::Skewed) {
-        analyzeCacheAccessSkewedCache(transaction); // this should analyze the set and way
-    } else {
-        analyzeCacheAccess(transaction);
+    if (m_undoLog.capacity() != vsrtl::core::ClockedComponent::reverseStackSize()) {
+        // The undo depth is a global VSRTL setting which may have changed since the log was allocated
+        m_undoLog.reset(vsrtl::core::ClockedComponent::reverseStackSize(), getStorage().maskWords(),
+                        m_engine.getUndoSetWays());
     }
-
-    if (type == AccessType::Write && this->m_wrPolicy == WritePolicy::WriteThrough) {
-        sigCacheIsHit.Emit(false);
-    } else {
-        sigCacheIsHit.Emit(transaction.isHit);
+    const CacheTransaction transaction =
+        m_engine.access(address, type, m_undoLog.capacity() > 0 ? &m_undoLog : nullptr, accessingPc(address));
+    emitAccessSignals(transaction);
+    for (const auto& fill : m_engine.getPrefetchTransactions()) {
+        emit wayInvalidated(fill.index.set, fill.index.way);
     }
 
-    if (!transaction.isHit) {
-        if (type == AccessType::Read ||
-            (type == AccessType::Write && getWriteAllocPolicy() == WriteAllocPolicy::WriteAllocate)) {
-            oldWay = evictAndUpdate(transaction);
-        }
-    } else {
-        oldWay = m_cacheSets[transaction.index.set][transaction.index.way];
-    }
+    // At this point, no further changes shall be made to the transaction. The engine has recorded the transaction, as
+    // well as the changes required to roll it back, in the undo log.
+    pushAccessTrace();
 
-    // === Update dirty and metadata bits ===
-    // Initially, we need a check for the case of "write + miss + noWriteAlloc". In this case, we should not update
-    // replacement/dirty fields. In all other cases, this is a valid action.
     const bool writeMissNoAlloc =
         !transaction.isHit && type == AccessType::Write && getWriteAllocPolicy() == WriteAllocPolicy::NoWriteAllocate;
-
-    if (!writeMissNoAlloc) {
-        // Lazily ensure that the located way has been initialized
-        m_cacheSets[transaction.index.set][transaction.index.way];
-        if (type == AccessType::Write && getWritePolicy() == WritePolicy::WriteBack) {
-            CacheWay& way = m_cacheSets[transaction.index.set][transaction.index.way];
-            way.dirty = true;
-            way.dirtyBlocks.insert(transaction.index.block);
-        }
-        updateCacheSetReplFields(m_cacheSets[transaction.index.set], transaction.index.set, transaction.index.way, transaction.isHit);
-    } else {
-        // In case of a write miss with no write allocate, the value is always written through to memory (a writeback)
-        transaction.isWriteback = true;
-    }
-
-    // If our WritePolicy is WriteThrough and this access is a write, the transaction will always result in a WriteBack
-    if (type == AccessType::Write && getWritePolicy() == WritePolicy::WriteThrough) {
-        transaction.isWriteback = true;
-    }
-
-    // ===========================
-
-    // At this point, no further changes shall be made to the transaction.
-    // We record the transaction as well as a possible eviction
-    trace.oldWay = oldWay;
-    trace.transaction = transaction;
-    pushTrace(trace);
-    pushAccessTrace(transaction);
-
-    // === Some sanity checking ===
-    // It should never be possible that a read returns an invalid way index
-    if (type == AccessType::Read) {
-        transaction.index.assertValid();
-    }
-
-    // It should never be possible that a write returns an invalid way index if we write-allocate
-    if (type == AccessType::Write && getWriteAllocPolicy() == WriteAllocPolicy::WriteAllocate) {
-        transaction.index.assertValid();
-    }
-
-    // ===========================
     if (writeMissNoAlloc) {
         // There are no graphical changes to perform since nothing is pulled into the cache upon a missed write without
         // write allocation
         return;
     }
 
-    if (isAsynchronouslyAccessed()) {
-        return;
-    }
     emit dataChanged(&transaction);
 }
 
-unsigned CacheSim::getSetIdx(const uint32_t address) const {
-    uint32_t maskedAddress = address & m_setMask;
-    maskedAddress >>= 2 + getBlockBits();
-    return maskedAddress;
-}
-
-CacheSim::CacheSize CacheSim::getCacheSize() const {
-    CacheSize size;
-
-    const int entries = getSets() * getWays();
-
-    // Valid bits
-    unsigned componentBits = entries;  // 1 bit per entry
-    size.components.push_back("Valid bits: " + QString::number(componentBits));
-    size.bits += componentBits;
-
-    if (m_wrPolicy == WritePolicy::WriteBack) {
-        // Dirty bits
-        unsigned componentBits = entries;  // 1 bit per entry
-        size.components.push_back("Dirty bits: " + QString::number(componentBits));
-        size.bits += componentBits;
+void CacheSim::runAccess(uint32_t address, AccessType type) {
+    if (!m_isRunning) {
+        // Accesses performed during the run are not recorded in the undo log. Any record preceding the run can
+        // therefore no longer be replayed in order, and is discarded.
+        m_isRunning = true;
+        m_undoLog.clear();
+        m_accessesSinceSample = 0;
     }
 
-    if (m_replPolicy == ReplPolicy::LRU || m_replPolicy == ReplPolicy::LRU_LIP || m_replPolicy == ReplPolicy::DIP) {
-        // counter bits
-        componentBits = getWaysBits() * entries;
-        size.components.push_back("Counter bits: " + QString::number(componentBits));
-        size.bits += componentBits;
+    emitAccessSignals(m_engine.access(address, type, nullptr, accessingPc(address)));
+
+    if (m_runSampleInterval != 0 && ++m_accessesSinceSample >= m_runSampleInterval) {
+        pushRunSample();
     }
+}
 
-    // Tag bits
-    if (this->m_skewPolicy == SkewedAssocPolicy::NonSkewed) {
-        componentBits = bitcount(m_tagMask) * entries;
-        size.components.push_back("Tag bits: " + QString::number(componentBits));
-        size.bits += componentBits;
+void CacheSim::emitAccessSignals(const CacheTransaction& transaction) {
+    if (getReplacementPolicy() == ReplPolicy::NoCache ||
+        (transaction.type == AccessType::Write && getWritePolicy() == WritePolicy::WriteThrough)) {
+        sigCacheIsHit.Emit(false);
     } else {
-        componentBits = 32 * entries;
-        size.components.push_back("Tag bits: " + QString::number(componentBits));
-        size.bits += componentBits;
+        sigCacheIsHit.Emit(transaction.isHit);
     }
+    // The access itself occupies the current cycle
+    sigCacheStall.Emit(transaction.latency > 0 ? transaction.latency - 1 : 0);
+}
 
-    // Data bits
-    componentBits = 32 * entries * getBlocks();
-    size.components.push_back("Data bits: " + QString::number(componentBits));
-    size.bits += componentBits;
-
-    // We do not take PSEL (DIP) or the PLRU tree (PLRU) bits into consideration
+void CacheSim::pushRunSample() {
+    const unsigned currentCycle = ProcessorHandler::get()->getProcessor()->getCycleCount();
+    m_accessTrace.push(currentCycle, CacheAccessTrace(m_engine.getStatistics()));
+    m_accessesSinceSample = 0;
+}
 
-    return size;
+void CacheSim::finishRun() {
+    if (!m_isRunning) {
+        return;
+    }
+    m_isRunning = false;
+    if (m_accessesSinceSample != 0) {
+        pushRunSample();
+    }
 }
 
 void CacheSim::setType(CacheSim::CacheType type) {
-    m_type = type;
+    m_engine.setType(type);
     reassociateMemory();
 }
 
 void CacheSim::reassociateMemory() {
-    if (m_type == CacheType::DataCache) {
+    if (getCacheType() == CacheType::DataCache) {
         m_memory.rw = ProcessorHandler::get()->getDataMemory();
-    } else if (m_type == CacheType::InstrCache) {
+    } else if (getCacheType() == CacheType::InstrCache) {
         m_memory.rom = ProcessorHandler::get()->getInstrMemory();
     } else {
         Q_ASSERT(false);
     }
     Q_ASSERT(m_memory.rw != nullptr);
+
+    if (m_stallCounter) {
+        sigCacheStall.Disconnect(m_stallCounter, &vsrtl::core::HZ_CacheStall::stall);
+        m_stallCounter = nullptr;
+    }
+    if (auto* proc = dynamic_cast<vsrtl::core::RV5S_HZ*>(ProcessorHandler::get()->getProcessorNonConst())) {
+        m_stallCounter = getCacheType() == CacheType::DataCache ? proc->dcache_stall : proc->icache_stall;
+        sigCacheStall.Connect(m_stallCounter, &vsrtl::core::HZ_CacheStall::stall);
+    }
 }
 
 unsigned CacheSim::getHits() const {
-    if (m_accessTrace.size() == 0) {
-        return 0;
-    } else {
-        auto& trace = m_accessTrace.rbegin()->second;
-        return trace.hits;
-    }
+    return m_engine.getStatistics().hits;
 }
 
 unsigned CacheSim::getMisses() const {
-    if (m_accessTrace.size() == 0) {
-        return 0;
-    } else {
-        auto& trace = m_accessTrace.rbegin()->second;
-        return trace.misses;
-    }
+    return m_engine.getStatistics().misses;
 }
 
 unsigned CacheSim::getWritebacks() const {
-    if (m_accessTrace.size() == 0) {
-        return 0;
-    } else {
-        auto& trace = m_accessTrace.rbegin()->second;
-        return trace.writebacks;
-    }
+    return m_engine.getStatistics().writebacks;
 }
 
 double CacheSim::getHitRate() const {
-    if (m_accessTrace.size() == 0) {
-        return 0;
-    } else {
-        auto& trace = m_accessTrace.rbegin()->second;
-        return static_cast<double>(trace.hits) / (trace.hits + trace.misses);
-    }
+    return m_engine.getStatistics().hitRate();
 }
 
+double CacheSim::getAMAT() const {
+    return m_engine.getStatistics().amat();
+}
 
-void CacheSim::pushAccessTrace(const CacheTransaction& transaction) {
-    // Access traces are pushed in sorted order into the access trace map; indexed by a key corresponding to the cycle
-    // of the acces.
-    const unsigned currentCycle = ProcessorHandler::get()->getProcessor()->getCycleCount();
-
-    const CacheAccessTrace& mostRecentTrace =
-        m_accessTrace.size() == 0 ? CacheAccessTrace() : m_accessTrace.rbegin()->second;
+unsigned CacheSim::getStallCycles() const {
+    return m_engine.getStatistics().stallCycles();
+}
 
-    m_accessTrace[currentCycle] = CacheAccessTrace(mostRecentTrace, transaction);
 
-    if (!isAsynchronouslyAccessed()) {
-        emit hitrateChanged();
-    }
+void CacheSim::pushAccessTrace() {
+    // Access traces are pushed in sorted order into the access trace series; indexed by a key corresponding to the
+    // cycle of the acces. The engine statistics are sampled rather than accumulating the transaction, as the
+    // writebacks of an access also include the drained write buffer entries and the prefetch fills.
+    const unsigned currentCycle = ProcessorHandler::get()->getProcessor()->getCycleCount();
+    m_accessTrace.push(currentCycle, CacheAccessTrace(m_engine.getStatistics()));
+    emit hitrateChanged();
 }
 
 void CacheSim::popAccessTrace() {
     Q_ASSERT(m_accessTrace.size() > 0);
     // The access trace should have an entry
-    m_accessTrace.erase(m_accessTrace.rbegin()->first);
+    m_accessTrace.pop();
     emit hitrateChanged();
 }
 
@@ -430,95 +201,44 @@ bool CacheSim::isAsynchronouslyAccessed() const {
 }
 
 void CacheSim::undo() {
-    if (m_traceStack.size() == 0)
-        return;
-
-    const auto trace = popTrace();
     popAccessTrace();
-
-    const auto& oldWay = trace.oldWay;
-    const auto& transaction = trace.transaction;
-    const unsigned& setIdx = trace.transaction.index.set;
-    const unsigned& blockIdx = trace.transaction.index.block;
-    const unsigned& wayIdx = trace.transaction.index.way;
-    auto& set = m_cacheSets.at(setIdx);
-    auto& way = set.at(wayIdx);
-
-    // Case 1: A cache way was transitioned to valid. In this case, we simply invalidate the cache way
-    if (trace.transaction.transToValid) {
-        // Invalidate the way
-        Q_ASSERT(m_cacheSets.at(setIdx).count(wayIdx) != 0);
-        way = CacheWay();
+    if (m_reuseProfiling) {
+        m_reuseReversals++;
     }
-    // Case 2: A miss occured on a valid entry. In this case, we have to restore the old way, which was evicted
-    // - Restore the old entry which was evicted
-    else if (!trace.transaction.isHit) {
-        way = oldWay;
-    }
-    // Case 3: Else, it was a cache hit; Revert replacement fields and dirty blocks
-    way.dirtyBlocks = oldWay.dirtyBlocks;
-    revertCacheSetReplFields(set, oldWay, wayIdx);
-
-    // Notify that changes to the way has been performed
-    emit wayInvalidated(setIdx, wayIdx);
-
-    // Finally, re-emit the transaction which occurred in the previous cache access to update the cache
-    // highlighting state
-    if (m_traceStack.size() > 0) {
-        emit dataChanged(&m_traceStack.begin()->transaction);
-    } else {
+    if (m_undoLog.empty()) {
+        // The access was performed during an asynchronous run, or its records have been discarded from the log. The
+        // cache contents and statistics can no longer be reverted, which is reported until the next reset.
+        m_unrevertedCycles++;
+        emit hitrateChanged();
         emit dataChanged(nullptr);
+        return;
     }
-}
-
-CacheSim::CacheTrace CacheSim::popTrace() {
-    Q_ASSERT(m_traceStack.size() > 0);
-    auto val = m_traceStack.front();
-    m_traceStack.pop_front();
-    return val;
-}
-
-void CacheSim::pushTrace(const CacheTrace& eviction) {
-    m_traceStack.push_front(eviction);
-    if (m_traceStack.size() > vsrtl::core::ClockedComponent::reverseStackSize()) {
-        m_traceStack.pop_back();
-    }
-}
 
-uint32_t CacheSim::buildAddress(unsigned tag, unsigned setIdx, unsigned blockIdx) const {
-    if (this->m_skewPolicy == SkewedAssocPolicy::NonSkewed) {
-        uint32_t address = 0;
-        address |= tag << (2 /*byte offset*/ + getBlockBits() + getSetBits());
-        address |= setIdx << (2 /*byte offset*/ + getBlockBits());
-        address |= blockIdx << (2 /*byte offset*/);
-        return address;
-    } else {
-        return tag;
+    // The prefetch fills performed in response to an access are recorded after it, and are undone along with it
+    std::vector<CacheIndex> indices;
+    for (unsigned i = 0; i < m_undoLog.size(); i++) {
+        const auto& record = m_undoLog.fromBack(i);
+        indices.push_back(record.transaction.index);
+        indices.insert(indices.end(), record.relocationPath, record.relocationPath + record.transaction.relocations);
+        if (record.accessStart) {
+            break;
+        }
     }
-}
+    m_engine.undo(m_undoLog);
 
-unsigned CacheSim::getTag(const uint32_t address) const {
-    if (this->m_skewPolicy == SkewedAssocPolicy::NonSkewed) {
-        uint32_t maskedAddress = address & m_tagMask;
-        maskedAddress >>= 2 + getBlockBits() + getSetBits();
-        return maskedAddress;
-    } else {
-        return address;
+    // Notify that changes to the ways have been performed
+    for (const auto& index : indices) {
+        emit wayInvalidated(index.set, index.way);
     }
-}
-
-unsigned CacheSim::getBlockIdx(const uint32_t address) const {
-    uint32_t maskedAddress = address & m_blockMask;
-    maskedAddress >>= 2;
-    return maskedAddress;
-}
 
-const CacheSet* CacheSim::getSet(unsigned idx) const {
-    if (m_cacheSets.count(idx)) {
-        return &m_cacheSets.at(idx);
-    } else {
-        return nullptr;
+    // Finally, re-emit the demand transaction of the previous cache access to update the cache highlighting state
+    const CacheTransaction* previous = nullptr;
+    for (unsigned i = 0; i < m_undoLog.size() && !previous; i++) {
+        if (m_undoLog.fromBack(i).accessStart) {
+            previous = &m_undoLog.fromBack(i).transaction;
+        }
     }
+    emit dataChanged(previous);
 }
 
 void CacheSim::processorWasClocked() {
@@ -533,7 +253,7 @@ void CacheSim::processorWasReversed() {
         return;
     }
     const unsigned cycleToUndo = ProcessorHandler::get()->getProcessor()->getCycleCount() + 1;
-    if (m_accessTrace.rbegin()->first != cycleToUndo) {
+    if (m_accessTrace.back().cycle != cycleToUndo) {
         // No cache access in this cycle
         return;
     }
@@ -543,20 +263,15 @@ void CacheSim::processorWasReversed() {
 
 void CacheSim::updateConfiguration() {
     // Cache configuration changed. Reset all state
-    m_cacheSets.clear();
+    m_engine.reset();
     m_accessTrace.clear();
-    m_traceStack.clear();
-
-    // Recalculate masks
-    int bitoffset = 2;  // 2^2 = 4-byte offset (32-bit words in cache)
-
-    m_blockMask = generateBitmask(getBlockBits()) << bitoffset;
-    bitoffset += getBlockBits();
-
-    m_setMask = generateBitmask(getSetBits()) << bitoffset;
-    bitoffset += getSetBits();
-
-    m_tagMask = generateBitmask(32 - bitoffset) << bitoffset;
+    m_reuseProfiler.reset();
+    m_reuseReversals = 0;
+    m_unrevertedCycles = 0;
+    m_isRunning = false;
+    m_accessesSinceSample = 0;
+    m_undoLog.reset(vsrtl::core::ClockedComponent::reverseStackSize(), getStorage().maskWords(),
+                    m_engine.getUndoSetWays());
 
     // Reset the graphical view & processor
     emit configurationChanged();
@@ -588,40 +303,76 @@ void CacheSim::processorReset() {
 }
 
 void CacheSim::setBlocks(unsigned blocks) {
-    m_blocks = blocks;
-    setReplacementPolicyObject();
+    m_engine.setBlocks(blocks);
     processorReset();
 }
 void CacheSim::setSets(unsigned sets) {
-    m_sets = sets;
-    setReplacementPolicyObject();
+    m_engine.setSets(sets);
     processorReset();
 }
 void CacheSim::setWays(unsigned ways) {
-    m_ways = ways;
-    setReplacementPolicyObject();
+    m_engine.setWays(ways);
     processorReset();
 }
 
 void CacheSim::setWritePolicy(WritePolicy policy) {
-    m_wrPolicy = policy;
+    m_engine.setWritePolicy(policy);
     processorReset();
 }
 
 void CacheSim::setWriteAllocatePolicy(WriteAllocPolicy policy) {
-    m_wrAllocPolicy = policy;
+    m_engine.setWriteAllocatePolicy(policy);
     processorReset();
 }
 
 void CacheSim::setPreset(const CachePreset& preset) {
-    m_blocks = preset.blocks;
-    m_ways = preset.ways;
-    m_sets = preset.sets;
-    m_wrPolicy = preset.wrPolicy;
-    m_wrAllocPolicy = preset.wrAllocPolicy;
-    m_replPolicy = preset.replPolicy;
+    m_engine.setPreset(preset);
+    processorReset();
+}
+
+void CacheSim::setLatency(const CacheLatency& latency) {
+    m_engine.setLatency(latency);
+    processorReset();
+}
+
+void CacheSim::setVictimBuffer(unsigned entries) {
+    m_engine.setVictimBuffer(entries);
+    processorReset();
+}
+
+void CacheSim::setWriteBuffer(const WriteBufferConfig& config) {
+    m_engine.setWriteBuffer(config);
+    processorReset();
+}
+
+void CacheSim::setSectoring(const SectorConfig& config) {
+    m_engine.setSectoring(config);
+    processorReset();
+}
 
+void CacheSim::setRelocation(unsigned levels) {
+    m_engine.setRelocation(levels);
     processorReset();
 }
 
+void CacheSim::setSetProfiling(bool enabled) {
+    m_engine.setSetProfiling(enabled);
+    processorReset();
+}
+
+void CacheSim::setMissClassification(bool enabled) {
+    m_engine.setMissClassification(enabled);
+    processorReset();
+}
+
+void CacheSim::setReuseProfiling(bool enabled) {
+    if (m_reuseProfiling == enabled) {
+        return;
+    }
+    // The profiler does not affect the cache, so the processor is left as is; the profile starts over from here
+    m_reuseProfiling = enabled;
+    m_reuseProfiler.reset();
+    m_reuseReversals = 0;
+}
+
 }  // namespace Ripes
@@ -1,6 +1,5 @@
 #pragma once
 
-#include <math.h>
 #include <map>
 #include <vector>
 
@@ -9,89 +8,52 @@
 #include "Signals/Signal.h"
 #include "../external/VSRTL/core/vsrtl_register.h"
 #include "processors/RISC-V/rv_memory.h"
-#include "cache_organize_component.h"
-#include "cache_policy_object.h"
+#include "accesstrace.h"
+#include "cacheengine.h"
+#include "cacheundolog.h"
+#include "stackdistance.h"
 
 using RWMemory = vsrtl::core::RVMemory<32, 32>;
 using ROMMemory = vsrtl::core::ROM<32, 32>;
 
+namespace vsrtl {
+namespace core {
+class HZ_CacheStall;
+}
+}  // namespace vsrtl
+
 namespace Ripes {
 
 class CacheSim : public QObject {
     Q_OBJECT
 public:
-    static constexpr unsigned s_invalidIndex = static_cast<unsigned>(-1);
-
-    enum class WriteAllocPolicy { WriteAllocate, NoWriteAllocate };
-    enum class SkewedAssocPolicy {Skewed, NonSkewed};
-    enum class WritePolicy { WriteThrough, WriteBack };
-    enum class ReplPolicy { Random, LRU, LRU_LIP, NoCache, PLRU, DIP };
-    enum class AccessType { Read, Write };
-    enum class CacheType { DataCache, InstrCache };
-
-    struct CacheSize {
-        unsigned bits = 0;
-        std::vector<QString> components;
-    };
-
-    struct CachePreset {
-        int blocks;
-        int sets;
-        int ways;
-
-        WritePolicy wrPolicy;
-        WriteAllocPolicy wrAllocPolicy;
-        ReplPolicy replPolicy;
-        SkewedAssocPolicy skewPolicy;
-    };
-
-    struct CacheIndex {
-        unsigned set = s_invalidIndex;
-        unsigned way = s_invalidIndex;
-        unsigned block = s_invalidIndex;
-        void assertValid() const {
-            Q_ASSERT(set != s_invalidIndex && "Cache set index is invalid");
-            Q_ASSERT(way != s_invalidIndex && "Cache way index is invalid");
-            Q_ASSERT(block != s_invalidIndex && "Cache block index is invalid");
-        }
-    };
-
-    struct CacheTransaction {
-        uint32_t address;
-        CacheIndex index;
-
-        bool isHit = false;
-        bool isWriteback = false;  // True if the transaction resulted in an eviction of a dirty cache set
-        AccessType type;
-        bool transToValid = false;  // True if the cache set just transitioned from invalid to valid
-        bool tagChanged = false;    // True if transToValid or the previous entry was evicted
-    };
-
-    struct CacheAccessTrace {
-        int hits = 0;
-        int misses = 0;
-        int reads = 0;
-        int writes = 0;
-        int writebacks = 0;
-        CacheAccessTrace() {}
-        CacheAccessTrace(const CacheTransaction& transaction) : CacheAccessTrace(CacheAccessTrace(), transaction) {}
-        CacheAccessTrace(const CacheAccessTrace& pre, const CacheTransaction& transaction) {
-            reads = pre.reads + (transaction.type == AccessType::Read ? 1 : 0);
-            writes = pre.writes + (transaction.type == AccessType::Write ? 1 : 0);
-            writebacks = pre.writebacks + (transaction.isWriteback ? 1 : 0);
-            hits = pre.hits + (transaction.isHit ? 1 : 0);
-            misses = pre.misses + (transaction.isHit ? 0 : 1);
-        }
-    };
+    static constexpr unsigned s_invalidIndex = CacheEngine::s_invalidIndex;
+
+    using WriteAllocPolicy = CacheEngine::WriteAllocPolicy;
+    using SkewedAssocPolicy = CacheEngine::SkewedAssocPolicy;
+    using WritePolicy = CacheEngine::WritePolicy;
+    using ReplPolicy = CacheEngine::ReplPolicy;
+    using AccessType = CacheEngine::AccessType;
+    using CacheType = CacheEngine::CacheType;
+
+    using CacheSize = CacheEngine::CacheSize;
+    using CachePreset = CacheEngine::CachePreset;
+    using CacheIndex = CacheEngine::CacheIndex;
+    using CacheTransaction = CacheEngine::CacheTransaction;
+    using CacheLatency = CacheEngine::CacheLatency;
+    using WriteBufferConfig = CacheEngine::WriteBufferConfig;
+    using SectorConfig = CacheEngine::SectorConfig;
+
+    using CacheAccessTrace = Ripes::CacheAccessTrace;
 
     CacheSim(QObject* parent);
     void setType(CacheType type);
     void setWritePolicy(WritePolicy policy);
     void setWriteAllocatePolicy(WriteAllocPolicy policy);
     void setReplacementPolicy(ReplPolicy policy);
-    void setSkewedAssocPolicy(SkewedAssocPolicy policy) {
-        m_skewPolicy = policy;
-    }
+    void setSkewedAssocPolicy(SkewedAssocPolicy policy);
+    void setSkewHash(SkewHashType type);
+    void setPrefetcher(PrefetcherType type);
 
     void recvSigAccess(uint32_t address, bool isWrite) {
         if (isWrite) access(address, AccessType::Write);
@@ -99,52 +61,117 @@ public:
     }
     void access(uint32_t address, AccessType type);
     void undo();
-    void processorReset();
 
-    WriteAllocPolicy getWriteAllocPolicy() const { return m_wrAllocPolicy; }
-    ReplPolicy getReplacementPolicy() const { return m_replPolicy; }
-    WritePolicy getWritePolicy() const { return m_wrPolicy; }
-    SkewedAssocPolicy getSkewedPolicy() const {
-        return m_skewPolicy;
-    }
+    /**
+     * @brief setRunSampleInterval
+     * While the processor is running asynchronously, the cache only maintains its aggregate counters, and records an
+     * access trace entry for every @p accesses accesses. 0 disables sampling; only the state at the end of the run is
+     * then recorded.
+     */
+    void setRunSampleInterval(unsigned accesses) { m_runSampleInterval = accesses; }
+    void processorReset();
 
-    const std::map<unsigned, CacheAccessTrace>& getAccessTrace() const { return m_accessTrace; }
+    WriteAllocPolicy getWriteAllocPolicy() const { return m_engine.getWriteAllocPolicy(); }
+    ReplPolicy getReplacementPolicy() const { return m_engine.getReplacementPolicy(); }
+    WritePolicy getWritePolicy() const { return m_engine.getWritePolicy(); }
+    SkewedAssocPolicy getSkewedPolicy() const { return m_engine.getSkewedPolicy(); }
+    SkewHashType getSkewHash() const { return m_engine.getSkewHash(); }
+    const CacheLatency& getLatency() const { return m_engine.getLatency(); }
+    PrefetcherType getPrefetcherType() const { return m_prefetcherType; }
+    unsigned getVictimBufferEntries() const { return m_engine.getVictimBufferEntries(); }
+    const WriteBufferConfig& getWriteBufferConfig() const { return m_engine.getWriteBufferConfig(); }
+    const SectorConfig& getSectoring() const { return m_engine.getSectoring(); }
+    unsigned getRelocationLevels() const { return m_engine.getRelocationLevels(); }
+    bool getSetProfiling() const { return m_engine.getSetProfiling(); }
+    bool getMissClassification() const { return m_engine.getMissClassification(); }
+
+    const AccessTraceSeries& getAccessTrace() const { return m_accessTrace; }
+    const ReuseProfiler& getReuseProfiler() const { return m_reuseProfiler; }
+    bool getReuseProfiling() const { return m_reuseProfiling; }
+    /**
+     * @brief getReuseReversals
+     * The number of cycles reversed whilst the reuse profiler was enabled. The profiler cannot be rolled back, so the
+     * accesses of these cycles remain in the profile.
+     */
+    unsigned getReuseReversals() const { return m_reuseReversals; }
 
     double getHitRate() const;
     unsigned getHits() const;
     unsigned getMisses() const;
     unsigned getWritebacks() const;
-    CacheSize getCacheSize() const;
-    CacheType getCacheType() const { return this->m_type; }
-
-    uint32_t buildAddress(unsigned tag, unsigned lineIdx, unsigned blockIdx) const;
+    double getAMAT() const;
+    unsigned getStallCycles() const;
+    /**
+     * @brief getUnrevertedCycles
+     * The number of cycles reversed since the last reset whose cache access was not in the undo log, ie. accesses of
+     * an asynchronous run or beyond the undo depth. The cache contents and statistics still include these accesses.
+     */
+    unsigned getUnrevertedCycles() const { return m_unrevertedCycles; }
+    CacheSize getCacheSize() const { return m_engine.getCacheSize(); }
+    CacheType getCacheType() const { return m_engine.getCacheType(); }
 
-    int getBlockBits() const { return m_blocks; }
-    int getWaysBits() const { return m_ways; }
-    int getSetBits() const { return m_sets; }
-    int getTagBits() const { return 32 - 2 /*byte offset*/ - getBlockBits() - getSetBits(); }
+    uint32_t buildAddress(unsigned tag, unsigned setIdx, unsigned wayIdx, unsigned blockIdx) const {
+        return m_engine.buildAddress(tag, setIdx, wayIdx, blockIdx);
+    }
 
-    int getBlocks() const { return static_cast<int>(std::pow(2, m_blocks)); }
-    int getWays() const { return static_cast<int>(std::pow(2, m_ways)); }
-    int getSets() const { return static_cast<int>(std::pow(2, m_sets)); }
-    unsigned getBlockMask() const { return m_blockMask; }
-    unsigned getTagMask() const { return m_tagMask; }
-    unsigned getSetMask() const { return m_setMask; }
+    int getBlockBits() const { return m_engine.getBlockBits(); }
+    int getWaysBits() const { return m_engine.getWaysBits(); }
+    int getSetBits() const { return m_engine.getSetBits(); }
+    int getTagBits() const { return m_engine.getTagBits(); }
 
-    unsigned getSetIdx(const uint32_t address) const;
+    int getBlocks() const { return m_engine.getBlocks(); }
+    int getWays() const { return m_engine.getWays(); }
+    int getSets() const { return m_engine.getSets(); }
+    unsigned getBlockMask() const { return m_engine.getBlockMask(); }
+    unsigned getTagMask() const { return m_engine.getTagMask(); }
+    unsigned getSetMask() const { return m_engine.getSetMask(); }
 
-    unsigned getBlockIdx(const uint32_t address) const;
-    unsigned getTag(const uint32_t address) const;
+    unsigned getSetIdx(const uint32_t address) const { return m_engine.getSetIdx(address); }
+    unsigned getBlockIdx(const uint32_t address) const { return m_engine.getBlockIdx(address); }
+    unsigned getTag(const uint32_t address) const { return m_engine.getTag(address); }
 
-    const CacheSet* getSet(unsigned idx) const;
+    const CacheStorage& getStorage() const { return m_engine.getStorage(); }
+    const CacheEngine& getEngine() const { return m_engine; }
 
     Gallant::Signal1<bool> sigCacheIsHit;
 
+    /**
+     * @brief sigCacheStall
+     * Emitted for every access with the number of cycles, beyond the current one, which the access takes to complete
+     * as per the configured CacheLatency. On the 5-stage processor with hazard detection, the signal drives the stall
+     * counter of the pipeline stage accessing the cache (MEM for the data cache, IF for the instruction cache), which
+     * holds the stage for this many cycles; see reassociateMemory().
+     */
+    Gallant::Signal1<unsigned> sigCacheStall;
+
 public slots:
     void setBlocks(unsigned blocks);
     void setSets(unsigned sets);
     void setWays(unsigned ways);
     void setPreset(const CachePreset& preset);
+    void setLatency(const CacheLatency& latency);
+    void setVictimBuffer(unsigned entries);
+    void setWriteBuffer(const WriteBufferConfig& config);
+    void setSectoring(const SectorConfig& config);
+    void setRelocation(unsigned levels);
+    /**
+     * @brief setSetProfiling
+     * Enables the per-set counters behind the miss heatmap of the cache view. Off by default, as the counters are
+     * updated (and recorded for undo) on every access.
+     */
+    void setSetProfiling(bool enabled);
+    /**
+     * @brief setMissClassification
+     * Enables the 3C classification of misses plotted by the access statistics plot. Off by default, as it maintains
+     * a fully associative shadow cache on every access.
+     */
+    void setMissClassification(bool enabled);
+    /**
+     * @brief setReuseProfiling
+     * Enables the reuse distance and working set profiler behind the corresponding plots, starting an empty profile.
+     * Off by default. Only the accesses of cycles which are stepped through are profiled; asynchronous runs are not.
+     */
+    void setReuseProfiling(bool enabled);
 
     /**
      * @brief processorWasClocked/processorWasReversed
@@ -173,19 +200,28 @@ signals:
     void cacheInvalidated();
 
 private:
-    struct CacheTrace {
-        CacheTransaction transaction;
-        CacheWay oldWay;
-    };
-
-    std::pair<unsigned, CacheWay*> locateEvictionWay(const CacheTransaction& transaction);
-    CacheWay evictAndUpdate(CacheTransaction& transaction);
-    void analyzeCacheAccess(CacheTransaction& transaction);
-    void analyzeCacheAccessSkewedCache(CacheTransaction& transaction);
     void updateConfiguration();
-    void pushAccessTrace(const CacheTransaction& transaction);
+    void pushAccessTrace();
     void popAccessTrace();
-    void setReplacementPolicyObject();
+    void emitAccessSignals(const CacheTransaction& transaction);
+
+    /**
+     * @brief accessingPc
+     * The address of the instruction performing an access to @p address, as observed by the prefetcher. Only known for
+     * instruction fetches; the memory signals of the data cache do not carry the pc.
+     */
+    uint32_t accessingPc(uint32_t address) const {
+        return getCacheType() == CacheType::InstrCache ? address : Prefetcher::s_noPc;
+    }
+
+    /**
+     * @brief runAccess
+     * Access path used while the processor is running asynchronously. No undo records, per-access trace entries or
+     * GUI signals are produced; the view is rebuilt from the cache state once the run finishes (see finishRun()).
+     */
+    void runAccess(uint32_t address, AccessType type);
+    void pushRunSample();
+    void finishRun();
 
     /**
      * @brief isAsynchronouslyAccessed
@@ -198,52 +234,23 @@ private:
 
     /**
      * @brief reassociateMemory
-     * Binds to a memory component exposed by the processor handler, based on the current cache type.
+     * Binds to a memory component exposed by the processor handler, based on the current cache type, and connects
+     * sigCacheStall to the stall counter of the stage accessing that memory, if the processor has one.
      */
     void reassociateMemory();
 
-    ReplPolicy m_replPolicy = ReplPolicy::LRU;
-    CachePolicyBase* m_replPolicyObject = new LruPolicy(4, 8, 1);
-
-
-    WritePolicy m_wrPolicy = WritePolicy::WriteBack;
-    WriteAllocPolicy m_wrAllocPolicy = WriteAllocPolicy::WriteAllocate;
-    SkewedAssocPolicy m_skewPolicy = SkewedAssocPolicy::NonSkewed;
-
-    /**
-     * @brief H
-     * H maps (yn, ... , y1) to (yn XOR y1, yn, ... y2)
-     * n = m_sets
-     */
-    unsigned H(unsigned y);
-
     /**
-     * @brief RH
-     * The reverser of H, mapping (yn, ... , y1) to (yn-1, ... y1, yn XOR y1)
-     * n = m_sets
+     * @brief m_engine
+     * The Qt-independent cache model. CacheSim only binds the engine to the processor and the graphical view; all cache
+     * state lives within the engine.
      */
-    unsigned RH(unsigned y);
-
-    /**
-     * @brief f
-     * Calculate the target set index of `address` at way `i`
-     */
-    unsigned f(unsigned way_idx, uint32_t address);
-
-    unsigned m_blockMask = -1;
-    unsigned m_setMask = -1;
-    unsigned m_tagMask = -1;
-
-    int m_blocks = 0;  // Some power of 2
-    int m_sets = 3;   // Some power of 2
-    int m_ways = 2;    // Some power of 2
+    CacheEngine m_engine;
 
     /**
      * @brief m_memory
      * The cache simulator may be attached to either a ROM or a Read/Write memory element. Accessing the underlying
      * VSRTL component signals are dependent on the given type of the memory.
      */
-    CacheType m_type;
     union {
         RWMemory const* rw = nullptr;
         ROMMemory const* rom;
@@ -251,33 +258,36 @@ private:
     } m_memory;
 
     /**
-     * @brief m_cacheSets
-     * The datastructure for storing our cache hierachy, as per the current cache configuration.
+     * @brief m_stallCounter
+     * The stall counter which sigCacheStall is connected to. Only used to disconnect it again; the processor owning it
+     * may already have been destroyed.
      */
-    std::map<unsigned, CacheSet> m_cacheSets;
+    vsrtl::core::HZ_CacheStall* m_stallCounter = nullptr;
 
-    void updateCacheSetReplFields(CacheSet& cacheSet, unsigned int setIdx, unsigned wayIdx, bool isHit);
     /**
-     * @brief revertCacheSetReplFields
-     * Called whenever undoing a transaction to the cache. Reverts a cache set's replacement fields according to the
-     * configured replacement policy.
+     * @brief m_accessTrace
+     * The access trace stack contains cache access statistics for each simulation cycle. Contrary to the TraceStack
+     * (m_undoLog), it is not bounded by the undo depth and grows with every cycle containing a cache access, hence it
+     * is stored in a compact, chunked columnar form.
      */
-    void revertCacheSetReplFields(CacheSet& cacheSet, const CacheWay& oldWay, unsigned wayIdx);
+    AccessTraceSeries m_accessTrace;
 
     /**
-     * @brief m_accessTrace
-     * The access trace stack contains cache access statistics for each simulation cycle. Contrary to the TraceStack
-     * (m_traceStack).
+     * @brief m_reuseProfiler
+     * Reuse distances and working sets of the accesses reaching the cache, for block sizes of up to 16 words and
+     * windows of 256 accesses, regardless of the cache configuration. Only fed if m_reuseProfiling.
      */
-    std::map<unsigned, CacheAccessTrace> m_accessTrace;
+    ReuseProfiler m_reuseProfiler{4, 256};
+    bool m_reuseProfiling = false;
+    unsigned m_reuseReversals = 0;
 
     /**
-     * @brief m_traceStack
-     * The following information is used to track all most-recent modifications made to the stack. The stack is of a
-     * fixed sized which is equal to the undo stack of VSRTL memory elements. Storing all modifications allows us to
+     * @brief m_undoLog
+     * The following information is used to track all most-recent modifications made to the cache. The log is of a
+     * fixed size which is equal to the undo stack of VSRTL memory elements. Storing all modifications allows us to
      * rollback any changes performed to the cache, when clock cycles are undone.
      */
-    std::deque<CacheTrace> m_traceStack;
+    CacheUndoLog m_undoLog;
 
     /**
      * @brief m_isResetting
@@ -288,8 +298,15 @@ private:
      */
     bool m_isResetting = false;
 
-    CacheTrace popTrace();
-    void pushTrace(const CacheTrace& trace);
+    /**
+     * @brief m_isRunning
+     * Set upon the first asynchronous access of a run, and cleared once the run finishes.
+     */
+    bool m_isRunning = false;
+    PrefetcherType m_prefetcherType = PrefetcherType::None;
+    unsigned m_runSampleInterval = 1024;
+    unsigned m_accessesSinceSample = 0;
+    unsigned m_unrevertedCycles = 0;
 };
 
 const static std::map<CacheSim::ReplPolicy, QString> s_cacheReplPolicyStrings{{CacheSim::ReplPolicy::Random, "Random"},
@@ -297,7 +314,10 @@ const static std::map<CacheSim::ReplPolicy, QString> s_cacheReplPolicyStrings{{C
                                                                               {CacheSim::ReplPolicy::LRU_LIP, "LRU_LIP"},
                                                                               {CacheSim::ReplPolicy::NoCache, "NoCache"},
                                                                               {CacheSim::ReplPolicy::DIP, "DIP"},
-                                                                              {CacheSim::ReplPolicy::PLRU, "PLRU"}};
+                                                                              {CacheSim::ReplPolicy::PLRU, "PLRU"},
+                                                                              {CacheSim::ReplPolicy::SRRIP, "SRRIP"},
+                                                                              {CacheSim::ReplPolicy::BRRIP, "BRRIP"},
+                                                                              {CacheSim::ReplPolicy::DRRIP, "DRRIP"}};
 const static std::map<CacheSim::WriteAllocPolicy, QString> s_cacheWriteAllocateStrings{
     {CacheSim::WriteAllocPolicy::WriteAllocate, "Write allocate"},
     {CacheSim::WriteAllocPolicy::NoWriteAllocate, "No write allocate"}};
@@ -306,8 +326,17 @@ const static std::map<CacheSim::WritePolicy, QString> s_cacheWritePolicyStrings{
     {CacheSim::WritePolicy::WriteThrough, "Write-through"},
     {CacheSim::WritePolicy::WriteBack, "Write-back"}};
 
+const static std::map<PrefetcherType, QString> s_prefetcherStrings{{PrefetcherType::None, "None"},
+                                                                   {PrefetcherType::NextLine, "Next-line"},
+                                                                   {PrefetcherType::Stride, "Stride"},
+                                                                   {PrefetcherType::Stream, "Stream"}};
+
 const static std::map<CacheSim::SkewedAssocPolicy, QString> s_cacheSkewedAssocStrings {
     {CacheSim::SkewedAssocPolicy::Skewed,"Skewed-associative"},
     {CacheSim::SkewedAssocPolicy::NonSkewed, "Non-skewed-associative"}};
 
+const static std::map<SkewHashType, QString> s_skewHashStrings{{SkewHashType::Seznec, "Seznec"},
+                                                               {SkewHashType::H3, "H3"},
+                                                               {SkewHashType::XorFold, "XOR-fold"}};
+
 }  // namespace Ripes
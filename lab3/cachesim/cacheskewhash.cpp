@@ -0,0 +1,123 @@
+#include "cacheskewhash.h"
+
+#include <algorithm>
+#include <random>
+#include <utility>
+
+namespace Ripes {
+
+namespace {
+
+// Seed of the H3 matrices; fixed, such that every configuration of a given geometry hashes alike
+constexpr unsigned s_h3Seed = 0x5eed;
+
+/**
+ * H maps (yn, ... , y1) to (yn XOR y1, yn, ... y2)
+ */
+unsigned H(unsigned y, unsigned n) {
+    unsigned LSB = y & 0b1;              // LSB: least significant bit y1
+    unsigned MSB = y & (1 << (n - 1));  // MSB: the n-th bit yn
+    return (y >> 1) ^ (MSB ^ (LSB << (n - 1)));
+}
+
+/**
+ * RH is the reverser of H, mapping (yn, ... , y1) to (yn-1, ... y1, yn XOR y1)
+ */
+unsigned RH(unsigned y, unsigned n) {
+    unsigned LSB = y & 0b1;
+    unsigned MSB = y & (1 << (n - 1));
+    y &= ~(1 << (n - 1));
+    return (y << 1) ^ ((MSB >> (n - 1)) ^ LSB);
+}
+
+unsigned rotate(unsigned value, unsigned amount, unsigned bits) {
+    amount %= bits;
+    if (amount == 0) {
+        return value;
+    }
+    const unsigned mask = bits >= 32 ? static_cast<unsigned>(-1) : (1u << bits) - 1;
+    return ((value << amount) | (value >> (bits - amount))) & mask;
+}
+
+}  // namespace
+
+unsigned SkewHash::contribution(SkewHashType type, unsigned setBits, unsigned way, unsigned bit, uint32_t h3Column) {
+    const unsigned chunk = bit / setBits;  // 0 for the set bits (A1), 1 for the low tag bits (A2), ...
+    const unsigned y = 1u << (bit % setBits);
+    switch (type) {
+    case SkewHashType::Seznec: {
+        if (chunk > 1) {
+            // Only A1 and A2 are hashed
+            return 0;
+        }
+        const unsigned A1 = chunk == 0 ? y : 0;
+        const unsigned A2 = chunk == 1 ? y : 0;
+        switch (way & 0b11) {
+        case 0: return (H(A1, setBits) ^ RH(A2, setBits)) ^ A2;
+        case 1: return (H(A1, setBits) ^ RH(A2, setBits)) ^ A1;
+        case 2: return (RH(A1, setBits) ^ H(A2, setBits)) ^ A2;
+        default: return (RH(A1, setBits) ^ H(A2, setBits)) ^ A1;
+        }
+    }
+    case SkewHashType::H3: return chunk == 0 ? y : h3Column;
+    case SkewHashType::XorFold: return rotate(y, chunk * way, setBits);
+    }
+    return 0;
+}
+
+void SkewHash::configure(SkewHashType type, unsigned setBits, unsigned lineBits, unsigned ways) {
+    m_ways = ways;
+    m_setBits = setBits;
+    m_bytes = (lineBits + 7) / 8;
+    m_rows.assign(static_cast<size_t>(m_bytes) * 256 * ways, 0);
+    m_invertible = true;
+    m_inverse.assign(static_cast<size_t>(setBits) * ways, 0);
+    if (setBits == 0) {
+        // A single set; every line maps to set 0
+        return;
+    }
+
+    std::mt19937 rng(s_h3Seed);
+    const unsigned setMask = setBits >= 32 ? static_cast<unsigned>(-1) : (1u << setBits) - 1;
+    std::vector<unsigned> contributions(lineBits);
+    using Pair = std::pair<unsigned, uint32_t>;  // (P(x), x)
+    std::vector<Pair> pairs(setBits);
+    for (unsigned way = 0; way < ways; way++) {
+        for (unsigned bit = 0; bit < lineBits; bit++) {
+            contributions[bit] = contribution(type, setBits, way, bit, rng() & setMask);
+        }
+
+        // Gauss-Jordan elimination of the pairs (P(e_bit), e_bit) over GF(2), leaving (e_bit, P^-1(e_bit)) in pair bit
+        for (unsigned bit = 0; bit < setBits; bit++) {
+            pairs[bit] = {contributions[bit], 1u << bit};
+        }
+        for (unsigned bit = 0; bit < setBits && m_invertible; bit++) {
+            const auto pivot =
+                std::find_if(pairs.begin() + bit, pairs.end(), [bit](const Pair& p) { return (p.first >> bit) & 1; });
+            if (pivot == pairs.end()) {
+                m_invertible = false;
+                break;
+            }
+            std::swap(pairs[bit], *pivot);
+            for (unsigned other = 0; other < setBits; other++) {
+                if (other != bit && ((pairs[other].first >> bit) & 1)) {
+                    pairs[other].first ^= pairs[bit].first;
+                    pairs[other].second ^= pairs[bit].second;
+                }
+            }
+        }
+        for (unsigned bit = 0; bit < setBits; bit++) {
+            m_inverse[way * setBits + bit] = pairs[bit].second;
+        }
+        for (unsigned byte = 0; byte < m_bytes; byte++) {
+            for (unsigned value = 1; value < 256; value++) {
+                // The row of value is that of value without its lowest set bit, plus the contribution of the bit
+                const unsigned bit = byte * 8 + __builtin_ctz(value);
+                const unsigned rest = m_rows[(byte * 256 + (value & (value - 1))) * ways + way];
+                m_rows[(byte * 256 + value) * ways + way] = rest ^ (bit < lineBits ? contributions[bit] : 0);
+            }
+        }
+    }
+}
+
+}  // namespace Ripes
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace Ripes {
+
+/**
+ * @brief The SkewHashType enum
+ * Families of per-way set index functions of a skewed-associative cache (see SkewHash):
+ * - Seznec: the four functions f0..f3 of Seznec's skewed-associative cache, built from the H and RH bit permutations of
+ *   the set bits (A1) and the set-sized low tag bits (A2) of the line. Ways beyond the fourth reuse f0..f3.
+ * - H3: the set bits XOR'ed with an H3 hash of the tag bits; a random binary matrix per way, drawn from a fixed seed
+ *   such that runs are reproducible.
+ * - XorFold: the tag bits folded onto the set bits in set-sized chunks, chunk k being rotated by k * way bits. Ways are
+ *   distinct up to the number of set bits.
+ */
+enum class SkewHashType { Seznec, H3, XorFold };
+
+/**
+ * @brief The SkewHash class
+ * The per-way set index functions of a skewed-associative cache, applied to the line number of an address (the address
+ * without its block and byte offsets). Every family is linear over GF(2) and of the form set(way) = P(A1) ^ G(T), with
+ * A1 the set bits of the line number and T the bits above them. Whenever P is a bijection in every way (which holds for
+ * all families given at least two set bits), the line number may be recovered from its set index in a way and T, such
+ * that a skewed cache need only store T as its tag (see line()).
+ *
+ * Being linear, each function is the XOR of the contributions of the individual bits of the line number. configure()
+ * folds these into byte-sliced tables holding the contributions of every way side by side, such that indices()
+ * computes the set of every way at once by XOR-ing one table row per byte of the line number.
+ */
+class SkewHash {
+public:
+    /**
+     * @brief configure
+     * Builds the tables of the @p type family for @p ways ways, @p setBits set index bits and line numbers of
+     * @p lineBits bits.
+     */
+    void configure(SkewHashType type, unsigned setBits, unsigned lineBits, unsigned ways);
+
+    unsigned ways() const { return m_ways; }
+
+    /**
+     * @brief invertible
+     * True if P is a bijection in every way, such that line() may be used.
+     */
+    bool invertible() const { return m_invertible; }
+
+    /**
+     * @brief indices
+     * Writes the set index of @p line in every way to @p sets, which must hold ways() entries.
+     */
+    void indices(uint32_t line, unsigned* sets) const {
+        for (unsigned way = 0; way < m_ways; way++) {
+            sets[way] = 0;
+        }
+        for (unsigned byte = 0; byte < m_bytes; byte++) {
+            const unsigned* row = &m_rows[(byte * 256 + ((line >> (8 * byte)) & 0xff)) * m_ways];
+            for (unsigned way = 0; way < m_ways; way++) {
+                sets[way] ^= row[way];
+            }
+        }
+    }
+
+    /**
+     * @brief index
+     * The set index of @p line in @p way.
+     */
+    unsigned index(unsigned way, uint32_t line) const {
+        unsigned set = 0;
+        for (unsigned byte = 0; byte < m_bytes; byte++) {
+            set ^= m_rows[(byte * 256 + ((line >> (8 * byte)) & 0xff)) * m_ways + way];
+        }
+        return set;
+    }
+
+    /**
+     * @brief line
+     * Recovers the line number whose bits above the set bits are @p tag, and whose set index in @p way is @p set, as
+     * T | P^-1(set ^ G(T)). Requires invertible().
+     */
+    uint32_t line(unsigned way, unsigned set, uint32_t tag) const {
+        const uint32_t high = tag << m_setBits;
+        unsigned image = set ^ index(way, high);
+        uint32_t low = 0;
+        for (; image != 0; image &= image - 1) {
+            low ^= m_inverse[way * m_setBits + __builtin_ctz(image)];
+        }
+        return high | low;
+    }
+
+private:
+    /**
+     * @brief contribution
+     * The set index of the line number with only @p bit set, in @p way.
+     */
+    static unsigned contribution(SkewHashType type, unsigned setBits, unsigned way, unsigned bit, uint32_t h3Column);
+
+    unsigned m_ways = 0;
+    unsigned m_setBits = 0;
+    unsigned m_bytes = 0;  // Bytes of the line number covered by the tables
+    bool m_invertible = true;
+    // Column bit of P^-1 for every way: the set bits of the line number mapping to set index bit
+    std::vector<uint32_t> m_inverse;
+    // Row (byte, value) holds the XOR of the contributions of the bits of value, at byte of the line number, per way
+    std::vector<unsigned> m_rows;
+};
+
+}  // namespace Ripes
@@ -0,0 +1,140 @@
+#include "cachesweep.h"
+
+#include <algorithm>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace Ripes {
+
+namespace {
+
+struct WorkQueue {
+    std::mutex lock;
+    std::deque<size_t> tasks;
+};
+
+bool popTask(WorkQueue& queue, size_t& task, bool steal) {
+    std::lock_guard<std::mutex> guard(queue.lock);
+    if (queue.tasks.empty()) {
+        return false;
+    }
+    if (steal) {
+        task = queue.tasks.back();
+        queue.tasks.pop_back();
+    } else {
+        task = queue.tasks.front();
+        queue.tasks.pop_front();
+    }
+    return true;
+}
+
+}  // namespace
+
+void parallelFor(size_t count, unsigned threads, const std::function<void(size_t)>& task) {
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    threads = static_cast<unsigned>(std::min<size_t>(threads, count));
+    if (threads <= 1) {
+        for (size_t i = 0; i < count; i++) {
+            task(i);
+        }
+        return;
+    }
+
+    // Deal out contiguous ranges of tasks; no tasks are added once the workers have started, so a worker may stop as
+    // soon as it fails to find work in any queue.
+    std::vector<WorkQueue> queues(threads);
+    for (unsigned w = 0; w < threads; w++) {
+        for (size_t i = count * w / threads; i < count * (w + 1) / threads; i++) {
+            queues[w].tasks.push_back(i);
+        }
+    }
+
+    std::mutex errorLock;
+    std::exception_ptr error;
+    auto worker = [&](unsigned self) {
+        size_t idx;
+        while (true) {
+            bool found = popTask(queues[self], idx, false);
+            for (unsigned v = 1; !found && v < threads; v++) {
+                found = popTask(queues[(self + v) % threads], idx, true);
+            }
+            if (!found) {
+                return;
+            }
+            try {
+                task(idx);
+            } catch (...) {
+                std::lock_guard<std::mutex> guard(errorLock);
+                if (!error) {
+                    error = std::current_exception();
+                }
+            }
+        }
+    };
+
+    std::vector<std::thread> pool;
+    pool.reserve(threads);
+    for (unsigned w = 0; w < threads; w++) {
+        pool.emplace_back(worker, w);
+    }
+    for (auto& thread : pool) {
+        thread.join();
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+std::vector<SweepResult> runSweep(const std::vector<TraceRecord>& trace,
+                                  const std::vector<CacheEngine::CachePreset>& presets, CacheEngine::CacheType type,
+                                  unsigned threads, const CacheEngine::CacheLatency& latency,
+                                  PrefetcherType prefetcher, unsigned victimEntries,
+                                  const CacheEngine::WriteBufferConfig& writeBuffer,
+                                  const CacheEngine::SectorConfig& sectors,
+                                  const CacheEngine::SetDuelingConfig& dueling) {
+    const bool instrCache = type == CacheEngine::CacheType::InstrCache;
+    // The OPT policy requires the access stream up front; it is shared by all OPT configurations
+    std::shared_ptr<std::vector<uint32_t>> accessStream;
+    if (std::any_of(presets.begin(), presets.end(), [](const CacheEngine::CachePreset& preset) {
+            return preset.replPolicy == CacheEngine::ReplPolicy::OPT;
+        })) {
+        accessStream = std::make_shared<std::vector<uint32_t>>();
+        for (const auto& record : trace) {
+            if (record.isInstr == instrCache) {
+                accessStream->push_back(record.address);
+            }
+        }
+    }
+
+    std::vector<SweepResult> results(presets.size());
+    parallelFor(presets.size(), threads, [&](size_t idx) {
+        CacheEngine engine;
+        engine.setType(type);
+        engine.setPreset(presets[idx]);
+        engine.setLatency(latency);
+        engine.setSetDueling(dueling);
+        engine.setPrefetcher(makePrefetcher(prefetcher));
+        engine.setVictimBuffer(victimEntries);
+        engine.setWriteBuffer(writeBuffer);
+        engine.setSectoring(sectors);
+        if (presets[idx].replPolicy == CacheEngine::ReplPolicy::OPT) {
+            engine.setFutureAccesses(accessStream);
+        }
+        for (const auto& record : trace) {
+            if (record.isInstr == instrCache) {
+                engine.access(record.address, record.type, nullptr, record.pc);
+            }
+        }
+        results[idx].preset = presets[idx];
+        results[idx].stats = engine.getStatistics();
+        results[idx].sizeBits = engine.getCacheSize().bits;
+    });
+    return results;
+}
+
+}  // namespace Ripes
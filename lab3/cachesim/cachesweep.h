@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+#include "cacheengine.h"
+#include "cachetrace.h"
+
+namespace Ripes {
+
+/**
+ * @brief parallelFor
+ * Runs @p task for every index in [0, count) on @p threads worker threads (0 selects the number of hardware threads).
+ * Indices are dealt out to per-worker queues up front; a worker which runs dry steals from the back of the queue of
+ * another worker, such that tasks of uneven cost still keep all workers busy. Returns once all tasks have completed.
+ */
+void parallelFor(size_t count, unsigned threads, const std::function<void(size_t)>& task);
+
+/**
+ * @brief The SweepResult struct
+ * Outcome of replaying a trace through a single configuration of a design-space sweep.
+ */
+struct SweepResult {
+    CacheEngine::CachePreset preset;
+    CacheEngine::CacheStatistics stats;
+    unsigned sizeBits = 0;
+};
+
+/**
+ * @brief runSweep
+ * Replays @p trace through an independent CacheEngine of type @p type for each of @p presets, in parallel. The trace
+ * is shared read-only between all workers, and every engine uses the timing given by @p latency, a prefetcher of
+ * type @p prefetcher, a victim buffer of @p victimEntries lines, the write buffer given by @p writeBuffer, the
+ * sectoring given by @p sectors and the set dueling parameters given by @p dueling. Results are returned in the order
+ * of @p presets.
+ */
+std::vector<SweepResult> runSweep(const std::vector<TraceRecord>& trace,
+                                  const std::vector<CacheEngine::CachePreset>& presets, CacheEngine::CacheType type,
+                                  unsigned threads = 0, const CacheEngine::CacheLatency& latency = {},
+                                  PrefetcherType prefetcher = PrefetcherType::None, unsigned victimEntries = 0,
+                                  const CacheEngine::WriteBufferConfig& writeBuffer = {},
+                                  const CacheEngine::SectorConfig& sectors = {},
+                                  const CacheEngine::SetDuelingConfig& dueling = {});
+
+}  // namespace Ripes
@@ -0,0 +1,248 @@
+#include "cachetrace.h"
+
+#include <cstring>
+
+namespace Ripes {
+
+namespace {
+
+constexpr size_t s_bufferSize = 1 << 20;
+
+uint64_t readLE(const char* p, unsigned bytes) {
+    uint64_t v = 0;
+    for (unsigned i = 0; i < bytes; i++) {
+        v |= static_cast<uint64_t>(static_cast<uint8_t>(p[i])) << (8 * i);
+    }
+    return v;
+}
+
+bool isSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+/**
+ * Parses a hexadecimal number of at most 32 bits, with an optional 0x prefix, at @p p, up to the next space or @p end.
+ * Advances @p p past the number. @returns false if the number is malformed.
+ */
+bool parseHex(const char*& p, const char* end, uint32_t& value) {
+    if (end - p > 2 && p[0] == '0' && (p[1] == 'x' || p[1] == 'X')) {
+        p += 2;
+    }
+    uint64_t v = 0;
+    const char* start = p;
+    while (p < end && !isSpace(*p)) {
+        const char c = *p++;
+        unsigned digit;
+        if (c >= '0' && c <= '9') {
+            digit = c - '0';
+        } else if (c >= 'a' && c <= 'f') {
+            digit = c - 'a' + 10;
+        } else if (c >= 'A' && c <= 'F') {
+            digit = c - 'A' + 10;
+        } else {
+            return false;
+        }
+        v = (v << 4) | digit;
+        if (v > UINT32_MAX) {
+            return false;
+        }
+    }
+    value = static_cast<uint32_t>(v);
+    return p != start;
+}
+
+}  // namespace
+
+constexpr char TraceReader::s_binaryMagic[];
+
+TraceReader::~TraceReader() {
+    close();
+}
+
+bool TraceReader::open(const std::string& path) {
+    close();
+    m_file = std::fopen(path.c_str(), "rb");
+    if (m_file == nullptr) {
+        m_error = "Could not open trace file '" + path + "'";
+        return false;
+    }
+    m_buffer.resize(s_bufferSize);
+    refill();
+
+    const size_t magicLen = sizeof(s_binaryMagic) - 1;
+    m_binary = m_len >= magicLen && std::memcmp(m_buffer.data(), s_binaryMagic, magicLen) == 0;
+    if (m_binary) {
+        m_pos = magicLen;
+    }
+    return true;
+}
+
+void TraceReader::close() {
+    if (m_file) {
+        std::fclose(m_file);
+        m_file = nullptr;
+    }
+    m_pos = 0;
+    m_len = 0;
+    m_eof = false;
+    m_recordsRead = 0;
+    m_line = 0;
+    m_error.clear();
+}
+
+bool TraceReader::refill() {
+    // Move any unconsumed bytes to the front of the buffer before reading more
+    const size_t remaining = m_len - m_pos;
+    std::memmove(m_buffer.data(), m_buffer.data() + m_pos, remaining);
+    m_pos = 0;
+    m_len = remaining;
+    if (!m_eof) {
+        const size_t n = std::fread(m_buffer.data() + m_len, 1, m_buffer.size() - m_len, m_file);
+        m_len += n;
+        m_eof = n == 0;
+    }
+    return m_len > remaining;
+}
+
+bool TraceReader::next(TraceRecord& record) {
+    if (m_file == nullptr) {
+        return false;
+    }
+    const bool ok = m_binary ? nextBinary(record) : nextText(record);
+    if (ok) {
+        m_recordsRead++;
+    }
+    return ok;
+}
+
+bool TraceReader::nextBinary(TraceRecord& record) {
+    if (m_len - m_pos < s_binaryRecordSize) {
+        refill();
+        if (m_len - m_pos < s_binaryRecordSize) {
+            if (m_len != m_pos) {
+                m_error = "Truncated record at end of binary trace";
+            }
+            return false;
+        }
+    }
+    const char* p = m_buffer.data() + m_pos;
+    m_pos += s_binaryRecordSize;
+
+    record.cycle = readLE(p, 8);
+    record.address = static_cast<uint32_t>(readLE(p + 8, 4));
+    const uint8_t kind = static_cast<uint8_t>(p[12]);
+    if (kind > 2) {
+        m_error = "Invalid access kind in binary record " + std::to_string(m_recordsRead);
+        return false;
+    }
+    record.type = kind == 1 ? CacheEngine::AccessType::Write : CacheEngine::AccessType::Read;
+    record.isInstr = kind == 2;
+    record.pc = record.isInstr ? record.address : Prefetcher::s_noPc;
+    return true;
+}
+
+bool TraceReader::nextText(TraceRecord& record) {
+    while (true) {
+        const char* begin = m_buffer.data() + m_pos;
+        const char* end = static_cast<const char*>(std::memchr(begin, '\n', m_len - m_pos));
+        if (end == nullptr) {
+            if (refill()) {
+                continue;
+            }
+            if (m_pos == m_len) {
+                return false;
+            }
+            // Final line without a trailing newline
+            begin = m_buffer.data() + m_pos;
+            end = m_buffer.data() + m_len;
+        }
+        m_pos = end - m_buffer.data() + (end < m_buffer.data() + m_len ? 1 : 0);
+        m_line++;
+
+        const char* p = begin;
+        while (p < end && isSpace(*p)) {
+            p++;
+        }
+        if (p == end || *p == '#') {
+            continue;
+        }
+
+        // Cycle
+        uint64_t cycle = 0;
+        const char* start = p;
+        while (p < end && *p >= '0' && *p <= '9') {
+            cycle = cycle * 10 + (*p++ - '0');
+        }
+        bool valid = p != start && p < end && isSpace(*p);
+        while (p < end && isSpace(*p)) {
+            p++;
+        }
+
+        // Kind
+        const char kind = p < end ? *p++ : '\0';
+        valid &= (kind == 'R' || kind == 'W' || kind == 'I' || kind == 'r' || kind == 'w' || kind == 'i');
+        while (p < end && isSpace(*p)) {
+            p++;
+        }
+
+        // Address, and optionally the pc
+        uint32_t address = 0;
+        valid &= parseHex(p, end, address);
+        while (p < end && isSpace(*p)) {
+            p++;
+        }
+        uint32_t pc = Prefetcher::s_noPc;
+        if (valid && p < end) {
+            valid &= parseHex(p, end, pc);
+        }
+
+        if (!valid) {
+            m_error = "Malformed trace record on line " + std::to_string(m_line);
+            return false;
+        }
+
+        record.cycle = cycle;
+        record.address = address;
+        record.type = (kind == 'W' || kind == 'w') ? CacheEngine::AccessType::Write : CacheEngine::AccessType::Read;
+        record.isInstr = kind == 'I' || kind == 'i';
+        record.pc = record.isInstr ? address : pc;
+        return true;
+    }
+}
+
+std::vector<TraceRecord> TraceReader::readAll() {
+    std::vector<TraceRecord> records;
+    TraceRecord record;
+    while (next(record)) {
+        records.push_back(record);
+    }
+    return records;
+}
+
+uint64_t replayTrace(TraceReader& reader, CacheEngine& engine) {
+    const bool instrCache = engine.getCacheType() == CacheEngine::CacheType::InstrCache;
+    uint64_t replayed = 0;
+    TraceRecord record;
+    while (reader.next(record)) {
+        if (record.isInstr != instrCache) {
+            continue;
+        }
+        engine.access(record.address, record.type, nullptr, record.pc);
+        replayed++;
+    }
+    return replayed;
+}
+
+std::vector<uint32_t> readAccessStream(TraceReader& reader, CacheEngine::CacheType type) {
+    const bool instrCache = type == CacheEngine::CacheType::InstrCache;
+    std::vector<uint32_t> addresses;
+    TraceRecord record;
+    while (reader.next(record)) {
+        if (record.isInstr == instrCache) {
+            addresses.push_back(record.address);
+        }
+    }
+    return addresses;
+}
+
+}  // namespace Ripes
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "cacheengine.h"
+
+namespace Ripes {
+
+/**
+ * @brief The TraceRecord struct
+ * A single memory access of a recorded workload.
+ */
+struct TraceRecord {
+    uint64_t cycle = 0;
+    uint32_t address = 0;
+    CacheEngine::AccessType type = CacheEngine::AccessType::Read;
+    bool isInstr = false;  // True if the record is an instruction fetch
+    uint32_t pc = Prefetcher::s_noPc;  // Address of the accessing instruction, if recorded
+};
+
+/**
+ * @brief The TraceReader class
+ * Streams TraceRecords from a trace file. Two formats are accepted, and the format is detected from the file contents:
+ *
+ * Text: one access per line, as "<cycle> <kind> <address> [<pc>]" where kind is R (read), W (write) or I (instruction
+ * fetch), and address and the optional pc of the accessing instruction are given in hexadecimal (with or without a 0x
+ * prefix). Empty lines and lines starting with '#' are ignored.
+ *
+ * Binary: the 8-byte magic "RCTRACE1", followed by 16-byte little-endian records of
+ * {uint64 cycle, uint32 address, uint8 kind, 3 bytes padding}, where kind is 0 (read), 1 (write) or 2 (fetch). Binary
+ * records carry no pc.
+ *
+ * Records are read through a large buffer, such that traces far larger than the host memory may be replayed.
+ */
+class TraceReader {
+public:
+    static constexpr char s_binaryMagic[] = "RCTRACE1";
+    static constexpr unsigned s_binaryRecordSize = 16;
+
+    TraceReader() = default;
+    ~TraceReader();
+    TraceReader(const TraceReader&) = delete;
+    TraceReader& operator=(const TraceReader&) = delete;
+
+    /**
+     * @brief open
+     * Opens the trace file at @p path. @returns false and sets errorString() if the file could not be opened.
+     */
+    bool open(const std::string& path);
+    void close();
+
+    /**
+     * @brief next
+     * Reads the next record into @p record. @returns false once the trace is exhausted or a malformed record is
+     * encountered; in the latter case, errorString() is set.
+     */
+    bool next(TraceRecord& record);
+
+    /**
+     * @brief readAll
+     * Reads all remaining records of the trace into memory.
+     */
+    std::vector<TraceRecord> readAll();
+
+    bool isBinary() const { return m_binary; }
+    uint64_t recordsRead() const { return m_recordsRead; }
+    const std::string& errorString() const { return m_error; }
+
+private:
+    bool nextBinary(TraceRecord& record);
+    bool nextText(TraceRecord& record);
+    bool refill();
+
+    std::FILE* m_file = nullptr;
+    bool m_binary = false;
+    std::vector<char> m_buffer;
+    size_t m_pos = 0;
+    size_t m_len = 0;
+    bool m_eof = false;
+    uint64_t m_recordsRead = 0;
+    uint64_t m_line = 0;
+    std::string m_error;
+};
+
+/**
+ * @brief replayTrace
+ * Feeds all records of @p reader which match the type of @p engine (instruction fetches for an instruction cache, reads
+ * and writes for a data cache) through the engine. @returns the number of records replayed.
+ */
+uint64_t replayTrace(TraceReader& reader, CacheEngine& engine);
+
+/**
+ * @brief readAccessStream
+ * Reads the addresses of all remaining records of @p reader which replayTrace() would feed to a cache of type @p type,
+ * in order. This is the future access stream required by the OPT policy (see CacheEngine::setFutureAccesses()).
+ */
+std::vector<uint32_t> readAccessStream(TraceReader& reader, CacheEngine::CacheType type);
+
+}  // namespace Ripes
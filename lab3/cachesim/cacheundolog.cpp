@@ -0,0 +1,80 @@
+#include "cacheundolog.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace Ripes {
+
+namespace {
+// Records allocated per access by reset(); an access records more than one only when prefetching
+constexpr unsigned s_recordsPerAccess = 2;
+}  // namespace
+
+void CacheUndoLog::reset(unsigned capacity, unsigned maskWords, unsigned setWays) {
+    m_capacity = capacity;
+    m_maskWords = maskWords;
+    m_setWays = setWays;
+    const size_t slots = static_cast<size_t>(capacity) * s_recordsPerAccess;
+    m_records.assign(slots, Record());
+    m_masks.assign(slots * maskWords, 0);
+    m_validMasks.assign(slots * maskWords, 0);
+    m_setCounters.assign(slots * setWays, 0);
+    clear();
+}
+
+CacheUndoLog::Record& CacheUndoLog::push() {
+    assert(m_capacity > 0 && "Undo log was not allocated");
+    const bool accessStart = m_accessPending || m_accesses == 0;
+    m_accessPending = false;
+    if (accessStart) {
+        if (m_accesses == m_capacity) {
+            discardOldestAccess();
+        }
+        m_accesses++;
+    }
+    if (m_size == slots()) {
+        grow();
+    }
+    m_size++;
+    Record& record = m_records[backIdx()];
+    record = Record();
+    record.accessStart = accessStart;
+    return record;
+}
+
+void CacheUndoLog::pop() {
+    assert(m_size > 0 && "Cannot pop from an empty undo log");
+    m_accesses -= back().accessStart ? 1 : 0;
+    m_size--;
+}
+
+void CacheUndoLog::discardOldestAccess() {
+    do {
+        m_tail = (m_tail + 1) % slots();
+        m_size--;
+    } while (m_size > 0 && !m_records[m_tail].accessStart);
+    m_accesses--;
+}
+
+void CacheUndoLog::grow() {
+    // Unroll the ring into storage of twice the size, oldest record first
+    const unsigned newSlots = std::max(1u, 2 * slots());
+    std::vector<Record> records(newSlots);
+    std::vector<uint64_t> masks(static_cast<size_t>(newSlots) * m_maskWords, 0);
+    std::vector<uint64_t> validMasks(static_cast<size_t>(newSlots) * m_maskWords, 0);
+    std::vector<unsigned> setCounters(static_cast<size_t>(newSlots) * m_setWays, 0);
+    for (unsigned i = 0; i < m_size; i++) {
+        const unsigned from = (m_tail + i) % slots();
+        records[i] = m_records[from];
+        std::copy_n(&m_masks[from * m_maskWords], m_maskWords, &masks[i * m_maskWords]);
+        std::copy_n(&m_validMasks[from * m_maskWords], m_maskWords, &validMasks[i * m_maskWords]);
+        std::copy_n(&m_setCounters[from * m_setWays], m_setWays, &setCounters[i * m_setWays]);
+    }
+    m_records.swap(records);
+    m_masks.swap(masks);
+    m_validMasks.swap(validMasks);
+    m_setCounters.swap(setCounters);
+    m_tail = 0;
+}
+
+}  // namespace Ripes
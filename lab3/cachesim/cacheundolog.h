@@ -0,0 +1,119 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "cacheengine.h"
+
+namespace Ripes {
+
+/**
+ * @brief The CacheUndoLog class
+ * Ring buffer of the changes performed by the most recent cache accesses, replayed in reverse by CacheEngine::undo().
+ * Each record holds the transaction and the prior state of the fields of the accessed entry which the access may have
+ * modified. An access records its demand transaction followed by its prefetch fills, if any, and the records of an
+ * access are kept and discarded as a whole: the log holds the records of up to capacity() complete accesses. The dirty
+ * mask of an evicted line and, in sectored caches, the sector valid mask of the accessed entry are the only
+ * variable-sized parts of a record; space for these is preallocated per record, and they are only written when needed.
+ * Policies which update the counters of a whole set additionally have these counters recorded, in space of their own.
+ *
+ * reset() allocates records for a couple of records per access. Once all accesses are held, beginning another one
+ * discards the oldest; the record storage only grows if the accesses held require more records than allocated.
+ */
+class CacheUndoLog {
+public:
+    struct Record {
+        CacheEngine::CacheTransaction transaction;
+        uint32_t oldTag = 0;
+        unsigned oldCounter = 0;
+        uint8_t oldFlags = 0;        // CacheStorage::Flags of the entry prior to the access
+        bool allocated = false;      // A line was loaded into the entry; the old entry is restored from the record
+        bool blockWasClean = false;  // The access set the dirty bit of the accessed block
+        bool setWriteback = false;   // The access counted as a writeback of its set (see CacheEngine::SetStatistics)
+        bool accessStart = false;    // The first record of an access (see beginAccess())
+        ReplUpdate replUpdate;       // Policy state changed along with the replacement fields
+
+        // The victim buffer slot modified by the access, if any, and its prior entry
+        unsigned victimSlot = VictimBuffer::s_noSlot;
+        VictimBuffer::Entry oldVictim;
+        // The position of the write buffer prior to the access, if enabled, and the slot modified by the access, if any,
+        // with its prior entry
+        WriteBuffer::Position oldWriteBufferPosition;
+        unsigned writeBufferSlot = WriteBuffer::s_noSlot;
+        WriteBuffer::Entry oldWriteBufferEntry;
+        // The entries which received a relocated line, from the first level of the walk downwards; the first
+        // transaction.relocations entries are used. The accessed entry held the evicted line once relocated, and is
+        // recorded as such.
+        CacheEngine::CacheIndex relocationPath[CacheEngine::s_maxRelocationLevels];
+        // The changes of the access to the miss classifier, if classified
+        MissClassifier::Change missChange;
+    };
+
+    /**
+     * @brief reset
+     * Clears the log and allocates space for the records of @p capacity accesses, with dirty and valid masks of
+     * @p maskWords words, and the replacement counters of @p setWays ways (see CacheEngine::getUndoSetWays()).
+     */
+    void reset(unsigned capacity, unsigned maskWords, unsigned setWays = 0);
+    void clear() {
+        m_tail = 0;
+        m_size = 0;
+        m_accesses = 0;
+        m_accessPending = false;
+    }
+
+    unsigned capacity() const { return m_capacity; }
+    unsigned maskWords() const { return m_maskWords; }
+    unsigned setWays() const { return m_setWays; }
+    unsigned size() const { return m_size; }
+    unsigned accesses() const { return m_accesses; }
+    bool empty() const { return m_size == 0; }
+
+    /**
+     * @brief beginAccess
+     * Marks the next record pushed as the first record of a new access. If the log already holds capacity() accesses,
+     * the records of the oldest access are discarded at that point.
+     */
+    void beginAccess() { m_accessPending = true; }
+
+    /**
+     * @brief push
+     * @returns a reset record slot as the newest record of the log.
+     */
+    Record& push();
+    void pop();
+
+    Record& back() { return m_records[backIdx()]; }
+    const Record& back() const { return m_records[backIdx()]; }
+    /**
+     * @brief fromBack
+     * The record pushed @p i records before the newest one.
+     */
+    const Record& fromBack(unsigned i) const { return m_records[(backIdx() + slots() - i) % slots()]; }
+    uint64_t* backMask() { return &m_masks[backIdx() * m_maskWords]; }
+    const uint64_t* backMask() const { return &m_masks[backIdx() * m_maskWords]; }
+    uint64_t* backValidMask() { return &m_validMasks[backIdx() * m_maskWords]; }
+    const uint64_t* backValidMask() const { return &m_validMasks[backIdx() * m_maskWords]; }
+    unsigned* backSetCounters() { return &m_setCounters[backIdx() * m_setWays]; }
+    const unsigned* backSetCounters() const { return &m_setCounters[backIdx() * m_setWays]; }
+
+private:
+    unsigned slots() const { return m_records.size(); }
+    unsigned backIdx() const { return (m_tail + m_size - 1) % slots(); }
+    void discardOldestAccess();
+    void grow();
+
+    std::vector<Record> m_records;
+    std::vector<uint64_t> m_masks;
+    std::vector<uint64_t> m_validMasks;
+    std::vector<unsigned> m_setCounters;  // Empty unless setWays() != 0
+    unsigned m_capacity = 0;  // In accesses
+    unsigned m_maskWords = 1;
+    unsigned m_setWays = 0;
+    unsigned m_tail = 0;  // Slot of the oldest record
+    unsigned m_size = 0;
+    unsigned m_accesses = 0;
+    bool m_accessPending = false;
+};
+
+}  // namespace Ripes
@@ -0,0 +1,209 @@
+#include "stackdistance.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+
+namespace Ripes {
+
+namespace {
+constexpr unsigned s_minCapacity = 16;
+}
+
+unsigned RecencyFenwick::touch(uint32_t key) {
+    unsigned depth = s_beyondDepth;
+    auto it = m_timestamps.find(key);
+    if (it != m_timestamps.end()) {
+        const unsigned pos = it->second;
+        // Keys touched after 'key' hold the marks after its timestamp
+        const unsigned keyDepth = m_live - prefix(pos);
+        depth = keyDepth < m_maxDepth ? keyDepth : s_beyondDepth;
+        add(pos, -1);
+        m_keys[pos] = s_noKey;
+        m_live--;
+    }
+
+    if (m_next == m_keys.size()) {
+        compact();
+    }
+
+    m_keys[m_next] = key;
+    m_times[m_next] = m_touches++;
+    add(m_next, 1);
+    m_timestamps[key] = m_next;
+    m_next++;
+    m_live++;
+    return depth;
+}
+
+unsigned RecencyFenwick::recentKeys(uint64_t touches) const {
+    if (touches >= m_touches) {
+        return m_live;
+    }
+    // The live keys touched since are those marked at or after the first timestamp assigned since
+    const auto first = std::lower_bound(m_times.begin(), m_times.begin() + m_next, m_touches - touches);
+    const unsigned pos = first - m_times.begin();
+    return m_live - (pos == 0 ? 0 : prefix(pos - 1));
+}
+
+void RecencyFenwick::clear() {
+    m_live = 0;
+    m_next = 0;
+    m_touches = 0;
+    m_tree.clear();
+    m_keys.clear();
+    m_times.clear();
+    m_timestamps.clear();
+}
+
+void RecencyFenwick::add(unsigned pos, int delta) {
+    for (unsigned i = pos + 1; i < m_tree.size(); i += i & (~i + 1)) {
+        m_tree[i] += delta;
+    }
+}
+
+unsigned RecencyFenwick::prefix(unsigned pos) const {
+    unsigned sum = 0;
+    for (unsigned i = pos + 1; i > 0; i -= i & (~i + 1)) {
+        sum += m_tree[i];
+    }
+    return sum;
+}
+
+void RecencyFenwick::compact() {
+    // Gather the live keys in recency order (oldest first), dropping those too deep to be reported
+    std::vector<uint32_t> live;
+    std::vector<uint64_t> times;
+    live.reserve(m_live);
+    times.reserve(m_live);
+    for (unsigned pos = 0; pos < m_next; pos++) {
+        if (m_keys[pos] != s_noKey) {
+            live.push_back(m_keys[pos]);
+            times.push_back(m_times[pos]);
+        }
+    }
+    size_t first = 0;
+    if (live.size() > m_maxDepth) {
+        first = live.size() - m_maxDepth;
+        for (size_t i = 0; i < first; i++) {
+            m_timestamps.erase(live[i]);
+        }
+    }
+    const unsigned kept = live.size() - first;
+
+    unsigned capacity = m_keys.empty() ? s_minCapacity : m_keys.size();
+    while (capacity < 2 * (kept + 1)) {
+        capacity *= 2;
+    }
+
+    // Renumber the kept keys from 0 and rebuild the tree in linear time
+    m_keys.assign(capacity, s_noKey);
+    m_times.assign(capacity, 0);
+    m_tree.assign(capacity + 1, 0);
+    for (unsigned i = 0; i < kept; i++) {
+        const uint32_t key = live[first + i];
+        m_keys[i] = key;
+        m_times[i] = times[first + i];
+        m_timestamps[key] = i;
+        m_tree[i + 1] = 1;
+    }
+    for (unsigned i = 1; i <= capacity; i++) {
+        const unsigned parent = i + (i & (~i + 1));
+        if (parent <= capacity) {
+            m_tree[parent] += m_tree[i];
+        }
+    }
+    m_live = kept;
+    m_next = kept;
+}
+
+StackDistanceProfiler::StackDistanceProfiler(unsigned blockBits, unsigned maxSetBits, unsigned maxWayBits) {
+    reset(blockBits, maxSetBits, maxWayBits);
+}
+
+void StackDistanceProfiler::reset(unsigned blockBits, unsigned maxSetBits, unsigned maxWayBits) {
+    m_blockBits = blockBits;
+    m_maxSetBits = maxSetBits;
+    m_maxWayBits = maxWayBits;
+    m_accesses = 0;
+
+    const unsigned maxWays = 1u << maxWayBits;
+    m_stacks.clear();
+    m_histograms.clear();
+    for (unsigned setBits = 0; setBits <= maxSetBits; setBits++) {
+        m_stacks.emplace_back(1u << setBits, RecencyFenwick(maxWays));
+        // One bucket per depth, and a final bucket for accesses which miss in every profiled geometry
+        m_histograms.emplace_back(maxWays + 1, 0);
+    }
+}
+
+void StackDistanceProfiler::access(uint32_t address) {
+    const uint32_t line = address >> (2 /*byte offset*/ + m_blockBits);
+    const unsigned maxWays = 1u << m_maxWayBits;
+    for (unsigned setBits = 0; setBits <= m_maxSetBits; setBits++) {
+        const unsigned setIdx = line & ((1u << setBits) - 1);
+        const unsigned depth = m_stacks[setBits][setIdx].touch(line);
+        m_histograms[setBits][depth == RecencyFenwick::s_beyondDepth ? maxWays : depth]++;
+    }
+    m_accesses++;
+}
+
+uint64_t StackDistanceProfiler::hits(unsigned setBits, unsigned wayBits) const {
+    assert(setBits <= m_maxSetBits && wayBits <= m_maxWayBits && "Geometry was not profiled");
+    const auto& histogram = m_histograms[setBits];
+    uint64_t hits = 0;
+    for (unsigned depth = 0; depth < (1u << wayBits); depth++) {
+        hits += histogram[depth];
+    }
+    return hits;
+}
+
+double StackDistanceProfiler::hitRate(unsigned setBits, unsigned wayBits) const {
+    return m_accesses == 0 ? 0 : static_cast<double>(hits(setBits, wayBits)) / m_accesses;
+}
+
+ReuseProfiler::ReuseProfiler(unsigned maxBlockBits, unsigned window, unsigned maxDistanceBits) {
+    reset(maxBlockBits, window, maxDistanceBits);
+}
+
+void ReuseProfiler::reset(unsigned maxBlockBits, unsigned window, unsigned maxDistanceBits) {
+    assert(window > 0 && "Working set window must not be empty");
+    m_maxBlockBits = maxBlockBits;
+    m_window = window;
+    m_maxDistanceBits = maxDistanceBits;
+    m_accesses = 0;
+
+    m_stacks.assign(maxBlockBits + 1, RecencyFenwick(1u << maxDistanceBits));
+    // One bucket per power of two of the distance, along with distance 0 and a final bucket for cold accesses
+    m_histograms.assign(maxBlockBits + 1, std::vector<uint64_t>(maxDistanceBits + 2, 0));
+    m_workingSets.assign(maxBlockBits + 1, std::vector<unsigned>());
+}
+
+void ReuseProfiler::access(uint32_t address) {
+    m_accesses++;
+    const bool windowDone = m_accesses % m_window == 0;
+    for (unsigned blockBits = 0; blockBits <= m_maxBlockBits; blockBits++) {
+        RecencyFenwick& stack = m_stacks[blockBits];
+        const unsigned distance = stack.touch(address >> (2 /*byte offset*/ + blockBits));
+        unsigned bucket = m_maxDistanceBits + 1;
+        if (distance != RecencyFenwick::s_beyondDepth) {
+            bucket = distance == 0 ? 0 : 32 - __builtin_clz(distance);
+        }
+        m_histograms[blockBits][bucket]++;
+        if (windowDone) {
+            m_workingSets[blockBits].push_back(stack.recentKeys(m_window));
+        }
+    }
+}
+
+uint64_t ReuseProfiler::hits(unsigned blockBits, unsigned capacityBits) const {
+    assert(blockBits <= m_maxBlockBits && capacityBits <= m_maxDistanceBits && "Capacity was not profiled");
+    const auto& histogram = m_histograms[blockBits];
+    uint64_t hits = 0;
+    for (unsigned bucket = 0; bucket <= capacityBits; bucket++) {
+        hits += histogram[bucket];
+    }
+    return hits;
+}
+
+}  // namespace Ripes
@@ -0,0 +1,176 @@
+#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace Ripes {
+
+/**
+ * @brief The RecencyFenwick class
+ * Tracks the recency order of a set of keys, and reports the LRU stack depth of a key (the number of distinct other
+ * keys touched since the key was last touched) in logarithmic time.
+ *
+ * Every touch assigns the key the next timestamp. A Fenwick tree over the timestamps marks the timestamp currently
+ * held by each live key, such that the depth of a key is the number of marks after its timestamp. When the timestamps
+ * are exhausted the structure is compacted; keys deeper than @p maxDepth are dropped at that point, given that they
+ * can only be reported as being at least maxDepth deep. The touch count at which each timestamp was assigned is kept
+ * alongside, such that the keys touched within a recent number of touches may be counted the same way.
+ */
+class RecencyFenwick {
+public:
+    static constexpr unsigned s_beyondDepth = static_cast<unsigned>(-1);
+
+    explicit RecencyFenwick(unsigned maxDepth = 1024) : m_maxDepth(maxDepth) {}
+
+    /**
+     * @brief touch
+     * Moves @p key to the top of the recency stack. @returns the depth of @p key prior to the touch, or s_beyondDepth
+     * if the key has not been touched before or is deeper than maxDepth.
+     */
+    unsigned touch(uint32_t key);
+
+    /**
+     * @brief recentKeys
+     * @returns the number of distinct keys touched within the most recent @p touches touches, in logarithmic time.
+     * Counts of at least maxDepth may be too low, given that compaction drops keys deeper than maxDepth.
+     */
+    unsigned recentKeys(uint64_t touches) const;
+
+    void clear();
+    unsigned size() const { return m_live; }
+
+private:
+    static constexpr uint32_t s_noKey = static_cast<uint32_t>(-1);
+
+    void add(unsigned pos, int delta);
+    unsigned prefix(unsigned pos) const;
+    void compact();
+
+    unsigned m_maxDepth;
+    unsigned m_live = 0;
+    unsigned m_next = 0;
+    uint64_t m_touches = 0;
+    std::vector<uint32_t> m_tree;   // Fenwick tree over timestamps, 1-indexed
+    std::vector<uint32_t> m_keys;   // Key holding each timestamp, or s_noKey
+    std::vector<uint64_t> m_times;  // Touch count at which each timestamp was assigned, in increasing order
+    std::unordered_map<uint32_t, uint32_t> m_timestamps;
+};
+
+/**
+ * @brief The StackDistanceProfiler class
+ * Single-pass (Mattson) profiling of LRU caches. For a fixed block size, the profiler records the LRU stack depth of
+ * every access within its set, for all power-of-two set counts at once. Given that LRU is a stack algorithm, an access
+ * hits in a cache of 2^w ways iff its depth is below 2^w, so the resulting histograms give the hit and miss counts of
+ * every sets x ways geometry without re-running the workload.
+ *
+ * The model matches a CacheEngine configured with ReplPolicy::LRU, write-allocate and a non-skewed organization.
+ */
+class StackDistanceProfiler {
+public:
+    StackDistanceProfiler(unsigned blockBits = 0, unsigned maxSetBits = 10, unsigned maxWayBits = 10);
+
+    /**
+     * @brief reset
+     * Clears all recorded accesses and reconfigures the profiler. Geometry arguments are log2 values, as for
+     * CacheEngine.
+     */
+    void reset(unsigned blockBits, unsigned maxSetBits, unsigned maxWayBits);
+    void reset() { reset(m_blockBits, m_maxSetBits, m_maxWayBits); }
+
+    void access(uint32_t address);
+
+    uint64_t accesses() const { return m_accesses; }
+    uint64_t hits(unsigned setBits, unsigned wayBits) const;
+    uint64_t misses(unsigned setBits, unsigned wayBits) const { return m_accesses - hits(setBits, wayBits); }
+    double hitRate(unsigned setBits, unsigned wayBits) const;
+
+    /**
+     * @brief histogram
+     * Number of accesses seen at each stack depth for a cache of 2^setBits sets. The final bucket counts cold accesses
+     * and accesses deeper than the largest number of ways profiled.
+     */
+    const std::vector<uint64_t>& histogram(unsigned setBits) const { return m_histograms.at(setBits); }
+
+    unsigned getBlockBits() const { return m_blockBits; }
+    unsigned getMaxSetBits() const { return m_maxSetBits; }
+    unsigned getMaxWayBits() const { return m_maxWayBits; }
+
+private:
+    unsigned m_blockBits = 0;
+    unsigned m_maxSetBits = 0;
+    unsigned m_maxWayBits = 0;
+    uint64_t m_accesses = 0;
+
+    // Indexed by [setBits][set]
+    std::vector<std::vector<RecencyFenwick>> m_stacks;
+    // Indexed by [setBits][depth]
+    std::vector<std::vector<uint64_t>> m_histograms;
+};
+
+/**
+ * @brief The ReuseProfiler class
+ * Profiles the locality of an access stream independently of any cache, for all power-of-two block sizes up to a
+ * maximum at once. For each block size, the profiler records:
+ * - the reuse distance of every access: the number of distinct other blocks touched since the block was last touched.
+ *   Distances are kept in log2 buckets; given that a fully associative LRU cache of 2^c blocks hits iff the distance is
+ *   below 2^c, the histograms give the hit rate of every capacity.
+ * - the working set of every window of consecutive accesses: the number of distinct blocks touched within it.
+ *
+ * Both are computed by a RecencyFenwick per block size, in logarithmic time per access. Distances and working sets of
+ * at least 2^maxDistanceBits blocks are not told apart.
+ */
+class ReuseProfiler {
+public:
+    ReuseProfiler(unsigned maxBlockBits = 4, unsigned window = 1024, unsigned maxDistanceBits = 16);
+
+    /**
+     * @brief reset
+     * Clears all recorded accesses and reconfigures the profiler. Block sizes are log2 values in words, as for
+     * CacheEngine, and @p window is the number of accesses of a working set window.
+     */
+    void reset(unsigned maxBlockBits, unsigned window, unsigned maxDistanceBits);
+    void reset() { reset(m_maxBlockBits, m_window, m_maxDistanceBits); }
+
+    void access(uint32_t address);
+
+    uint64_t accesses() const { return m_accesses; }
+
+    /**
+     * @brief histogram
+     * Number of accesses per reuse distance bucket for blocks of 2^blockBits words. Bucket 0 counts distance 0, bucket
+     * k in [1, maxDistanceBits] distances in [2^(k-1), 2^k), and the final bucket cold accesses and accesses at
+     * distances of at least 2^maxDistanceBits.
+     */
+    const std::vector<uint64_t>& histogram(unsigned blockBits) const { return m_histograms.at(blockBits); }
+
+    /**
+     * @brief hits
+     * Hits of a fully associative LRU cache of 2^capacityBits blocks of 2^blockBits words, @p capacityBits being at
+     * most maxDistanceBits.
+     */
+    uint64_t hits(unsigned blockBits, unsigned capacityBits) const;
+
+    /**
+     * @brief workingSets
+     * Distinct blocks of 2^blockBits words touched within each completed window of accesses, in order.
+     */
+    const std::vector<unsigned>& workingSets(unsigned blockBits) const { return m_workingSets.at(blockBits); }
+
+    unsigned getMaxBlockBits() const { return m_maxBlockBits; }
+    unsigned getWindow() const { return m_window; }
+    unsigned getMaxDistanceBits() const { return m_maxDistanceBits; }
+
+private:
+    unsigned m_maxBlockBits = 0;
+    unsigned m_window = 0;
+    unsigned m_maxDistanceBits = 0;
+    uint64_t m_accesses = 0;
+
+    // Indexed by [blockBits]
+    std::vector<RecencyFenwick> m_stacks;
+    std::vector<std::vector<uint64_t>> m_histograms;
+    std::vector<std::vector<unsigned>> m_workingSets;
+};
+
+}  // namespace Ripes
@@ -0,0 +1,743 @@
+/**
+ * cachetool
+ * Headless driver for the cache engine of the cache simulator. Replays a recorded access trace (see
+ * cachesim/cachetrace.h for the accepted formats) through a single cache configuration and prints the resulting
+ * statistics. With --sweep, the trace is instead run through a stack-distance profiler, and the LRU hit rate of every
+ * sets x ways geometry at the given block size is printed. With --configs, the trace is loaded once and replayed through
+ * every configuration listed in the given file in parallel, printing one row of statistics per configuration. With any
+ * of --l1i/--l1d/--l2/--l3, instruction fetches and data accesses are replayed through a multi-level hierarchy instead.
+ * Configurations using the offline OPT policy first read the trace an additional time, to learn its access stream.
+ * With --prefetch, a prefetcher is attached to the cache (or the L1 caches of a hierarchy), and its statistics are
+ * printed along with the cache statistics. Likewise, --victim attaches a victim buffer and --write-buffer a write
+ * buffer, and --sectored makes the cache sectored. --relocate turns a skewed cache into a z-cache. --set-stats writes
+ * the access counters of every set of a single cache to a CSV file, from which the load of the sets may be plotted.
+ * --classify-misses splits the misses into compulsory, capacity and conflict misses. With --reuse, the trace is run
+ * through a reuse-distance profiler instead, printing the fully associative LRU hit rate of every capacity and the
+ * working set sizes for every block size up to --blocks.
+ * The tool links against the Qt-free sources of cachesim only:
+ *   cacheengine.cpp cacheundolog.cpp cache_policy_object.cpp cachetrace.cpp stackdistance.cpp cachesweep.cpp
+ *   cachehierarchy.cpp cacheprefetcher.cpp cacheskewhash.cpp cachemissclass.cpp
+ */
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+
+#include "../cachesim/cacheengine.h"
+#include "../cachesim/cachehierarchy.h"
+#include "../cachesim/cachesweep.h"
+#include "../cachesim/cachetrace.h"
+#include "../cachesim/stackdistance.h"
+
+using namespace Ripes;
+
+namespace {
+
+const std::map<std::string, CacheEngine::ReplPolicy> s_replPolicies{{"random", CacheEngine::ReplPolicy::Random},
+                                                                    {"lru", CacheEngine::ReplPolicy::LRU},
+                                                                    {"lru_lip", CacheEngine::ReplPolicy::LRU_LIP},
+                                                                    {"plru", CacheEngine::ReplPolicy::PLRU},
+                                                                    {"dip", CacheEngine::ReplPolicy::DIP},
+                                                                    {"srrip", CacheEngine::ReplPolicy::SRRIP},
+                                                                    {"brrip", CacheEngine::ReplPolicy::BRRIP},
+                                                                    {"drrip", CacheEngine::ReplPolicy::DRRIP},
+                                                                    {"opt", CacheEngine::ReplPolicy::OPT}};
+
+const std::map<std::string, SkewHashType> s_skewHashes{
+    {"seznec", SkewHashType::Seznec}, {"h3", SkewHashType::H3}, {"xorfold", SkewHashType::XorFold}};
+
+const std::map<std::string, PrefetcherType> s_prefetchers{{"none", PrefetcherType::None},
+                                                          {"nextline", PrefetcherType::NextLine},
+                                                          {"stride", PrefetcherType::Stride},
+                                                          {"stream", PrefetcherType::Stream}};
+
+void printUsage(const char* argv0) {
+    std::cerr << "Usage: " << argv0 << " [options] <trace file>\n"
+              << "Options (geometry is given as log2 values, as in the cache configuration widget):\n"
+              << "  --blocks <n>           2^n words per cache line (default 0)\n"
+              << "  --sets <n>             2^n sets (default 3)\n"
+              << "  --ways <n>             2^n ways (default 2)\n"
+              << "  --repl <policy>        random|lru|lru_lip|plru|dip|srrip|brrip|drrip|opt\n"
+              << "                         (default lru)\n"
+              << "  --write-through        use a write-through policy (default write-back)\n"
+              << "  --no-write-allocate    do not allocate on write misses\n"
+              << "  --skewed               use a skewed-associative organization\n"
+              << "  --skew-hash <family>   seznec|h3|xorfold: per-way index functions of a skewed cache\n"
+              << "                         (default seznec)\n"
+              << "  --relocate <levels>    relocate lines of a skewed cache over up to <levels> levels (at most "
+              << CacheEngine::s_maxRelocationLevels << ")\n"
+              << "                         on a miss, as a z-cache\n"
+              << "  --icache               replay instruction fetches instead of data accesses\n"
+              << "  --sweep                print LRU hit rates for all sets x ways geometries up to --sets x --ways\n"
+              << "  --reuse <window>       print fully associative LRU hit rates by capacity, and the working set\n"
+              << "                         of every <window> accesses, for all block sizes up to --blocks\n"
+              << "  --configs <file>       replay the trace through every configuration in <file>, one per line as\n"
+              << "                         '<blocks> <sets> <ways> <repl> [wb|wt] [wa|nwa] [skewed[=<family>]]\n"
+              << "                         [zcache=<levels>]'\n"
+              << "  --threads <n>          number of worker threads for --configs (default: all cores)\n"
+              << "  --l1i/--l1d <spec>     L1 instruction/data cache of a hierarchy, with <spec> as for --configs\n"
+              << "                         (default: the cache given by the options above)\n"
+              << "  --l2/--l3 <spec>       shared levels of a hierarchy; <spec> as for --configs, optionally followed\n"
+              << "                         by 'inclusive', 'exclusive' or 'nine' (non-inclusive, the default) and\n"
+              << "                         'hit=<n>' (hit latency of the level, in cycles)\n"
+              << "  --latency <h>,<m>,<w>  hit latency, miss penalty and writeback penalty in cycles (default\n"
+              << "                         1,10,10); in a hierarchy, the hit latency of levels without 'hit=<n>'\n"
+              << "  --mem-latency <r>,<w>  main memory read and write latency of a hierarchy (default 100,100)\n"
+              << "  --dueling <l>,<p>,<t>  leader sets per policy, PSEL bits and bimodal throttle of dip, brrip and\n"
+              << "                         drrip (default 32,10,32)\n"
+              << "  --rrpv-bits <m>        width of the re-reference prediction value of srrip, brrip and drrip\n"
+              << "                         (1 to 8, default 2)\n"
+              << "  --prefetch <type>      none|nextline|stride|stream (default none); stride requires the pc of\n"
+              << "                         data accesses in the trace\n"
+              << "  --victim <n>           attach a victim buffer of n lines to the cache (or the L1 caches of a\n"
+              << "                         hierarchy)\n"
+              << "  --write-buffer <d>,<c> attach a write buffer of d entries (at most 16), draining one entry every\n"
+              << "                         c cycles, to the cache (or the L1 caches of a hierarchy)\n"
+              << "  --no-read-bypass       read misses wait for the write buffer to drain\n"
+              << "  --sectored <n>         give each block of a line a valid bit of its own, fetching the missing\n"
+              << "                         block and up to n blocks following it on a miss (the cache, or the L1\n"
+              << "                         caches of a hierarchy)\n"
+              << "  --set-stats <file>     write the accesses, misses, evictions and writebacks of every set of the\n"
+              << "                         cache to <file>, as CSV\n"
+              << "  --classify-misses      classify the misses of the cache (or of every level of a hierarchy) as\n"
+              << "                         compulsory, capacity or conflict misses\n";
+}
+
+bool parseUnsigned(const char* str, unsigned& value) {
+    char* end = nullptr;
+    const unsigned long v = std::strtoul(str, &end, 10);
+    if (end == str || *end != '\0') {
+        return false;
+    }
+    value = static_cast<unsigned>(v);
+    return true;
+}
+
+/**
+ * Parses a comma-separated list of exactly @p count unsigned values.
+ */
+bool parseUnsignedList(const std::string& str, unsigned count, std::vector<unsigned>& values) {
+    values.clear();
+    std::istringstream stream(str);
+    std::string item;
+    unsigned value = 0;
+    while (std::getline(stream, item, ',')) {
+        if (!parseUnsigned(item.c_str(), value)) {
+            return false;
+        }
+        values.push_back(value);
+    }
+    return values.size() == count;
+}
+
+const char* replPolicyName(CacheEngine::ReplPolicy policy) {
+    for (const auto& it : s_replPolicies) {
+        if (it.second == policy) {
+            return it.first.c_str();
+        }
+    }
+    return "?";
+}
+
+const char* skewHashName(SkewHashType hash) {
+    for (const auto& it : s_skewHashes) {
+        if (it.second == hash) {
+            return it.first.c_str();
+        }
+    }
+    return "?";
+}
+
+bool parseConfigLine(const std::string& line, CacheEngine::CachePreset& preset) {
+    std::istringstream stream(line);
+    std::string repl;
+    if (!(stream >> preset.blocks >> preset.sets >> preset.ways >> repl) || !s_replPolicies.count(repl)) {
+        return false;
+    }
+    preset.replPolicy = s_replPolicies.at(repl);
+    std::string option;
+    unsigned value = 0;
+    while (stream >> option) {
+        if (option == "wb" || option == "wt") {
+            preset.wrPolicy = option == "wb" ? CacheEngine::WritePolicy::WriteBack : CacheEngine::WritePolicy::WriteThrough;
+        } else if (option == "wa" || option == "nwa") {
+            preset.wrAllocPolicy = option == "wa" ? CacheEngine::WriteAllocPolicy::WriteAllocate
+                                                  : CacheEngine::WriteAllocPolicy::NoWriteAllocate;
+        } else if (option == "skewed") {
+            preset.skewPolicy = CacheEngine::SkewedAssocPolicy::Skewed;
+        } else if (option.rfind("skewed=", 0) == 0 && s_skewHashes.count(option.substr(7))) {
+            preset.skewPolicy = CacheEngine::SkewedAssocPolicy::Skewed;
+            preset.skewHash = s_skewHashes.at(option.substr(7));
+        } else if (option.rfind("zcache=", 0) == 0 && parseUnsigned(option.c_str() + 7, value) &&
+                   value <= CacheEngine::s_maxRelocationLevels) {
+            preset.relocationLevels = value;
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool readConfigs(const std::string& path, std::vector<CacheEngine::CachePreset>& presets) {
+    std::ifstream file(path);
+    if (!file) {
+        std::cerr << "Could not open configuration file '" << path << "'\n";
+        return false;
+    }
+    std::string line;
+    unsigned lineNumber = 0;
+    while (std::getline(file, line)) {
+        lineNumber++;
+        const size_t first = line.find_first_not_of(" \t\r");
+        if (first == std::string::npos || line[first] == '#') {
+            continue;
+        }
+        CacheEngine::CachePreset preset;
+        if (!parseConfigLine(line, preset)) {
+            std::cerr << "Malformed configuration on line " << lineNumber << " of '" << path << "'\n";
+            return false;
+        }
+        presets.push_back(preset);
+    }
+    return true;
+}
+
+int runConfigs(TraceReader& reader, const std::vector<CacheEngine::CachePreset>& presets, CacheEngine::CacheType type,
+               unsigned threads, const CacheEngine::CacheLatency& latency, PrefetcherType prefetcher,
+               unsigned victimEntries, const CacheEngine::WriteBufferConfig& writeBuffer,
+               const CacheEngine::SectorConfig& sectors, const CacheEngine::SetDuelingConfig& dueling) {
+    const std::vector<TraceRecord> trace = reader.readAll();
+    if (!reader.errorString().empty()) {
+        std::cerr << reader.errorString() << "\n";
+        return 1;
+    }
+
+    const auto results =
+        runSweep(trace, presets, type, threads, latency, prefetcher, victimEntries, writeBuffer, sectors, dueling);
+    const bool prefetching = prefetcher != PrefetcherType::None;
+    const bool relocating = std::any_of(presets.begin(), presets.end(), [](const CacheEngine::CachePreset& preset) {
+        return preset.relocationLevels != 0 && preset.skewPolicy == CacheEngine::SkewedAssocPolicy::Skewed;
+    });
+
+    std::cout << "blocks\tsets\tways\trepl\twrite\talloc\tskewed\tbits\thits\tmisses\twritebacks\thitrate\tamat"
+              << (prefetching ? "\tprefetches\tuseful\tlate\tpolluting" : "")
+              << (victimEntries != 0 ? "\tvictimhits" : "")
+              << (writeBuffer.depth != 0 ? "\tcoalesced\tdrains\tbufferstalls\tforwards" : "")
+              << (sectors.enabled ? "\tsectormisses\tfetched" : "")
+              << (relocating ? "\tzcache\trelocations\n" : "\n");
+    for (const auto& result : results) {
+        const auto& p = result.preset;
+        std::cout << (1 << p.blocks) << "\t" << (1 << p.sets) << "\t" << (1 << p.ways) << "\t"
+                  << replPolicyName(p.replPolicy) << "\t"
+                  << (p.wrPolicy == CacheEngine::WritePolicy::WriteBack ? "wb" : "wt") << "\t"
+                  << (p.wrAllocPolicy == CacheEngine::WriteAllocPolicy::WriteAllocate ? "wa" : "nwa") << "\t"
+                  << (p.skewPolicy == CacheEngine::SkewedAssocPolicy::Skewed ? skewHashName(p.skewHash) : "no") << "\t"
+                  << result.sizeBits
+                  << "\t" << result.stats.hits << "\t" << result.stats.misses << "\t" << result.stats.writebacks << "\t"
+                  << result.stats.hitRate() << "\t" << result.stats.amat();
+        if (prefetching) {
+            std::cout << "\t" << result.stats.prefetches << "\t" << result.stats.usefulPrefetches << "\t"
+                      << result.stats.latePrefetches << "\t" << result.stats.pollutingPrefetches;
+        }
+        if (victimEntries != 0) {
+            std::cout << "\t" << result.stats.victimHits;
+        }
+        if (writeBuffer.depth != 0) {
+            std::cout << "\t" << result.stats.coalescedWrites << "\t" << result.stats.bufferDrains << "\t"
+                      << result.stats.bufferStallCycles << "\t" << result.stats.bufferForwards;
+        }
+        if (sectors.enabled) {
+            std::cout << "\t" << result.stats.sectorMisses << "\t" << result.stats.fetchedBlocks;
+        }
+        if (relocating) {
+            std::cout << "\t" << p.relocationLevels << "\t" << result.stats.relocations;
+        }
+        std::cout << "\n";
+    }
+    return 0;
+}
+
+const std::map<std::string, CacheHierarchy::InclusionPolicy> s_inclusionPolicies{
+    {"nine", CacheHierarchy::InclusionPolicy::NonInclusive},
+    {"inclusive", CacheHierarchy::InclusionPolicy::Inclusive},
+    {"exclusive", CacheHierarchy::InclusionPolicy::Exclusive}};
+
+bool parseLevelSpec(std::string spec, CacheEngine::CachePreset& preset, CacheHierarchy::InclusionPolicy& inclusion,
+                    unsigned& hitLatency) {
+    inclusion = CacheHierarchy::InclusionPolicy::NonInclusive;
+    // Trailing 'hit=<n>' and inclusion policy options, in any order
+    while (true) {
+        const size_t last = spec.find_last_of(" \t");
+        if (last == std::string::npos) {
+            break;
+        }
+        const std::string option = spec.substr(last + 1);
+        unsigned value = 0;
+        if (s_inclusionPolicies.count(option)) {
+            inclusion = s_inclusionPolicies.at(option);
+        } else if (option.rfind("hit=", 0) == 0 && parseUnsigned(option.c_str() + 4, value) && value > 0) {
+            hitLatency = value;
+        } else {
+            break;
+        }
+        spec.erase(last);
+    }
+    return parseConfigLine(spec, preset);
+}
+
+void printLevel(const std::string& name, const CacheEngine& cache) {
+    const auto& stats = cache.getStatistics();
+    std::cout << name << "\t" << stats.reads << "\t" << stats.writes << "\t" << stats.hits << "\t" << stats.misses
+              << "\t" << stats.writebacks << "\t" << stats.hitRate() << "\t" << cache.getLatency().hitLatency << "\n";
+}
+
+void printPrefetchStatistics(const std::string& prefix, const CacheEngine& cache) {
+    if (cache.getPrefetcher() == nullptr) {
+        return;
+    }
+    const auto& stats = cache.getStatistics();
+    std::cout << prefix << "Prefetches: " << stats.prefetches << " (useful " << stats.usefulPrefetches << ", late "
+              << stats.latePrefetches << ", polluting " << stats.pollutingPrefetches << ")\n";
+}
+
+void printVictimStatistics(const std::string& prefix, const CacheEngine& cache) {
+    if (cache.getVictimBufferEntries() == 0) {
+        return;
+    }
+    std::cout << prefix << "Victim hits: " << cache.getStatistics().victimHits << " (" << cache.getVictimBufferEntries()
+              << " entries)\n";
+}
+
+void printWriteBufferStatistics(const std::string& prefix, const CacheEngine& cache) {
+    if (cache.getWriteBufferConfig().depth == 0) {
+        return;
+    }
+    const auto& stats = cache.getStatistics();
+    std::cout << prefix << "Write buffer: " << stats.bufferDrains << " drains (coalesced " << stats.coalescedWrites
+              << ", stalls " << stats.bufferStallCycles << " cycles, forwards " << stats.bufferForwards << ")\n";
+}
+
+void printSectorStatistics(const std::string& prefix, const CacheEngine& cache) {
+    if (!cache.getSectoring().enabled) {
+        return;
+    }
+    const auto& stats = cache.getStatistics();
+    std::cout << prefix << "Sector misses: " << stats.sectorMisses << " (tag misses "
+              << stats.misses - stats.sectorMisses << ", fetched " << stats.fetchedBlocks << " blocks)\n";
+}
+
+void printRelocationStatistics(const std::string& prefix, const CacheEngine& cache) {
+    const auto& stats = cache.getStatistics();
+    if (cache.getRelocationLevels() == 0 || stats.relocationWalks == 0) {
+        return;
+    }
+    std::cout << prefix << "Relocation walks: " << stats.relocationWalks << " (candidates "
+              << static_cast<double>(stats.walkCandidates) / stats.relocationWalks << " per walk, relocations "
+              << stats.relocations << ")\n"
+              << prefix << "Relocation depths:";
+    for (unsigned depth = 0; depth <= cache.getRelocationLevels(); depth++) {
+        std::cout << " " << depth << ":" << stats.relocationDepths[depth];
+    }
+    std::cout << "\n";
+}
+
+void printMissClassStatistics(const std::string& prefix, const CacheEngine& cache) {
+    if (!cache.getMissClassification()) {
+        return;
+    }
+    const auto& stats = cache.getStatistics();
+    std::cout << prefix << "Miss classes: compulsory " << stats.compulsoryMisses << ", capacity "
+              << stats.capacityMisses << ", conflict " << stats.conflictMisses << "\n";
+}
+
+bool writeSetStatistics(const std::string& path, const CacheEngine& cache) {
+    std::ofstream file(path);
+    if (!file) {
+        std::cerr << "Could not open set statistics file '" << path << "'\n";
+        return false;
+    }
+    file << "set,accesses,misses,evictions,writebacks\n";
+    const auto& sets = cache.getSetStatistics();
+    for (size_t set = 0; set < sets.size(); set++) {
+        file << set << "," << sets[set].accesses << "," << sets[set].misses << "," << sets[set].evictions << ","
+             << sets[set].writebacks << "\n";
+    }
+    return true;
+}
+
+/**
+ * Provides @p engine with the access stream of the trace at @p path, if it uses the OPT policy.
+ */
+bool setupOracle(const std::string& path, CacheEngine& engine) {
+    if (engine.getReplacementPolicy() != CacheEngine::ReplPolicy::OPT) {
+        return true;
+    }
+    TraceReader reader;
+    if (!reader.open(path)) {
+        std::cerr << reader.errorString() << "\n";
+        return false;
+    }
+    auto stream = std::make_shared<std::vector<uint32_t>>(readAccessStream(reader, engine.getCacheType()));
+    if (!reader.errorString().empty()) {
+        std::cerr << reader.errorString() << "\n";
+        return false;
+    }
+    engine.setFutureAccesses(std::move(stream));
+    return true;
+}
+
+int runHierarchy(TraceReader& reader, CacheHierarchy& hierarchy) {
+    uint64_t replayed = 0;
+    TraceRecord record;
+    while (reader.next(record)) {
+        hierarchy.access(record.address, record.type, record.isInstr, record.pc);
+        replayed++;
+    }
+    if (!reader.errorString().empty()) {
+        std::cerr << reader.errorString() << "\n";
+        return 1;
+    }
+
+    std::cout << "Accesses: " << replayed << "\n"
+              << "level\treads\twrites\thits\tmisses\twritebacks\thitrate\thitlat\n";
+    printLevel("L1I", hierarchy.getL1I());
+    printLevel("L1D", hierarchy.getL1D());
+    for (unsigned i = 0; i < hierarchy.getLevelCount(); i++) {
+        printLevel("L" + std::to_string(i + 2), hierarchy.getLevel(i));
+    }
+    const auto& memory = hierarchy.getMemoryStatistics();
+    std::cout << "Memory reads: " << memory.reads << "\n"
+              << "Memory writes: " << memory.writes << "\n"
+              << "Back-invalidations: " << memory.backInvalidations << "\n"
+              << "AMAT: " << hierarchy.getAMAT() << " cycles\n";
+    printPrefetchStatistics("L1I ", hierarchy.getL1I());
+    printPrefetchStatistics("L1D ", hierarchy.getL1D());
+    printVictimStatistics("L1I ", hierarchy.getL1I());
+    printVictimStatistics("L1D ", hierarchy.getL1D());
+    printWriteBufferStatistics("L1I ", hierarchy.getL1I());
+    printWriteBufferStatistics("L1D ", hierarchy.getL1D());
+    printSectorStatistics("L1I ", hierarchy.getL1I());
+    printSectorStatistics("L1D ", hierarchy.getL1D());
+    printRelocationStatistics("L1I ", hierarchy.getL1I());
+    printRelocationStatistics("L1D ", hierarchy.getL1D());
+    for (unsigned i = 0; i < hierarchy.getLevelCount(); i++) {
+        printRelocationStatistics("L" + std::to_string(i + 2) + " ", hierarchy.getLevel(i));
+    }
+    printMissClassStatistics("L1I ", hierarchy.getL1I());
+    printMissClassStatistics("L1D ", hierarchy.getL1D());
+    for (unsigned i = 0; i < hierarchy.getLevelCount(); i++) {
+        printMissClassStatistics("L" + std::to_string(i + 2) + " ", hierarchy.getLevel(i));
+    }
+    return 0;
+}
+
+int runSweep(TraceReader& reader, const CacheEngine::CachePreset& preset, bool instrCache) {
+    StackDistanceProfiler profiler(preset.blocks, preset.sets, preset.ways);
+    TraceRecord record;
+    while (reader.next(record)) {
+        if (record.isInstr == instrCache) {
+            profiler.access(record.address);
+        }
+    }
+    if (!reader.errorString().empty()) {
+        std::cerr << reader.errorString() << "\n";
+        return 1;
+    }
+
+    std::cout << "Accesses: " << profiler.accesses() << "\n"
+              << "LRU hit rate, " << (1 << preset.blocks) << " word(s) per line (rows: sets, columns: ways)\n"
+              << std::setw(6) << "";
+    for (int ways = 0; ways <= preset.ways; ways++) {
+        std::cout << std::setw(8) << (1 << ways);
+    }
+    std::cout << "\n" << std::fixed << std::setprecision(4);
+    for (int sets = 0; sets <= preset.sets; sets++) {
+        std::cout << std::setw(6) << (1 << sets);
+        for (int ways = 0; ways <= preset.ways; ways++) {
+            std::cout << std::setw(8) << profiler.hitRate(sets, ways);
+        }
+        std::cout << "\n";
+    }
+    return 0;
+}
+
+int runReuse(TraceReader& reader, unsigned maxBlockBits, unsigned window, bool instrCache) {
+    ReuseProfiler profiler(maxBlockBits, window);
+    TraceRecord record;
+    while (reader.next(record)) {
+        if (record.isInstr == instrCache) {
+            profiler.access(record.address);
+        }
+    }
+    if (!reader.errorString().empty()) {
+        std::cerr << reader.errorString() << "\n";
+        return 1;
+    }
+
+    std::cout << "Accesses: " << profiler.accesses() << "\n"
+              << "Fully associative LRU hit rate (rows: capacity in blocks, columns: words per block)\n"
+              << std::setw(8) << "";
+    for (unsigned blockBits = 0; blockBits <= maxBlockBits; blockBits++) {
+        std::cout << std::setw(8) << (1 << blockBits);
+    }
+    std::cout << "\n" << std::fixed << std::setprecision(4);
+    for (unsigned capacityBits = 0; capacityBits <= profiler.getMaxDistanceBits(); capacityBits++) {
+        std::cout << std::setw(8) << (1 << capacityBits);
+        for (unsigned blockBits = 0; blockBits <= maxBlockBits; blockBits++) {
+            const uint64_t hits = profiler.hits(blockBits, capacityBits);
+            const double hitRate = profiler.accesses() == 0 ? 0 : static_cast<double>(hits) / profiler.accesses();
+            std::cout << std::setw(8) << hitRate;
+        }
+        std::cout << "\n";
+    }
+
+    std::cout << "Working set per " << window << " accesses, in blocks (columns: words per block)\n" << std::setw(8)
+              << "";
+    for (unsigned blockBits = 0; blockBits <= maxBlockBits; blockBits++) {
+        std::cout << std::setw(8) << (1 << blockBits);
+    }
+    std::cout << "\n" << std::setprecision(1);
+    for (const bool mean : {true, false}) {
+        std::cout << std::setw(8) << (mean ? "mean" : "max");
+        for (unsigned blockBits = 0; blockBits <= maxBlockBits; blockBits++) {
+            const auto& sets = profiler.workingSets(blockBits);
+            uint64_t sum = 0;
+            unsigned max = 0;
+            for (const unsigned set : sets) {
+                sum += set;
+                max = std::max(max, set);
+            }
+            std::cout << std::setw(8) << (mean ? (sets.empty() ? 0 : static_cast<double>(sum) / sets.size()) : max);
+        }
+        std::cout << "\n";
+    }
+    return 0;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    CacheEngine::CachePreset preset;
+    preset.blocks = 0;
+    preset.sets = 3;
+    preset.ways = 2;
+    CacheEngine::CacheType type = CacheEngine::CacheType::DataCache;
+    bool sweep = false;
+    unsigned reuseWindow = 0;
+    std::string configPath;
+    std::string setStatsPath;
+    bool classifyMisses = false;
+    unsigned threads = 0;
+    CacheEngine::CacheLatency latency;
+    std::vector<unsigned> memoryLatency{100, 100};
+    CacheEngine::SetDuelingConfig dueling;
+    PrefetcherType prefetcher = PrefetcherType::None;
+    unsigned victimEntries = 0;
+    CacheEngine::WriteBufferConfig writeBuffer;
+    CacheEngine::SectorConfig sectors;
+    std::vector<unsigned> values;
+    // Hierarchy levels: L1I, L1D, L2, L3
+    const std::vector<std::string> levelOptions{"--l1i", "--l1d", "--l2", "--l3"};
+    std::vector<std::string> levelSpecs(levelOptions.size());
+    std::string tracePath;
+
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        unsigned value = 0;
+        if ((arg == "--blocks" || arg == "--sets" || arg == "--ways") && hasValue && parseUnsigned(argv[i + 1], value)) {
+            (arg == "--blocks" ? preset.blocks : arg == "--sets" ? preset.sets : preset.ways) = value;
+            i++;
+        } else if (arg == "--repl" && hasValue && s_replPolicies.count(argv[i + 1])) {
+            preset.replPolicy = s_replPolicies.at(argv[++i]);
+        } else if (arg == "--write-through") {
+            preset.wrPolicy = CacheEngine::WritePolicy::WriteThrough;
+        } else if (arg == "--no-write-allocate") {
+            preset.wrAllocPolicy = CacheEngine::WriteAllocPolicy::NoWriteAllocate;
+        } else if (arg == "--skewed") {
+            preset.skewPolicy = CacheEngine::SkewedAssocPolicy::Skewed;
+        } else if (arg == "--skew-hash" && hasValue && s_skewHashes.count(argv[i + 1])) {
+            preset.skewHash = s_skewHashes.at(argv[++i]);
+        } else if (arg == "--relocate" && hasValue && parseUnsigned(argv[i + 1], value) &&
+                   value <= CacheEngine::s_maxRelocationLevels) {
+            preset.relocationLevels = value;
+            i++;
+        } else if (arg == "--icache") {
+            type = CacheEngine::CacheType::InstrCache;
+        } else if (std::find(levelOptions.begin(), levelOptions.end(), arg) != levelOptions.end() && hasValue) {
+            levelSpecs[std::find(levelOptions.begin(), levelOptions.end(), arg) - levelOptions.begin()] = argv[++i];
+        } else if (arg == "--set-stats" && hasValue) {
+            setStatsPath = argv[++i];
+        } else if (arg == "--classify-misses") {
+            classifyMisses = true;
+        } else if (arg == "--configs" && hasValue) {
+            configPath = argv[++i];
+        } else if (arg == "--threads" && hasValue && parseUnsigned(argv[i + 1], threads)) {
+            i++;
+        } else if (arg == "--latency" && hasValue && parseUnsignedList(argv[i + 1], 3, values) && values[0] > 0) {
+            latency.hitLatency = values[0];
+            latency.missPenalty = values[1];
+            latency.writebackPenalty = values[2];
+            i++;
+        } else if (arg == "--dueling" && hasValue && parseUnsignedList(argv[i + 1], 3, values) && values[1] >= 1 &&
+                   values[1] <= 16) {
+            dueling.leaderSets = values[0];
+            dueling.pselBits = values[1];
+            dueling.bimodalThrottle = values[2];
+            i++;
+        } else if (arg == "--rrpv-bits" && hasValue && parseUnsigned(argv[i + 1], value) && value >= 1 &&
+                   value <= RripPolicy::s_maxRrpvBits) {
+            dueling.rrpvBits = value;
+            i++;
+        } else if (arg == "--prefetch" && hasValue && s_prefetchers.count(argv[i + 1])) {
+            prefetcher = s_prefetchers.at(argv[i + 1]);
+            i++;
+        } else if (arg == "--victim" && hasValue && parseUnsigned(argv[i + 1], victimEntries)) {
+            i++;
+        } else if (arg == "--write-buffer" && hasValue && parseUnsignedList(argv[i + 1], 2, values) &&
+                   values[0] <= WriteBuffer::s_maxDepth) {
+            writeBuffer.depth = values[0];
+            writeBuffer.drainCycles = values[1];
+            i++;
+        } else if (arg == "--no-read-bypass") {
+            writeBuffer.readBypass = false;
+        } else if (arg == "--sectored" && hasValue && parseUnsigned(argv[i + 1], sectors.neighbors)) {
+            sectors.enabled = true;
+            i++;
+        } else if (arg == "--mem-latency" && hasValue && parseUnsignedList(argv[i + 1], 2, memoryLatency)) {
+            i++;
+        } else if (arg == "--sweep") {
+            sweep = true;
+        } else if (arg == "--reuse" && hasValue && parseUnsigned(argv[i + 1], reuseWindow) && reuseWindow > 0) {
+            i++;
+        } else if (arg == "-h" || arg == "--help") {
+            printUsage(argv[0]);
+            return 0;
+        } else if (tracePath.empty() && arg.rfind("--", 0) != 0) {
+            tracePath = arg;
+        } else {
+            std::cerr << "Invalid argument: " << arg << "\n";
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (tracePath.empty()) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    std::vector<CacheEngine::CachePreset> presets;
+    if (!configPath.empty() && !readConfigs(configPath, presets)) {
+        return 1;
+    }
+
+    TraceReader reader;
+    if (!reader.open(tracePath)) {
+        std::cerr << reader.errorString() << "\n";
+        return 1;
+    }
+
+    if (!configPath.empty()) {
+        return runConfigs(reader, presets, type, threads, latency, prefetcher, victimEntries, writeBuffer, sectors,
+                          dueling);
+    }
+
+    if (std::any_of(levelSpecs.begin(), levelSpecs.end(), [](const std::string& spec) { return !spec.empty(); })) {
+        CacheHierarchy hierarchy;
+        hierarchy.setMemoryLatency(memoryLatency[0], memoryLatency[1]);
+        for (unsigned level = 0; level < levelSpecs.size(); level++) {
+            if (level >= 2 && levelSpecs[level].empty()) {
+                continue;
+            }
+            CacheEngine::CachePreset levelPreset = preset;
+            auto inclusion = CacheHierarchy::InclusionPolicy::NonInclusive;
+            CacheEngine::CacheLatency levelLatency = latency;
+            if (!levelSpecs[level].empty() &&
+                !parseLevelSpec(levelSpecs[level], levelPreset, inclusion, levelLatency.hitLatency)) {
+                std::cerr << "Invalid cache specification for " << levelOptions[level] << "\n";
+                return 1;
+            }
+            CacheEngine& cache = level == 0   ? hierarchy.getL1I()
+                                 : level == 1 ? hierarchy.getL1D()
+                                              : hierarchy.addLevel(inclusion);
+            cache.setPreset(levelPreset);
+            cache.setLatency(levelLatency);
+            cache.setSetDueling(dueling);
+            cache.setMissClassification(classifyMisses);
+            if (level < 2) {
+                cache.setPrefetcher(makePrefetcher(prefetcher));
+                cache.setVictimBuffer(victimEntries);
+                cache.setWriteBuffer(writeBuffer);
+                cache.setSectoring(sectors);
+            }
+            if (levelPreset.replPolicy == CacheEngine::ReplPolicy::OPT) {
+                // Only the L1 caches see a stream which is known up front
+                if (level >= 2) {
+                    std::cerr << "The opt policy is only supported in L1 caches\n";
+                    return 1;
+                }
+                if (!setupOracle(tracePath, cache)) {
+                    return 1;
+                }
+            }
+        }
+        return runHierarchy(reader, hierarchy);
+    }
+    if (sweep) {
+        return runSweep(reader, preset, type == CacheEngine::CacheType::InstrCache);
+    }
+    if (reuseWindow != 0) {
+        return runReuse(reader, preset.blocks, reuseWindow, type == CacheEngine::CacheType::InstrCache);
+    }
+
+    CacheEngine engine;
+    engine.setType(type);
+    engine.setPreset(preset);
+    engine.setLatency(latency);
+    engine.setSetDueling(dueling);
+    engine.setPrefetcher(makePrefetcher(prefetcher));
+    engine.setVictimBuffer(victimEntries);
+    engine.setWriteBuffer(writeBuffer);
+    engine.setSectoring(sectors);
+    engine.setSetProfiling(!setStatsPath.empty());
+    engine.setMissClassification(classifyMisses);
+    if (!setupOracle(tracePath, engine)) {
+        return 1;
+    }
+
+    const uint64_t replayed = replayTrace(reader, engine);
+    if (!reader.errorString().empty()) {
+        std::cerr << reader.errorString() << "\n";
+        return 1;
+    }
+
+    const auto& stats = engine.getStatistics();
+    std::cout << "Accesses:   " << replayed << "\n"
+              << "Reads:      " << stats.reads << "\n"
+              << "Writes:     " << stats.writes << "\n"
+              << "Hits:       " << stats.hits << "\n"
+              << "Misses:     " << stats.misses << "\n"
+              << "Writebacks: " << stats.writebacks << "\n"
+              << "Hit rate:   " << stats.hitRate() << "\n"
+              << "AMAT:       " << stats.amat() << " cycles\n"
+              << "Stalls:     " << stats.stallCycles() << " cycles\n"
+              << "Size:       " << engine.getCacheSize().bits << " bits\n";
+    printPrefetchStatistics("", engine);
+    printVictimStatistics("", engine);
+    printWriteBufferStatistics("", engine);
+    printSectorStatistics("", engine);
+    printRelocationStatistics("", engine);
+    printMissClassStatistics("", engine);
+    if (!setStatsPath.empty() && !writeSetStatistics(setStatsPath, engine)) {
+        return 1;
+    }
+    return 0;
+}